@@ -0,0 +1,44 @@
+#include "alloc.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Global 'operator new' is replaced only to count allocations, memory still comes from 'malloc'
+static std::atomic<uint64_t> allocations = 0;
+
+uint64_t GetAllocationCount()
+{
+	return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = malloc(size ? size : 1)) { return ptr; }
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	free(ptr);
+}
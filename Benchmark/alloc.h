@@ -0,0 +1,5 @@
+#pragma once
+#include <cstdint>
+
+// Gets number of heap allocations made through global 'operator new' so far, counted only in the benchmark
+uint64_t GetAllocationCount();
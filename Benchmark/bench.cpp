@@ -0,0 +1,258 @@
+#include <fmt/core.h>
+#include <bit>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "../Dumper/scanner.h"
+#include "../Dumper/pe.h"
+
+/*
+* Signature scanner and PE parsing benchmark.
+* Builds synthetic PE images, plants every signature near the end of the code section among near-miss decoys, then measures
+* the throughput of each scanner implementation, of the multi-pattern and parallel scans, of FindPointer and of section parsing.
+* Runs headless, exits with failure if anything finds something other than what was planted.
+* Usage: Benchmark [image size in MB]...
+*/
+
+static constexpr Pattern Signatures[] =
+{
+	Pattern("48 8B 05 ?? ?? ?? ?? 48 8B 0C C8 48 8D 04 D1 EB", 3),
+	Pattern("48 8B 0D ?? ?? ?? ?? 81 4C D1 08 00 00 00 40", 3),
+	Pattern("48 8D 1D ?? ?? ?? ?? 39 44 24 68", 3),
+	Pattern("48 8D 35 ?? ?? ?? ?? EB 16", 3),
+	// Wildcard-heavy patterns, most of the bytes are operands that change between builds
+	Pattern("48 89 5C 24 ?? 57 48 83 EC ?? 48 8B 05 ?? ?? ?? ?? 48 33 C4 48 89 44 24 ?? 48 8B ?? E8 ?? ?? ?? ??", 13),
+	Pattern("40 53 48 83 EC ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? ?? 5B C3"),
+};
+
+static constexpr uint32_t SectionAlignment = 0x1000;
+// Data sections that follow the code section, globals referenced by the planted signatures live there
+static constexpr uint32_t DataSize = 1 << 20;
+
+struct Random
+{
+	uint64_t State = 0x9E3779B97F4A7C15ull;
+	uint64_t Next() { State ^= State << 13; State ^= State >> 7; State ^= State << 17; return State; }
+};
+
+struct Image
+{
+	std::vector<uint8_t> Data;
+	uint32_t Text = 0;
+	uint32_t TextSize = 0;
+	// Offsets of the planted signatures from the start of the image, and addresses referenced by them
+	std::vector<size_t> Planted;
+	std::vector<size_t> Targets;
+};
+
+template<typename T>
+static void Put(std::vector<uint8_t>& data, size_t offset, T value)
+{
+	memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+// PE32+ headers with .text, .rdata and .data sections, enough for the loader view that the dumper parses
+static void WriteHeaders(Image& image, uint32_t textSize)
+{
+	auto& data = image.Data;
+	const struct { const char* Name; uint32_t Size; uint32_t Characteristics; } sections[] =
+	{
+		{ ".text", textSize, 0x60000020 },
+		{ ".rdata", DataSize, 0x40000040 },
+		{ ".data", DataSize, 0xC0000040 },
+	};
+	uint32_t nt = 0x80, optional = nt + 0x18, optionalSize = 0xF0, table = optional + optionalSize;
+	uint32_t address = SectionAlignment;
+	for (auto& section : sections) { address += (section.Size + SectionAlignment - 1) & ~(SectionAlignment - 1); }
+	data.assign(address, 0);
+
+	data[0] = 'M'; data[1] = 'Z';
+	Put<int32_t>(data, 0x3C, nt);
+	memcpy(data.data() + nt, "PE\0\0", 4);
+	Put<uint16_t>(data, nt + 0x4, 0x8664);
+	Put<uint16_t>(data, nt + 0x6, static_cast<uint16_t>(std::size(sections)));
+	Put<uint16_t>(data, nt + 0x14, static_cast<uint16_t>(optionalSize));
+	Put<uint16_t>(data, optional, 0x20B);
+	Put<uint32_t>(data, optional + 0x38, address);
+	Put<uint32_t>(data, optional + 0x3C, SectionAlignment);
+
+	address = SectionAlignment;
+	for (size_t i = 0; i < std::size(sections); i++)
+	{
+		auto header = table + i * 0x28;
+		memcpy(data.data() + header, sections[i].Name, strlen(sections[i].Name));
+		Put<uint32_t>(data, header + 0x8, sections[i].Size);
+		Put<uint32_t>(data, header + 0xC, address);
+		// Raw data offsets differ from virtual addresses on purpose, the parser has to ignore them
+		Put<uint32_t>(data, header + 0x10, sections[i].Size);
+		Put<uint32_t>(data, header + 0x14, 0x400 + address / 2);
+		Put<uint32_t>(data, header + 0x24, sections[i].Characteristics);
+		address += (sections[i].Size + SectionAlignment - 1) & ~(SectionAlignment - 1);
+	}
+	image.Text = SectionAlignment;
+	image.TextSize = textSize;
+}
+
+static void Plant(std::vector<uint8_t>& data, size_t offset, const Pattern& sig, Random& random)
+{
+	for (size_t i = 0; i < sig.Size; i++) { data[offset + i] = sig.Mask[i] ? sig.Value[i] : static_cast<uint8_t>(random.Next()); }
+}
+
+static Image GenerateImage(size_t size, Random& random)
+{
+	Image image;
+	auto textSize = static_cast<uint32_t>(size - 2 * DataSize);
+	WriteHeaders(image, textSize);
+	auto text = image.Data.data() + image.Text;
+
+	// Mostly common x64 opcode and ModRM bytes, so anchors show up about as often as in real code
+	static const uint8_t common[] = { 0x00, 0x00, 0x00, 0xFF, 0x48, 0x48, 0x8B, 0x8B, 0x89, 0xCC, 0x24, 0x0F, 0xE8, 0x4C, 0x8D, 0x44, 0x85, 0xC0, 0x08, 0x10, 0x83, 0x74, 0xEB, 0xC3 };
+	for (size_t i = 0; i < textSize; i += 8)
+	{
+		auto value = random.Next();
+		for (size_t j = 0; j < 8 && i + j < textSize; j++, value >>= 8)
+		{
+			auto byte = static_cast<uint8_t>(value);
+			text[i + j] = byte < 160 ? common[byte % sizeof(common)] : byte;
+		}
+	}
+
+	// Decoys take the signatures in turn and match everything except their last byte that isn't a wildcard
+	size_t decoys = 0;
+	for (size_t offset = 4096; offset + 64 < textSize; offset += 64 * 1024)
+	{
+		auto& sig = Signatures[decoys++ % std::size(Signatures)];
+		Plant(image.Data, image.Text + offset, sig, random);
+		image.Data[image.Text + offset + std::bit_width(sig.Care) - 1] ^= 0x5A;
+	}
+
+	// Every signature is planted once near the end, rel32 points into .data
+	auto data = image.Text + ((textSize + SectionAlignment - 1) & ~(SectionAlignment - 1)) + DataSize;
+	for (size_t i = 0; i < std::size(Signatures); i++)
+	{
+		auto& sig = Signatures[i];
+		size_t offset = image.Text + textSize - textSize / 20 + i * 4099;
+		Plant(image.Data, offset, sig, random);
+		size_t target = data + i * 64;
+		if (sig.Displacement != Pattern::NoDisplacement)
+		{
+			Put<int32_t>(image.Data, offset + sig.Displacement, static_cast<int32_t>(target - (offset + sig.Displacement + 4)));
+		}
+		image.Planted.push_back(offset);
+		image.Targets.push_back(target);
+	}
+	return image;
+}
+
+// Best time of a few runs, in seconds
+template<typename Fn>
+static double Measure(Fn fn, int runs = 3)
+{
+	double best = 0;
+	for (auto run = 0; run < runs; run++)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		fn();
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+		if (!best || elapsed.count() < best) { best = elapsed.count(); }
+	}
+	return best;
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<size_t> sizes;
+	for (auto i = 1; i < argc; i++) { sizes.push_back(strtoull(argv[i], nullptr, 10)); }
+	if (!sizes.size()) { sizes = { 100, 200, 300 }; }
+
+	const std::pair<ScanImpl, const char*> impls[] = { { ScanImpl::Scalar, "Scalar" }, { ScanImpl::SSE2, "SSE2" }, { ScanImpl::AVX2, "AVX2" } };
+	bool avx2 = GetScanImpl() == ScanImpl::AVX2;
+	bool mismatch = false;
+	auto report = [&mismatch](const char* name, size_t i, const uint8_t* found, const uint8_t* expected, const uint8_t* base)
+	{
+		if (found == expected) { return; }
+		mismatch = true;
+		fmt::print("{} found signature {} at {}\n", name, i, found ? found - base : -1);
+	};
+	Random random;
+
+	for (auto mb : sizes)
+	{
+		if (mb < 4) { mb = 4; }
+		auto image = GenerateImage(mb * 1024 * 1024, random);
+		auto base = image.Data.data();
+
+		// Sections are parsed from the headers the same way the dumper does it for a loaded module
+		std::vector<ImageSection> sections;
+		size_t parses = 100000;
+		auto parse = Measure([&]() { for (size_t i = 0; i < parses; i++) { sections = ParseSections(base, ImageHeadersSize, SectionCode, 0); } });
+		fmt::print("{:>4} MB {:<16} {:>7.1f} ns per image\n", mb, "ParseSections", parse / parses * 1e9);
+		if (sections.size() != 1 || sections[0].Start != image.Text || sections[0].End != image.Text + image.TextSize)
+		{
+			mismatch = true;
+			fmt::print("ParseSections found {} code sections\n", sections.size());
+			continue;
+		}
+		auto start = base + sections[0].Start, end = base + sections[0].End;
+		// Every signature scans up to its planted offset
+		double scanned = 0;
+		for (auto offset : image.Planted) { scanned += static_cast<double>(offset - image.Text); }
+
+		for (auto& [impl, name] : impls)
+		{
+			if (impl == ScanImpl::AVX2 && !avx2) { fmt::print("{:>4} MB {:<16} not supported\n", mb, name); continue; }
+			auto best = Measure([&]()
+			{
+				for (size_t i = 0; i < std::size(Signatures); i++) { report(name, i, Scan(start, end, Signatures[i], impl), base + image.Planted[i], base); }
+			});
+			fmt::print("{:>4} MB {:<16} {:>7.2f} GB/s\n", mb, name, scanned / best / 1e9);
+		}
+
+		// Signatures with a displacement are resolved to the addresses they reference
+		double resolved = 0;
+		auto best = Measure([&]()
+		{
+			resolved = 0;
+			for (size_t i = 0; i < std::size(Signatures); i++)
+			{
+				if (Signatures[i].Displacement == Pattern::NoDisplacement) { continue; }
+				auto found = FindPointer(start, end, Signatures[i]);
+				report("FindPointer", i, static_cast<uint8_t*>(found), base + image.Targets[i], base);
+				resolved += static_cast<double>(image.Planted[i] - image.Text);
+			}
+		});
+		fmt::print("{:>4} MB {:<16} {:>7.2f} GB/s\n", mb, "FindPointer", resolved / best / 1e9);
+
+		// All signatures in a single pass, throughput is per pass over the section
+		MultiScanner scanner;
+		for (auto& sig : Signatures) { scanner.Add(sig); }
+		auto last = static_cast<double>(image.Planted.back() - image.Text);
+		for (auto& [impl, name] : impls)
+		{
+			if (impl == ScanImpl::AVX2 && !avx2) { continue; }
+			auto best = Measure([&]()
+			{
+				auto found = scanner.Scan(start, end, impl);
+				for (size_t i = 0; i < found.size(); i++) { report("Multi", i, found[i], base + image.Planted[i], base); }
+			});
+			fmt::print("{:>4} MB Multi {:<10} {:>7.2f} GB/s ({} signatures in one pass)\n", mb, name, last / best / 1e9, std::size(Signatures));
+		}
+
+		// Same pass split into stripes over all cores
+		auto threads = std::thread::hardware_concurrency();
+		for (auto& [impl, name] : impls)
+		{
+			if (impl == ScanImpl::AVX2 && !avx2) { continue; }
+			auto best = Measure([&]()
+			{
+				auto found = scanner.ScanParallel({ { start, end } }, impl, threads);
+				for (size_t i = 0; i < found.size(); i++) { report("Parallel", i, found[i], base + image.Planted[i], base); }
+			});
+			fmt::print("{:>4} MB Parallel {:<7} {:>7.2f} GB/s ({} threads)\n", mb, name, last / best / 1e9, threads);
+		}
+	}
+
+	return mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,354 @@
+#include <fmt/format.h>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "fixture.h"
+#include "alloc.h"
+#include "../Dumper/profiles.h"
+#include "../Dumper/dumper.h"
+#include "../Dumper/memory.h"
+#include "../Dumper/trace.h"
+#include "../Dumper/database.h"
+#include "../Dumper/diff.h"
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+/*
+* End-to-end dump benchmark.
+* Generates a synthetic process image and dumps it with the dumper itself: Dumper::Open scans it for the globals,
+* and Dumper::Dump writes names, objects and packages, the reflection database included, one part at a time.
+* Reports wall time, reads, bytes read, allocations and peak RSS of every phase, and writes them as JSON with '--json'.
+* Parts are phases of their own, so objects aren't dumped while packages are generated like in a full dump.
+* Packages are broken down into the stages of their pipeline, with time and reads summed over the threads of each stage.
+* Exits with failure if the dump doesn't find what was generated.
+* '--stats' times every read and prints the summary of all phases, timing makes the phases slower.
+* '--trace' writes the timeline of the phases and of every worker as Chrome trace JSON.
+* '--patch <percent>' dumps incrementally, grows a struct in that share of the packages and dumps again into the same directory,
+* which has to leave every file as a full dump writes it, then diffs the reflection databases of both dumps,
+* which has to find exactly the grown structs. These passes are checks, they're reported apart from the phases.
+* Usage: DumpBenchmark [--json <file>] [--stats] [--trace <file>] [--profile DeadByDaylight|RogueCompany] [--seed <n>] [--threads <n>] [--out <dir>] [--patch <percent>] [objects]
+*/
+
+struct Phase
+{
+	const char* Name;
+	size_t Items = 0;
+	double Seconds = 0;
+	uint64_t Reads = 0;
+	uint64_t Bytes = 0;
+	uint64_t Failures = 0;
+	uint64_t Tags[static_cast<size_t>(ReadTag::Count)]{};
+	uint64_t Allocations = 0;
+	uint64_t PeakRss = 0;
+};
+
+static uint64_t GetPeakRss()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters{};
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize;
+#else
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+static void PrintPhase(const Phase& phase)
+{
+	fmt::print("{:<11} {:>9} items {:>9.3f} s {:>11} reads {:>8.1f} MB read {:>10} allocations {:>7.1f} MB peak RSS\n",
+		phase.Name, phase.Items, phase.Seconds, phase.Reads, phase.Bytes / 1048576.0, phase.Allocations, phase.PeakRss / 1048576.0);
+}
+
+// Runs the phase once, 'fn' returns the number of items it produced
+template<typename Fn>
+static Phase Measure(const char* name, Fn fn)
+{
+	Phase phase{ name };
+	TraceScope trace(name);
+	auto reads = GetReadStats();
+	auto allocations = GetAllocationCount();
+	auto begin = std::chrono::steady_clock::now();
+	phase.Items = fn();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+	auto after = GetReadStats();
+	phase.Seconds = elapsed.count();
+	phase.Reads = after.Total().Count - reads.Total().Count;
+	phase.Bytes = after.Total().Bytes - reads.Total().Bytes;
+	phase.Failures = after.Total().Failures - reads.Total().Failures;
+	for (size_t i = 0; i < std::size(phase.Tags); i++) { phase.Tags[i] = after.Tags[i].Count - reads.Tags[i].Count; }
+	phase.Allocations = GetAllocationCount() - allocations;
+	phase.PeakRss = GetPeakRss();
+	return phase;
+}
+
+// Counts the dumper reports in its log, e.g. "Saved packages: 15", they're checked against the fixture
+struct DumpLog
+{
+	size_t Names = 0;
+	size_t Objects = 0;
+	size_t Packages = 0;
+	size_t Saved = 0;
+	size_t Unchanged = 0;
+	void Parse(const std::string& text)
+	{
+		auto start = text.find_first_not_of("\r\n");
+		if (start == std::string::npos) { return; }
+		std::pair<std::string_view, size_t*> counts[] =
+		{
+			{ "Names: ", &Names }, { "Objects: ", &Objects }, { "Packages: ", &Packages }, { "Saved packages: ", &Saved }, { "Unchanged packages: ", &Unchanged }
+		};
+		for (auto& [label, count] : counts)
+		{
+			if (!text.compare(start, label.size(), label)) { *count = strtoull(text.c_str() + start + label.size(), nullptr, 10); }
+		}
+	}
+};
+
+static bool ReadWhole(const fs::path& path, std::string& data)
+{
+	FILE* file = nullptr;
+	fopen_s(&file, path.string().c_str(), "rb");
+	if (!file) { return false; }
+	std::error_code ec;
+	data.resize(fs::file_size(path, ec));
+	bool read = !ec && fread(data.data(), 1, data.size(), file) == data.size();
+	fclose(file);
+	return read;
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t objects = 100000;
+	uint64_t seed = 1;
+	std::string profile = "DeadByDaylight";
+	fs::path json;
+	fs::path trace;
+	bool stats = false;
+	auto out = fs::temp_directory_path() / "DumpBenchmark";
+	auto threads = std::max(1u, std::thread::hardware_concurrency());
+	double patch = 0;
+	for (auto i = 1; i < argc; i++)
+	{
+		auto arg = argv[i];
+		bool value = i + 1 < argc;
+		if (!strcmp(arg, "--json") && value) { json = argv[++i]; }
+		else if (!strcmp(arg, "--stats")) { stats = true; }
+		else if (!strcmp(arg, "--trace") && value) { trace = argv[++i]; }
+		else if (!strcmp(arg, "--profile") && value) { profile = argv[++i]; }
+		else if (!strcmp(arg, "--seed") && value) { seed = strtoull(argv[++i], nullptr, 10); }
+		else if (!strcmp(arg, "--threads") && value) { threads = std::max(1u, static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10))); }
+		else if (!strcmp(arg, "--out") && value) { out = argv[++i]; }
+		else if (!strcmp(arg, "--patch") && value) { patch = strtod(argv[++i], nullptr); }
+		else { objects = static_cast<uint32_t>(strtoul(arg, nullptr, 10)); }
+	}
+
+	Offsets offsets;
+	if (profile == "DeadByDaylight") { offsets = std::bit_cast<Offsets>(DeadByDaylight{}); }
+	else if (profile == "RogueCompany") { offsets = std::bit_cast<Offsets>(RogueCompany{}); }
+	else { fmt::print("Unknown profile {}\n", profile); return EXIT_FAILURE; }
+	// Game name selects the same profile in the dumper
+	std::string game = profile == "DeadByDaylight" ? "DeadByDaylight-Win64-Shipping" : profile;
+
+	auto begin = std::chrono::steady_clock::now();
+	auto fixture = GenerateFixture(offsets, objects, seed);
+	std::chrono::duration<double> generation = std::chrono::steady_clock::now() - begin;
+	fmt::print("{} objects, {} names, {} packages, {:.1f} MB image generated in {:.2f} s\n",
+		fixture.Objects, fixture.Names, fixture.Packages, fixture.Image.size() / 1048576.0, generation.count());
+
+	EnableReadTiming(stats);
+	if (!trace.empty())
+	{
+		EnableTrace();
+		TraceThread("Main");
+	}
+
+	std::error_code ec;
+	fs::remove_all(out, ec);
+	auto dir = out / "Dump";
+	std::vector<Phase> phases;
+	// Passes of '--patch' check the incremental dump, they're kept apart from the phases
+	std::vector<Phase> checks;
+
+	DumpLog log;
+	Dumper dumper;
+	dumper.SetLog([&log](const std::string& text) { log.Parse(text); });
+	dumper.SetThreads(threads);
+	// Incremental dump keeps fingerprints, so the patched dump only generates what changed
+	dumper.SetIncremental(patch > 0);
+
+	// Nothing is cached, so the globals are found by the signature scan like on the first run against a game
+	int status = SUCCESS;
+	phases.push_back(Measure("open", [&]()
+	{
+		status = dumper.Open(fixture.Image.data(), fixture.Image.size(), fixture.Base, fixture.Base, fixture.ModuleSize, game, {});
+		return status == SUCCESS ? size_t(1) : size_t(0);
+	}));
+	PrintPhase(phases.back());
+	if (status != SUCCESS) { fmt::print("Can't open the fixture: {}\n", GetStatusMessage(status)); return EXIT_FAILURE; }
+
+	// Writes the parts into 'path' like the dumper executable, gets the number of generated packages
+	auto dump = [&](const fs::path& path, uint32_t parts)
+	{
+		Writer writer;
+		Writer::Prepare(path / "DUMP");
+		status = dumper.Dump(writer, path, parts);
+		auto failed = writer.Close();
+		for (auto& file : failed) { fmt::print("Can't write: {}\n", file.string()); }
+		if (failed.size() && status == SUCCESS) { status = FILE_NOT_OPEN; }
+		// Packages whose headers are kept count as saved as well
+		return status == SUCCESS ? log.Saved - log.Unchanged : 0;
+	};
+
+	// Every part is dumped on its own into the same directory, so each one is a phase
+	bool mismatch = false;
+	std::pair<const char*, Dumper::Part> parts[] = { { "names", Dumper::Names }, { "objects", Dumper::Objects }, { "packages", Dumper::Packages } };
+	for (auto [name, part] : parts)
+	{
+		phases.push_back(Measure(name, [&, part = part]()
+		{
+			auto generated = dump(dir, part);
+			return part == Dumper::Names ? log.Names : part == Dumper::Objects ? log.Objects : generated;
+		}));
+		PrintPhase(phases.back());
+		mismatch |= status != SUCCESS;
+	}
+	auto generated = phases.back().Items;
+	auto stages = dumper.GetPackageStages();
+	// Stages run side by side, so their times are summed over their threads and add up to more than the phase
+	std::pair<const char*, const Dumper::Stage*> breakdown[] =
+	{
+		{ "enumerate", &stages.Enumerate }, { "grouping", &stages.Grouping }, { "process", &stages.Process }, { "save", &stages.Save }
+	};
+	for (auto [name, stage] : breakdown) { fmt::print("  {:<9} {:>9} items {:>9.3f} s {:>11} reads\n", name, stage->Items, stage->Seconds, stage->Reads); }
+	auto full = log;
+	fmt::print("{} names, {} objects, {} packages, {} generated\n", full.Names, full.Objects, full.Packages, generated);
+
+	if (patch > 0 && !mismatch)
+	{
+		// Database of the first dump is replaced by the incremental one, so it's kept for the diff
+		auto before = out / "Reflection.bin";
+		fs::copy_file(dir / "Reflection.bin", before, ec);
+
+		// Every n-th package gets its last sized struct grown, like a patch that adds a member,
+		// the first ones are the bases of everything in the engine packages and would change every package
+		std::vector<UE_UStruct> candidates;
+		std::unordered_map<byte*, size_t> seen;
+		dumper.DumpObjects([&](UE_UObject object)
+		{
+			if (!(object.IsA<UE_UClass>() || object.IsA<UE_UScriptStruct>()) || object.Cast<UE_UStruct>().GetSize() <= 0) { return; }
+			auto [it, inserted] = seen.try_emplace(object.GetPackageObject(), candidates.size());
+			if (inserted) { candidates.push_back(object.Cast<UE_UStruct>()); }
+			else { candidates[it->second] = object.Cast<UE_UStruct>(); }
+		});
+		auto step = std::max<size_t>(1, static_cast<size_t>(100 / patch));
+		size_t patched = 0;
+		for (size_t i = 0; i < candidates.size(); i += step)
+		{
+			auto size = reinterpret_cast<int32_t*>(fixture.Image.data() + (static_cast<byte*>(candidates[i]) - reinterpret_cast<byte*>(fixture.Base)) + defs.UStruct.PropertiesSize);
+			*size += 8;
+			patched++;
+		}
+
+		log = {};
+		checks.push_back(Measure("incremental", [&]() { return dump(dir, Dumper::Packages); }));
+		PrintPhase(checks.back());
+		auto regenerated = checks.back().Items;
+		auto unchanged = log.Unchanged;
+		mismatch |= status != SUCCESS;
+
+		// Subclasses of a grown struct change as well, so every file is checked against a full dump instead of counting
+		dumper.SetIncremental(false);
+		log = {};
+		checks.push_back(Measure("full", [&]() { return dump(out / "Full", Dumper::Packages); }));
+		PrintPhase(checks.back());
+		mismatch |= status != SUCCESS;
+		size_t stale = 0;
+		std::string expected, written;
+		for (auto& entry : fs::recursive_directory_iterator(out / "Full", ec))
+		{
+			if (!entry.is_regular_file()) { continue; }
+			auto path = dir / fs::relative(entry.path(), out / "Full");
+			if (!ReadWhole(entry.path(), expected) || !ReadWhole(path, written) || expected != written) { stale++; }
+		}
+		fmt::print("{} of {} packages patched, {} generated again, {} unchanged, {} stale files\n", patched, candidates.size(), regenerated, unchanged, stale);
+		if (stale || regenerated < patched) { mismatch = true; }
+
+		ReflectionDatabase old, current;
+		size_t resized = 0;
+		if (!old.Load(before) || !current.Load(dir / "Reflection.bin")) { fmt::print("Can't open the reflection databases\n"); mismatch = true; }
+		else
+		{
+			checks.push_back(Measure("diff", [&]()
+			{
+				LayoutDiff diff;
+				DiffLayouts(old.View(), current.View(), diff);
+				for (auto& s : diff.Structs) { if (s.Changes & LayoutDiff::Moved) { resized++; } }
+				return diff.Compared;
+			}));
+			PrintPhase(checks.back());
+			fmt::print("{} structs resized\n", resized);
+			if (resized != patched) { mismatch = true; }
+		}
+	}
+	dumper.Close();
+	fs::remove_all(out, ec);
+	if (stats) { PrintReadStats(GetReadStats()); }
+	if (!trace.empty() && !WriteTrace(trace)) { fmt::print("Can't write: {}\n", trace.string()); return EXIT_FAILURE; }
+
+	if (full.Names != fixture.Names || full.Packages != fixture.Packages || !full.Saved)
+	{
+		mismatch = true;
+		fmt::print("Dump doesn't match the fixture: {} names, {} packages ({})\n", full.Names, full.Packages, GetStatusMessage(status));
+	}
+
+	if (!json.empty())
+	{
+		WriteBuffer buf;
+		FormatTo(buf, "{{\n\t\"profile\": \"{}\",\n\t\"seed\": {},\n\t\"objects\": {},\n\t\"threads\": {},\n", profile, seed, objects, threads);
+		FormatTo(buf, "\t\"fixture\": {{ \"seconds\": {:.6f}, \"image_bytes\": {}, \"names\": {}, \"packages\": {}, \"classes\": {}, \"structs\": {}, \"enums\": {}, \"functions\": {}, \"properties\": {} }},\n",
+			generation.count(), fixture.Image.size(), fixture.Names, fixture.Packages, fixture.Classes, fixture.Structs, fixture.Enums, fixture.Functions, fixture.Properties);
+		auto list = [&buf](const char* key, const std::vector<Phase>& list)
+		{
+			FormatTo(buf, "\t\"{}\": [", key);
+			for (size_t i = 0; i < list.size(); i++)
+			{
+				auto& phase = list[i];
+				FormatTo(buf, "{}\n\t\t{{ \"name\": \"{}\", \"items\": {}, \"seconds\": {:.6f}, \"reads\": {}, \"bytes\": {}, \"failures\": {}, \"allocations\": {}, \"peak_rss\": {},",
+					i ? "," : "", phase.Name, phase.Items, phase.Seconds, phase.Reads, phase.Bytes, phase.Failures, phase.Allocations, phase.PeakRss);
+				auto& tags = phase.Tags;
+				FormatTo(buf, " \"tags\": {{ \"other\": {}, \"name\": {}, \"object\": {}, \"property\": {}, \"function\": {}, \"enum\": {} }} }}",
+					tags[0], tags[1], tags[2], tags[3], tags[4], tags[5]);
+			}
+			FormatTo(buf, "\n\t],\n");
+		};
+		list("phases", phases);
+		FormatTo(buf, "\t\"stages\": [");
+		for (size_t i = 0; i < std::size(breakdown); i++)
+		{
+			auto [name, stage] = breakdown[i];
+			FormatTo(buf, "{}\n\t\t{{ \"name\": \"{}\", \"items\": {}, \"seconds\": {:.6f}, \"reads\": {} }}", i ? "," : "", name, stage->Items, stage->Seconds, stage->Reads);
+		}
+		FormatTo(buf, "\n\t],\n");
+		list("checks", checks);
+		FormatTo(buf, "\t\"valid\": {}\n}}\n", !mismatch);
+		FILE* file = nullptr;
+		fopen_s(&file, json.string().c_str(), "w");
+		bool written = file && fwrite(buf.data(), 1, buf.size(), file) == buf.size();
+		if (file) { fclose(file); }
+		if (!written) { fmt::print("Can't write: {}\n", json.string()); return EXIT_FAILURE; }
+	}
+
+	return mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,605 @@
+#include "fixture.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include "../Dumper/generic.h"
+
+static constexpr uint32_t PageSize = 0x1000;
+static constexpr uint32_t TextSize = 0x40000;
+static constexpr uint32_t DataSize = 0x20000;
+// Objects per chunk of the object array and entries per block of the name pool
+static constexpr uint32_t ChunkSize = 65536;
+static constexpr uint32_t BlockEntries = 65536;
+static constexpr uint64_t CPF_Parm = 0x80;
+static constexpr uint64_t CPF_OutParm = 0x100;
+static constexpr uint64_t CPF_ReturnParm = 0x400;
+// Code that references the globals, same instructions as the first signatures of each global in the dumper
+static constexpr uint8_t ObjObjectsCode[] = { 0x48, 0x8B, 0x05, 0, 0, 0, 0, 0x48, 0x8B, 0x0C, 0xC8, 0x48, 0x8D, 0x04, 0xD1, 0xEB };
+static constexpr uint8_t NamePoolDataCode[] = { 0x48, 0x8D, 0x35, 0, 0, 0, 0, 0xEB, 0x16 };
+
+static const char* const Words[] = {
+	"Player", "Weapon", "Inventory", "Ability", "Health", "Damage", "Camera", "Vehicle", "Quest", "Item", "Team", "Match",
+	"Anim", "Audio", "Widget", "Projectile", "Spawn", "Loot", "Skill", "Cosmetic", "Perk", "Interaction", "Movement", "Effect",
+};
+static const char* const Kinds[] = {
+	"Component", "Manager", "Controller", "State", "Data", "Info", "Settings", "Handler", "Subsystem", "Config", "Library", "Proxy",
+};
+static const char* const Members[] = {
+	"Health", "Speed", "Target", "Owner", "Count", "Radius", "Location", "Rotation", "Items", "Tag", "Level", "Duration",
+	"Scale", "Mesh", "Data", "Cooldown", "Amount", "Instigator", "Slot", "Value",
+};
+static const char* const Verbs[] = { "Get", "Set", "On", "Server", "Client", "Can", "Is", "Apply", "Reset", "Update", "Try", "Begin" };
+
+struct Random
+{
+	uint64_t State;
+	uint64_t Next() { State ^= State << 13; State ^= State >> 7; State ^= State << 17; return State; }
+	uint32_t Below(uint32_t n) { return static_cast<uint32_t>(Next() % n); }
+	template<typename T, size_t N>
+	const T& Pick(const T(&items)[N]) { return items[Below(N)]; }
+	template<typename T>
+	const T& Pick(const std::vector<T>& items) { return items[Below(static_cast<uint32_t>(items.size()))]; }
+};
+
+// Property classes with their element size and alignment, weights roughly follow how often they appear in games
+enum class Kind : uint8_t { Bool, Byte, Int, Int64, Float, Double, Name, Str, Text, Object, Class, SoftObject, WeakObject, Struct, Array, Map, Set, Enum, Delegate, MulticastInlineDelegate, Count };
+static constexpr struct { const char* Name; int32_t Size; int32_t Align; uint32_t Weight; } PropertyKinds[] = {
+	{ "BoolProperty", 1, 1, 14 },
+	{ "ByteProperty", 1, 1, 5 },
+	{ "IntProperty", 4, 4, 12 },
+	{ "Int64Property", 8, 8, 2 },
+	{ "FloatProperty", 4, 4, 16 },
+	{ "DoubleProperty", 8, 8, 1 },
+	{ "NameProperty", 8, 4, 5 },
+	{ "StrProperty", 16, 8, 4 },
+	{ "TextProperty", 24, 8, 3 },
+	{ "ObjectProperty", 8, 8, 12 },
+	{ "ClassProperty", 8, 8, 2 },
+	{ "SoftObjectProperty", 40, 8, 2 },
+	{ "WeakObjectProperty", 8, 4, 2 },
+	{ "StructProperty", 0, 4, 9 },
+	{ "ArrayProperty", 16, 8, 7 },
+	{ "MapProperty", 80, 8, 2 },
+	{ "SetProperty", 80, 8, 1 },
+	{ "EnumProperty", 1, 1, 3 },
+	{ "DelegateProperty", 16, 4, 1 },
+	{ "MulticastInlineDelegateProperty", 16, 8, 2 },
+};
+static_assert(std::size(PropertyKinds) == static_cast<size_t>(Kind::Count));
+
+namespace
+{
+
+class Builder
+{
+private:
+	const Offsets& o;
+	Fixture& f;
+	Random random;
+	uint32_t objectSize, fieldSize, structSize, classSize, functionSize, enumSize, propertySize;
+	// Name pool
+	std::unordered_map<std::string, uint32_t> names;
+	std::vector<uint64_t> blocks;
+	uint32_t cursor = 0;
+	// Object array in index order, empty slots are 0
+	std::vector<uint64_t> objects;
+	uint64_t fieldClasses[static_cast<size_t>(Kind::Count)]{};
+	struct { uint64_t Package, Object, Field, Struct, Class, ScriptStruct, Function, Enum, Actor, ActorComponent; } core{};
+	// Everything that properties of later structs can reference, with sizes of structs
+	std::vector<uint64_t> classes;
+	std::vector<std::pair<uint64_t, int32_t>> structs;
+	std::vector<uint64_t> enums;
+	std::unordered_map<uint64_t, int32_t> sizes;
+	uint32_t unique = 0;
+private:
+	static uint32_t End(uint32_t size, uint16_t offset, uint32_t width) { return std::max(size, (offset + width + 7u) & ~7u); }
+	uint64_t Offset(uint64_t address) const { return address - f.Base; }
+	template<typename T>
+	void Put(uint64_t address, T value) { memcpy(f.Image.data() + Offset(address), &value, sizeof(T)); }
+	template<typename T>
+	T Get(uint64_t address) const { T value; memcpy(&value, f.Image.data() + Offset(address), sizeof(T)); return value; }
+	uint64_t Alloc(size_t size, size_t align = 8)
+	{
+		auto offset = (f.Image.size() + align - 1) & ~(align - 1);
+		f.Image.resize(offset + size);
+		return f.Base + offset;
+	}
+	// Vtables of every kind are in the module, like in a game
+	uint64_t VTable(uint32_t kind) const { return f.Base + PageSize + TextSize - PageSize + kind * 0x100; }
+	uint32_t Name(const std::string& str);
+	void PutName(uint64_t address, uint32_t name, uint32_t number = 0)
+	{
+		Put<uint32_t>(address + o.FName.ComparisonIndex, name);
+		Put<uint32_t>(address + o.FName.Number, number);
+	}
+	uint64_t Object(uint32_t size, uint64_t cls, uint32_t name, uint64_t outer, uint32_t number = 0);
+	uint64_t Object(uint32_t size, uint64_t cls, const std::string& name, uint64_t outer) { return Object(size, cls, Name(name), outer); }
+	uint64_t Struct(uint64_t cls, const std::string& name, uint64_t outer, uint64_t super, int32_t size);
+	uint64_t Property(Kind kind, const std::string& name, int32_t offset, int32_t dim, uint64_t flags);
+	// Appends random properties after 'offset', returns the end of the last one
+	int32_t Properties(uint64_t owner, int32_t offset, uint32_t count);
+	void Module();
+	void Core();
+	void Enum(uint64_t package, const std::string& name);
+	void ScriptStruct(uint64_t package, const std::string& name);
+	void Class(uint64_t package, const std::string& name, uint64_t super);
+	void Function(uint64_t cls, uint64_t& last, const std::string& name);
+	void Package(uint32_t id);
+	void Instances(uint32_t count);
+	void Globals();
+	std::string Unique(const std::string& name) { return name + std::to_string(unique++); }
+public:
+	Builder(const Offsets& offsets, Fixture& fixture, uint64_t seed);
+	void Build(uint32_t count);
+};
+
+Builder::Builder(const Offsets& offsets, Fixture& fixture, uint64_t seed) : o(offsets), f(fixture), random{ seed * 0x9E3779B97F4A7C15ull | 1 }
+{
+	objectSize = End(End(End(End(0x10, o.UObject.Index, 4), o.UObject.Class, 8), o.UObject.Name, std::max(o.FName.ComparisonIndex, o.FName.Number) + 4u), o.UObject.Outer, 8);
+	fieldSize = End(objectSize, o.UField.Next, 8);
+	structSize = End(End(End(End(fieldSize, o.UStruct.SuperStruct, 8), o.UStruct.Children, 8), o.UStruct.ChildProperties, 8), o.UStruct.PropertiesSize, 4) + 0x20;
+	// UClass is a lot larger than UStruct, the rest of it isn't read by the dumper
+	classSize = structSize + 0x180;
+	functionSize = End(End(structSize, o.UFunction.Flags, 4), o.UFunction.FuncPtr, 8);
+	enumSize = End(fieldSize, o.UEnum.Names, sizeof(TArray));
+	propertySize = 0;
+	for (auto offset : { o.FField.Class, o.FField.Next, o.FField.Name, o.FProperty.ArrayDim, o.FProperty.ElementSize, o.FProperty.PropertyFlags, o.FProperty.Offset,
+		o.FStructProperty.Struct, o.FObjectPropertyBase.PropertyClass, o.FClassProperty.MetaClass, o.FArrayProperty.Inner, o.FEnumProperty.Enum,
+		o.FSetProperty.ElementProp, o.FMapProperty.KeyProp, o.FMapProperty.ValueProp, o.FBoolProperty.FieldMask })
+	{
+		propertySize = End(propertySize, offset, 8);
+	}
+}
+
+uint32_t Builder::Name(const std::string& str)
+{
+	auto it = names.find(str);
+	if (it != names.end()) { return it->second; }
+
+	auto len = static_cast<uint16_t>(std::min<size_t>(str.size(), 1023));
+	uint32_t size = (o.FNameEntry.HeaderSize + len + o.Stride - 1u) & ~(o.Stride - 1u);
+	if (blocks.empty() || cursor + size > o.Stride * BlockEntries)
+	{
+		blocks.push_back(Alloc(o.Stride * BlockEntries, PageSize));
+		cursor = 0;
+	}
+	auto entry = blocks.back() + cursor;
+	// Bits of the header that aren't len and wide are the hash in UE, the dumper has to ignore them
+	for (uint32_t i = 0; i < o.FNameEntry.HeaderSize; i++) { Put<uint8_t>(entry + i, static_cast<uint8_t>(random.Next())); }
+	uint16_t info = static_cast<uint16_t>(len << o.FNameEntry.LenBitOffset);
+	uint16_t hash = static_cast<uint16_t>(random.Next()) & static_cast<uint16_t>((1u << o.FNameEntry.LenBitOffset) - 1) & ~(1u << o.FNameEntry.WideBitOffset);
+	Put<uint16_t>(entry + o.FNameEntry.InfoOffset, info | hash);
+	memcpy(f.Image.data() + Offset(entry) + o.FNameEntry.HeaderSize, str.data(), len);
+
+	uint32_t id = static_cast<uint32_t>(blocks.size() - 1) << 16 | cursor / o.Stride;
+	cursor += size;
+	names.emplace(str, id);
+	f.Names++;
+	return id;
+}
+
+uint64_t Builder::Object(uint32_t size, uint64_t cls, uint32_t name, uint64_t outer, uint32_t number)
+{
+	auto object = Alloc(size);
+	Put<uint64_t>(object, VTable(0));
+	Put<uint32_t>(object + o.UObject.Index, static_cast<uint32_t>(objects.size()));
+	Put<uint64_t>(object + o.UObject.Class, cls);
+	PutName(object + o.UObject.Name, name, number);
+	Put<uint64_t>(object + o.UObject.Outer, outer);
+	objects.push_back(object);
+	return object;
+}
+
+uint64_t Builder::Struct(uint64_t cls, const std::string& name, uint64_t outer, uint64_t super, int32_t size)
+{
+	auto object = Object(cls == core.Class ? classSize : cls == core.Function ? functionSize : structSize, cls, name, outer);
+	Put<uint64_t>(object + o.UStruct.SuperStruct, super);
+	Put<int32_t>(object + o.UStruct.PropertiesSize, size);
+	sizes[object] = size;
+	return object;
+}
+
+uint64_t Builder::Property(Kind kind, const std::string& name, int32_t offset, int32_t dim, uint64_t flags)
+{
+	auto& info = PropertyKinds[static_cast<size_t>(kind)];
+	auto prop = Alloc(propertySize);
+	Put<uint64_t>(prop, VTable(1 + static_cast<uint32_t>(kind)));
+	Put<uint64_t>(prop + o.FField.Class, fieldClasses[static_cast<size_t>(kind)]);
+	PutName(prop + o.FField.Name, Name(name));
+	Put<int32_t>(prop + o.FProperty.ArrayDim, dim);
+	Put<int32_t>(prop + o.FProperty.ElementSize, info.Size);
+	Put<uint64_t>(prop + o.FProperty.PropertyFlags, flags);
+	Put<int32_t>(prop + o.FProperty.Offset, offset);
+
+	// Containers own properties of their elements, those are never in a chain
+	auto inner = [&]()
+	{
+		static constexpr Kind kinds[] = { Kind::Int, Kind::Float, Kind::Object, Kind::Name, Kind::Str, Kind::Struct, Kind::Byte };
+		auto element = random.Pick(kinds);
+		if (element == Kind::Struct && structs.empty()) { element = Kind::Int; }
+		return Property(element, name, 0, 1, 0);
+	};
+	switch (kind)
+	{
+	case Kind::Object:
+	case Kind::WeakObject:
+	case Kind::SoftObject:
+		Put<uint64_t>(prop + o.FObjectPropertyBase.PropertyClass, random.Pick(classes));
+		break;
+	case Kind::Class:
+		Put<uint64_t>(prop + o.FObjectPropertyBase.PropertyClass, core.Class);
+		Put<uint64_t>(prop + o.FClassProperty.MetaClass, random.Pick(classes));
+		break;
+	case Kind::Struct:
+	{
+		auto& [target, size] = random.Pick(structs);
+		Put<uint64_t>(prop + o.FStructProperty.Struct, target);
+		Put<int32_t>(prop + o.FProperty.ElementSize, size);
+		break;
+	}
+	case Kind::Array: Put<uint64_t>(prop + o.FArrayProperty.Inner, inner()); break;
+	case Kind::Set: Put<uint64_t>(prop + o.FSetProperty.ElementProp, inner()); break;
+	case Kind::Map:
+		Put<uint64_t>(prop + o.FMapProperty.KeyProp, inner());
+		Put<uint64_t>(prop + o.FMapProperty.ValueProp, inner());
+		break;
+	case Kind::Enum: Put<uint64_t>(prop + o.FEnumProperty.Enum, random.Pick(enums)); break;
+	case Kind::Bool:
+		// Native bool unless the caller turns it into a bitfield
+		Put<uint8_t>(prop + o.FBoolProperty.FieldSize, 1);
+		Put<uint8_t>(prop + o.FBoolProperty.ByteMask, 0xFF);
+		Put<uint8_t>(prop + o.FBoolProperty.FieldMask, 0xFF);
+		break;
+	default: break;
+	}
+	f.Properties++;
+	return prop;
+}
+
+int32_t Builder::Properties(uint64_t owner, int32_t offset, uint32_t count)
+{
+	uint32_t total = 0;
+	for (auto& kind : PropertyKinds) { total += kind.Weight; }
+
+	uint64_t last = 0;
+	auto link = [&](uint64_t prop)
+	{
+		if (last) { Put<uint64_t>(last + o.FField.Next, prop); }
+		else { Put<uint64_t>(owner + o.UStruct.ChildProperties, prop); }
+		last = prop;
+	};
+	for (uint32_t i = 0; i < count; i++)
+	{
+		auto pick = random.Below(total);
+		size_t k = 0;
+		while (pick >= PropertyKinds[k].Weight) { pick -= PropertyKinds[k++].Weight; }
+		auto kind = static_cast<Kind>(k);
+		if ((kind == Kind::Struct && structs.empty()) || (kind == Kind::Enum && enums.empty())) { kind = Kind::Int; }
+
+		auto name = std::string(random.Pick(Members)) + std::to_string(i);
+		if (kind == Kind::Bool && random.Below(2))
+		{
+			// Run of bitfields that share one byte
+			auto bits = 1 + random.Below(8);
+			for (uint32_t bit = 0; bit < bits; bit++)
+			{
+				auto prop = Property(Kind::Bool, "b" + name + "_" + std::to_string(bit), offset, 1, 0);
+				Put<uint8_t>(prop + o.FBoolProperty.ByteMask, static_cast<uint8_t>(1 << bit));
+				Put<uint8_t>(prop + o.FBoolProperty.FieldMask, static_cast<uint8_t>(1 << bit));
+				link(prop);
+			}
+			offset += 1;
+			continue;
+		}
+
+		auto align = PropertyKinds[k].Align;
+		offset = (offset + align - 1) & ~(align - 1);
+		// Occasional static arrays of plain values
+		int32_t dim = kind <= Kind::Double && kind != Kind::Bool && !random.Below(12) ? 2 + random.Below(6) : 1;
+		auto prop = Property(kind, kind == Kind::Bool ? "b" + name : name, offset, dim, 0);
+		link(prop);
+		offset += Get<int32_t>(prop + o.FProperty.ElementSize) * dim;
+	}
+	return offset;
+}
+
+void Builder::Module()
+{
+	// PE32+ headers with a code and a data section
+	auto base = f.Base;
+	uint32_t nt = 0x80, optional = nt + 0x18, optionalSize = 0xF0, table = optional + optionalSize;
+	Put<uint16_t>(base, 0x5A4D);
+	Put<int32_t>(base + 0x3C, nt);
+	Put<uint32_t>(base + nt, 0x4550);
+	Put<uint16_t>(base + nt + 0x4, 0x8664);
+	Put<uint16_t>(base + nt + 0x6, 2);
+	Put<uint32_t>(base + nt + 0x8, static_cast<uint32_t>(random.Next()));
+	Put<uint16_t>(base + nt + 0x14, static_cast<uint16_t>(optionalSize));
+	Put<uint16_t>(base + optional, 0x20B);
+	Put<uint64_t>(base + optional + 0x18, base);
+	Put<uint32_t>(base + optional + 0x20, PageSize);
+	Put<uint32_t>(base + optional + 0x24, 0x200);
+	Put<uint32_t>(base + optional + 0x38, f.ModuleSize);
+	Put<uint32_t>(base + optional + 0x3C, PageSize);
+	const struct { const char* Name; uint32_t Address; uint32_t Size; uint32_t Characteristics; } sections[] = {
+		{ ".text", PageSize, TextSize, 0x60000020 },
+		{ ".data", PageSize + TextSize, DataSize, 0xC0000040 },
+	};
+	for (size_t i = 0; i < std::size(sections); i++)
+	{
+		auto header = base + table + i * 0x28;
+		memcpy(f.Image.data() + Offset(header), sections[i].Name, strlen(sections[i].Name));
+		Put<uint32_t>(header + 0x8, sections[i].Size);
+		Put<uint32_t>(header + 0xC, sections[i].Address);
+		Put<uint32_t>(header + 0x10, sections[i].Size);
+		Put<uint32_t>(header + 0x14, sections[i].Address);
+		Put<uint32_t>(header + 0x24, sections[i].Characteristics);
+	}
+
+	// Code is mostly common opcode bytes, the instructions that reference the globals are somewhere in the middle
+	static const uint8_t common[] = { 0x00, 0x00, 0xFF, 0x48, 0x48, 0x8B, 0x89, 0xCC, 0x24, 0x0F, 0xE8, 0x4C, 0x8D, 0x44, 0x85, 0xC0, 0x83, 0x74, 0xEB, 0xC3 };
+	auto text = f.Image.data() + PageSize;
+	for (uint32_t i = 0; i < TextSize; i++) { text[i] = random.Pick(common); }
+	f.ObjObjects = PageSize + TextSize;
+	f.NamePoolData = (f.ObjObjects + sizeof(TUObjectArray) + 15) & ~15ull;
+	auto plant = [&](uint32_t offset, const uint8_t* code, size_t size, uint64_t target)
+	{
+		memcpy(text + offset, code, size);
+		auto next = PageSize + offset + 3 + 4;
+		Put<int32_t>(base + PageSize + offset + 3, static_cast<int32_t>(target - next));
+	};
+	plant(TextSize / 3 + random.Below(PageSize), ObjObjectsCode, sizeof(ObjObjectsCode), f.ObjObjects);
+	plant(TextSize / 2 + random.Below(PageSize), NamePoolDataCode, sizeof(NamePoolDataCode), f.NamePoolData);
+
+	// Property classes are statics of the module
+	auto fieldClass = f.Base + f.NamePoolData + sizeof(FNamePool);
+	for (size_t i = 0; i < std::size(fieldClasses); i++)
+	{
+		fieldClasses[i] = fieldClass = (fieldClass + 15) & ~15ull;
+		PutName(fieldClass + o.FFieldClass.Name, Name(PropertyKinds[i].Name));
+		fieldClass += o.FFieldClass.Name + 0x40;
+	}
+}
+
+void Builder::Core()
+{
+	// Package of CoreUObject is the first object, classes are patched in once they exist
+	core.Package = Object(objectSize, 0, "/Script/CoreUObject", 0);
+	core.Object = Struct(0, "Object", core.Package, 0, 0x28);
+	core.Field = Struct(0, "Field", core.Package, core.Object, 0x30);
+	core.Struct = Struct(0, "Struct", core.Package, core.Field, 0xB0);
+	core.Class = Struct(0, "Class", core.Package, core.Struct, 0x230);
+	core.ScriptStruct = Struct(core.Class, "ScriptStruct", core.Package, core.Struct, 0xC0);
+	core.Function = Struct(core.Class, "Function", core.Package, core.Struct, 0xE0);
+	core.Enum = Struct(core.Class, "Enum", core.Package, core.Field, 0x60);
+	auto package = Struct(core.Class, "Package", core.Package, core.Object, 0x98);
+	for (auto object : { core.Object, core.Field, core.Struct, core.Class }) { Put<uint64_t>(object + o.UObject.Class, core.Class); }
+	Put<uint64_t>(core.Package + o.UObject.Class, package);
+	classes = { core.Object, core.Field, core.Struct, core.Class, core.ScriptStruct, core.Function, core.Enum, package };
+	f.Classes += static_cast<uint32_t>(classes.size());
+
+	// Structs that everything else uses
+	const std::pair<const char*, uint32_t> vectors[] = { { "Vector", 3 }, { "Rotator", 3 }, { "Vector2D", 2 }, { "LinearColor", 4 }, { "Quat", 4 } };
+	for (auto& [name, floats] : vectors)
+	{
+		auto object = Struct(core.ScriptStruct, name, core.Package, 0, floats * 4);
+		uint64_t last = 0;
+		for (uint32_t i = 0; i < floats; i++)
+		{
+			auto prop = Property(Kind::Float, std::string(1, "XYZW"[i]), i * 4, 1, 0);
+			Put<uint64_t>(last ? last + o.FField.Next : object + o.UStruct.ChildProperties, prop);
+			last = prop;
+		}
+		structs.push_back({ object, floats * 4 });
+		f.Structs++;
+	}
+	Enum(core.Package, "ETravelType");
+	f.Packages++;
+
+	auto engine = Object(objectSize, package, "/Script/Engine", 0);
+	core.Actor = 0;
+	Class(engine, "Actor", core.Object);
+	core.Actor = classes.back();
+	Class(engine, "ActorComponent", core.Object);
+	core.ActorComponent = classes.back();
+	Class(engine, "SceneComponent", core.ActorComponent);
+	Class(engine, "Pawn", core.Actor);
+	Class(engine, "Character", classes.back());
+	Class(engine, "Controller", core.Actor);
+	Class(engine, "PlayerController", classes.back());
+	Class(engine, "GameModeBase", core.Actor);
+	ScriptStruct(engine, "HitResult");
+	Enum(engine, "ECollisionChannel");
+	f.Packages++;
+}
+
+void Builder::Enum(uint64_t package, const std::string& name)
+{
+	auto object = Object(enumSize, core.Enum, name, package);
+	auto count = 2 + random.Below(10);
+	// TArray<TPair<FName, int64>>
+	uint32_t value = (o.FName.Number + 4u + 7u) & ~7u, size = (o.FName.Number + 4u + 8 + 7u) & ~7u;
+	auto data = Alloc(size * (count + 1));
+	for (uint32_t i = 0; i <= count; i++)
+	{
+		auto member = i == count ? name + "_MAX" : std::string(random.Pick(Members)) + std::to_string(i);
+		PutName(data + i * size, Name(name + "::" + member));
+		Put<int64_t>(data + i * size + value, i);
+	}
+	Put<TArray>(object + o.UEnum.Names, { reinterpret_cast<byte*>(data), count + 1, count + 1 });
+	enums.push_back(object);
+	f.Enums++;
+}
+
+void Builder::ScriptStruct(uint64_t package, const std::string& name)
+{
+	auto object = Struct(core.ScriptStruct, name, package, 0, 0);
+	auto size = (Properties(object, 0, 2 + random.Below(10)) + 7) & ~7;
+	Put<int32_t>(object + o.UStruct.PropertiesSize, size);
+	sizes[object] = size;
+	structs.push_back({ object, size });
+	f.Structs++;
+}
+
+void Builder::Class(uint64_t package, const std::string& name, uint64_t super)
+{
+	auto inherited = super ? sizes[super] : 0;
+	auto object = Struct(core.Class, name, package, super, 0);
+	auto size = (Properties(object, inherited, 1 + random.Below(16)) + 7) & ~7;
+	Put<int32_t>(object + o.UStruct.PropertiesSize, size);
+	sizes[object] = size;
+
+	uint64_t last = 0;
+	for (uint32_t i = 0, count = random.Below(9); i < count; i++)
+	{
+		Function(object, last, std::string(random.Pick(Verbs)) + random.Pick(Members) + std::to_string(i));
+	}
+	classes.push_back(object);
+	f.Classes++;
+
+	// Every class has its default object
+	Object(objectSize, object, "Default__" + name, package);
+}
+
+void Builder::Function(uint64_t cls, uint64_t& last, const std::string& name)
+{
+	auto object = Struct(core.Function, name, cls, 0, 0);
+	Put<uint64_t>(last ? last + o.UField.Next : cls + o.UStruct.Children, object);
+	last = object;
+
+	static constexpr uint32_t flags[] = { 0x00020400, 0x04020400, 0x14020400, 0x08020800, 0x00220440, 0x01020CC0, 0x44020400, 0x00080400 };
+	Put<uint32_t>(object + o.UFunction.Flags, random.Pick(flags));
+	Put<uint64_t>(object + o.UFunction.FuncPtr, f.Base + PageSize + random.Below(TextSize - PageSize));
+
+	// Parameters are properties of the function, return value is the last one
+	static constexpr Kind kinds[] = { Kind::Int, Kind::Float, Kind::Bool, Kind::Object, Kind::Name, Kind::Str, Kind::Byte, Kind::Struct };
+	uint64_t prop = 0, previous = 0;
+	int32_t offset = 0;
+	auto params = random.Below(5);
+	bool ret = random.Below(2);
+	for (uint32_t i = 0; i < params + ret; i++)
+	{
+		auto kind = random.Pick(kinds);
+		if (kind == Kind::Struct && structs.empty()) { kind = Kind::Int; }
+		auto align = PropertyKinds[static_cast<size_t>(kind)].Align;
+		offset = (offset + align - 1) & ~(align - 1);
+		bool isReturn = i == params;
+		uint64_t flags = CPF_Parm | (isReturn ? CPF_ReturnParm | CPF_OutParm : !random.Below(6) ? CPF_OutParm : 0);
+		prop = Property(kind, isReturn ? "ReturnValue" : std::string(random.Pick(Members)) + std::to_string(i), offset, 1, flags);
+		Put<uint64_t>(previous ? previous + o.FField.Next : object + o.UStruct.ChildProperties, prop);
+		previous = prop;
+		offset += Get<int32_t>(prop + o.FProperty.ElementSize);
+	}
+	Put<int32_t>(object + o.UStruct.PropertiesSize, offset);
+	f.Functions++;
+}
+
+void Builder::Package(uint32_t id)
+{
+	auto name = std::string(random.Pick(Words)) + (id % 3 ? "Gameplay" : "Runtime") + std::to_string(id);
+	auto package = Object(objectSize, Get<uint64_t>(core.Package + o.UObject.Class), "/Script/" + name, 0);
+	for (uint32_t i = 0, count = 5 + random.Below(20); i < count; i++) { Enum(package, Unique("E" + std::string(random.Pick(Words)) + random.Pick(Kinds))); }
+	for (uint32_t i = 0, count = 10 + random.Below(40); i < count; i++) { ScriptStruct(package, Unique(std::string(random.Pick(Words)) + random.Pick(Kinds))); }
+	auto first = classes.size();
+	for (uint32_t i = 0, count = 20 + random.Below(80); i < count; i++)
+	{
+		// Deep hierarchies within the package, on top of the engine classes
+		uint64_t super;
+		switch (random.Below(5))
+		{
+		case 0: super = core.Object; break;
+		case 1: super = core.Actor; break;
+		case 2: super = core.ActorComponent; break;
+		default: super = classes.size() > first ? classes[first + random.Below(static_cast<uint32_t>(classes.size() - first))] : core.Actor; break;
+		}
+		Class(package, Unique(std::string(random.Pick(Words)) + random.Pick(Kinds)), super);
+	}
+	f.Packages++;
+}
+
+void Builder::Instances(uint32_t count)
+{
+	// Instances belong to levels, those packages have no types and are dropped by the dumper
+	auto packageClass = Get<uint64_t>(core.Package + o.UObject.Class);
+	std::unordered_map<uint64_t, uint32_t> numbers;
+	uint64_t level = 0;
+	uint32_t freed = 0;
+	for (uint32_t i = 0; objects.size() < count; i++)
+	{
+		if (i % 2000 == 0) { level = Object(objectSize, packageClass, "/Game/Maps/Level" + std::to_string(i / 2000), 0); continue; }
+		// Freed objects leave empty slots, a few are taken by enums loaded later, far from the rest of their package
+		if (!random.Below(200))
+		{
+			uint64_t reused = 0;
+			if (++freed % 128 == 0)
+			{
+				reused = random.Pick(enums);
+				auto& slot = objects[Get<uint32_t>(reused + o.UObject.Index)];
+				if (slot == reused) { slot = 0; Put<uint32_t>(reused + o.UObject.Index, static_cast<uint32_t>(objects.size())); }
+				else { reused = 0; }
+			}
+			objects.push_back(reused);
+			continue;
+		}
+		auto cls = classes[8 + random.Below(static_cast<uint32_t>(classes.size() - 8))];
+		auto name = Get<uint32_t>(cls + o.UObject.Name + o.FName.ComparisonIndex);
+		Object(objectSize, cls, name, level, ++numbers[cls]);
+	}
+}
+
+void Builder::Globals()
+{
+	// TUObjectArray with all chunks allocated up front, like the engine does
+	auto count = static_cast<uint32_t>(objects.size());
+	auto chunks = (count + ChunkSize - 1) / ChunkSize;
+	auto maxChunks = chunks + 1;
+	auto table = Alloc(maxChunks * sizeof(uint64_t));
+	for (uint32_t chunk = 0; chunk < chunks; chunk++)
+	{
+		auto items = Alloc(static_cast<size_t>(ChunkSize) * o.FUObjectItem.Size, PageSize);
+		Put<uint64_t>(table + chunk * sizeof(uint64_t), items);
+		for (uint32_t i = chunk * ChunkSize; i < std::min(count, (chunk + 1) * ChunkSize); i++)
+		{
+			Put<uint64_t>(items + (i % ChunkSize) * o.FUObjectItem.Size + o.FUObjectItem.Object, objects[i]);
+		}
+	}
+	auto array = f.Base + f.ObjObjects;
+	Put<uint64_t>(array + offsetof(TUObjectArray, Objects), table);
+	Put<uint32_t>(array + offsetof(TUObjectArray, MaxElements), maxChunks * ChunkSize);
+	Put<uint32_t>(array + offsetof(TUObjectArray, NumElements), count);
+	Put<uint32_t>(array + offsetof(TUObjectArray, MaxChunks), maxChunks);
+	Put<uint32_t>(array + offsetof(TUObjectArray, NumChunks), chunks);
+
+	auto pool = f.Base + f.NamePoolData;
+	Put<uint32_t>(pool + offsetof(FNamePool, CurrentBlock), static_cast<uint32_t>(blocks.size() - 1));
+	Put<uint32_t>(pool + offsetof(FNamePool, CurrentByteCursor), cursor);
+	for (size_t i = 0; i < blocks.size(); i++) { Put<uint64_t>(pool + offsetof(FNamePool, Blocks) + i * sizeof(uint64_t), blocks[i]); }
+	f.Objects = count;
+}
+
+void Builder::Build(uint32_t count)
+{
+	f.Image.reserve(static_cast<size_t>(count) * 256 + (64 << 20));
+	f.ModuleSize = PageSize + TextSize + DataSize;
+	Alloc(f.ModuleSize, PageSize);
+	// Hardcoded names come first in every pool
+	for (auto name : HardcodedNames) { Name(name); }
+	Module();
+	Core();
+	// About a quarter of the objects are types, the rest are instances
+	for (uint32_t id = 0; objects.size() < count / 4; id++) { Package(id); }
+	Instances(count);
+	Globals();
+}
+
+}
+
+Fixture GenerateFixture(const Offsets& offsets, uint32_t objects, uint64_t seed, uint64_t base)
+{
+	Fixture fixture;
+	fixture.Base = base;
+	Builder(offsets, fixture, seed).Build(objects);
+	return fixture;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "../Dumper/engine.h"
+
+/*
+* Synthetic image of a UE process, so the dumper can be benchmarked and tested without a running game.
+* It starts with a module whose code references the globals the way the dumper's signatures expect, followed by a heap with
+* the name pool, the chunked object array, CoreUObject and Engine classes, generated packages of classes, structs, enums
+* and functions with FField property chains, and instances that live in level packages. Everything is laid out by 'Offsets'.
+* Pointers in the image are absolute for 'Base', so it's read either in place with ReaderInit(image, base, size),
+* or from a stand-in process that maps it at 'Base' (see target.cpp).
+*/
+struct Fixture
+{
+	static constexpr uint64_t DefaultBase = 0x7FF600000000;
+	uint64_t Base = DefaultBase;
+	std::vector<uint8_t> Image;
+	// Module at the start of the image, offsets of the globals are from its base like in the scan cache
+	uint32_t ModuleSize = 0;
+	uint64_t ObjObjects = 0;
+	uint64_t NamePoolData = 0;
+	// What was generated, to check what the dumper finds
+	uint32_t Objects = 0;
+	uint32_t Names = 0;
+	uint32_t Packages = 0; // packages that have structs or enums
+	uint32_t Classes = 0;
+	uint32_t Structs = 0;
+	uint32_t Enums = 0;
+	uint32_t Functions = 0;
+	uint32_t Properties = 0;
+};
+
+// 'objects' is the number of slots in the object array, scale of real games is between 10k and 2M
+Fixture GenerateFixture(const Offsets& offsets, uint32_t objects, uint64_t seed = 1, uint64_t base = Fixture::DefaultBase);
@@ -0,0 +1,223 @@
+#include <fmt/format.h>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fixture.h"
+#include "../Dumper/profiles.h"
+#include "../Dumper/wrappers.h"
+#include "../Dumper/memory.h"
+#include "../Dumper/daemon.h"
+
+namespace fs = std::filesystem;
+
+/*
+* Query latency of the dump daemon.
+* Generates a synthetic process image, builds the daemon's index over it and serves it on a local socket like '--daemon' does.
+* A client then sends random queries of every kind and the round trip of each one is measured, the target is p99 under 1 ms.
+* Before the queries the image hides its last objects and names, and the daemon has to find them with an incremental refresh.
+* Two indexed slots also swap their objects, and the same refresh has to index both of them again.
+* Exits with failure if an answer is wrong.
+* Usage: QueryBenchmark [--profile DeadByDaylight|RogueCompany] [--seed <n>] [--queries <n>] [objects]
+*/
+
+struct Latency
+{
+	const char* Name;
+	std::vector<double> Samples;
+	uint32_t Failures = 0;
+};
+
+static double Percentile(std::vector<double>& samples, double p)
+{
+	if (samples.empty()) { return 0; }
+	auto index = std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()));
+	std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+	return samples[index];
+}
+
+int main(int argc, char* argv[])
+{
+	uint32_t objects = 100000;
+	uint32_t queries = 20000;
+	uint64_t seed = 1;
+	std::string profile = "DeadByDaylight";
+	for (auto i = 1; i < argc; i++)
+	{
+		auto arg = argv[i];
+		bool value = i + 1 < argc;
+		if (!strcmp(arg, "--profile") && value) { profile = argv[++i]; }
+		else if (!strcmp(arg, "--seed") && value) { seed = strtoull(argv[++i], nullptr, 10); }
+		else if (!strcmp(arg, "--queries") && value) { queries = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)); }
+		else { objects = static_cast<uint32_t>(strtoul(arg, nullptr, 10)); }
+	}
+
+	Offsets offsets;
+	if (profile == "DeadByDaylight") { offsets = std::bit_cast<Offsets>(DeadByDaylight{}); }
+	else if (profile == "RogueCompany") { offsets = std::bit_cast<Offsets>(RogueCompany{}); }
+	else { fmt::print("Unknown profile {}\n", profile); return EXIT_FAILURE; }
+
+	auto fixture = GenerateFixture(offsets, objects, seed);
+	fmt::print("{} objects, {} names, {:.1f} MB image\n", fixture.Objects, fixture.Names, fixture.Image.size() / 1048576.0);
+	defs = offsets;
+	ReaderInit(fixture.Image.data(), fixture.Base, fixture.Image.size());
+	auto base = reinterpret_cast<byte*>(fixture.Base);
+	if (!Read(base + fixture.ObjObjects, &ObjObjects, sizeof(ObjObjects)) || !Read(base + fixture.NamePoolData, &NamePoolData, sizeof(NamePoolData)))
+	{
+		fmt::print("Can't read the globals\n");
+		return EXIT_FAILURE;
+	}
+
+	// Names and objects the client asks for, taken from the image directly
+	std::vector<std::pair<uint32_t, std::string>> names;
+	NamePoolData.Dump([&names](std::string_view name, uint32_t id) { names.emplace_back(id, name); });
+	std::vector<std::pair<uint32_t, std::string>> fullNames, structs;
+	ObjObjects.Dump([&](UE_UObject object)
+	{
+		fullNames.emplace_back(object.GetIndex(), object.GetFullName());
+		if (object.IsA<UE_UStruct>()) { structs.emplace_back(object.GetIndex(), fullNames.back().second); }
+	});
+
+	// The last objects and names of the current block are hidden, as if the game added them after the daemon started
+	auto objectArray = reinterpret_cast<TUObjectArray*>(fixture.Image.data() + fixture.ObjObjects);
+	auto namePool = reinterpret_cast<FNamePool*>(fixture.Image.data() + fixture.NamePoolData);
+	uint32_t hiddenObjects = std::min(1000u, objectArray->NumElements - 1);
+	uint32_t hiddenNames = 0;
+	auto cursor = namePool->CurrentByteCursor;
+	for (auto it = names.rbegin(); it != names.rend() && hiddenNames < 1000 && FNameEntryHandle(it->first).Block == namePool->CurrentBlock; ++it)
+	{
+		cursor = FNameEntryHandle(it->first).Offset * defs.Stride;
+		hiddenNames++;
+	}
+	std::swap(namePool->CurrentByteCursor, cursor);
+	objectArray->NumElements -= hiddenObjects;
+
+	auto begin = std::chrono::steady_clock::now();
+	QueryIndex index(base + fixture.ObjObjects, base + fixture.NamePoolData);
+	std::chrono::duration<double> build = std::chrono::steady_clock::now() - begin;
+	fmt::print("Indexed {} names and {} objects in {:.2f} s\n", index.GetNameCount(), index.GetObjectCount(), build.count());
+	std::swap(namePool->CurrentByteCursor, cursor);
+	objectArray->NumElements += hiddenObjects;
+
+	// Two indexed slots swap their objects, as if both were freed and reused, the refresh has to index them again
+	auto item = [&](uint32_t index)
+	{
+		auto chunk = Read<byte*>(ObjObjects.Objects + index / 65536);
+		return reinterpret_cast<byte**>(fixture.Image.data() + (chunk + index % 65536 * defs.FUObjectItem.Size + defs.FUObjectItem.Object - base));
+	};
+	auto& first = fullNames[fullNames.size() / 3];
+	auto& second = fullNames[fullNames.size() / 2];
+	std::swap(*item(first.first), *item(second.first));
+	for (auto& type : structs)
+	{
+		if (type.first == first.first) { type.first = second.first; }
+		else if (type.first == second.first) { type.first = first.first; }
+	}
+	std::swap(first.first, second.first);
+
+#ifdef _WIN32
+	std::string endpoint = "\\\\.\\pipe\\QueryBenchmark";
+#else
+	std::string endpoint = (fs::temp_directory_path() / "QueryBenchmark.sock").string();
+#endif
+	QueryServer server(index, endpoint);
+	bool served = true;
+	std::thread serving([&]() { served = server.Run(); });
+
+	QueryClient client;
+	for (auto attempt = 0; !client.Connect(endpoint); attempt++)
+	{
+		if (attempt == 100) { fmt::print("Can't connect to {}\n", endpoint); server.Stop(); serving.join(); return EXIT_FAILURE; }
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	bool ok = true;
+	MessageWriter request;
+	MessageReader response(nullptr, 0);
+	auto status = [&response]() { return response.Get<QueryStatus>(); };
+
+	// The first query after the build may already refresh on its own, so totals are checked instead of what this refresh found
+	request.Clear();
+	request.Put(QueryOp::Refresh);
+	if (!client.Query(request, response) || status() != QueryStatus::Ok) { ok = false; }
+	request.Clear();
+	request.Put(QueryOp::Stats);
+	if (!client.Query(request, response) || status() != QueryStatus::Ok) { ok = false; }
+	auto indexedNames = response.Get<uint32_t>();
+	auto indexedObjects = response.Get<uint32_t>();
+	fmt::print("Refreshed to {} names and {} objects after {} names and {} objects were added\n", indexedNames, indexedObjects, hiddenNames, hiddenObjects);
+	if (indexedNames != names.size() || indexedObjects != objectArray->NumElements) { ok = false; }
+	for (auto& swapped : { first, second })
+	{
+		request.Clear();
+		request.Put(QueryOp::FindObject).PutString(swapped.second);
+		if (!client.Query(request, response) || status() != QueryStatus::Ok || response.Get<uint32_t>() != swapped.first)
+		{
+			fmt::print("Slot {} wasn't indexed again after its object changed\n", swapped.first);
+			ok = false;
+		}
+	}
+
+	Latency latencies[] = { { "NameById" }, { "IdByName" }, { "ObjectByIndex" }, { "FindObject" }, { "StructLayout" }, { "Hierarchy" } };
+	std::mt19937_64 random(seed);
+	for (auto i = 0u; i < queries; i++)
+	{
+		auto kind = random() % std::size(latencies);
+		auto& name = names[random() % names.size()];
+		auto& object = fullNames[random() % fullNames.size()];
+		auto& type = structs[random() % structs.size()];
+		request.Clear();
+		switch (kind)
+		{
+		case 0: request.Put(QueryOp::NameById).Put(name.first); break;
+		case 1: request.Put(QueryOp::IdByName).PutString(name.second); break;
+		case 2: request.Put(QueryOp::ObjectByIndex).Put(object.first); break;
+		case 3: request.Put(QueryOp::FindObject).PutString(object.second); break;
+		case 4: request.Put(QueryOp::StructLayout).PutString(type.second); break;
+		case 5: request.Put(QueryOp::Hierarchy).PutString(type.second); break;
+		}
+
+		auto sent = std::chrono::steady_clock::now();
+		if (!client.Query(request, response)) { fmt::print("Connection lost\n"); ok = false; break; }
+		std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - sent;
+		latencies[kind].Samples.push_back(elapsed.count());
+
+		// Ids of duplicate names and indices of objects with the same full name may differ, so only the strings are checked
+		bool right = status() == QueryStatus::Ok;
+		switch (kind)
+		{
+		case 0: right = right && response.GetString() == name.second; break;
+		case 1: right = right && response.Get<uint32_t>() < (1u << 29); break;
+		case 2:
+		case 3: right = right && (response.Get<uint32_t>(), response.Get<uint64_t>(), response.Get<uint64_t>(), response.GetString() == object.second); break;
+		case 4: right = right && response.Get<int32_t>() >= 0; break;
+		case 5: right = right && response.Get<uint32_t>() > 0 && response.GetString() == type.second; break;
+		}
+		if (!right) { latencies[kind].Failures++; ok = false; }
+	}
+
+	fmt::print("{:<14} {:>8} {:>10} {:>10} {:>10} {:>9}\n", "query", "count", "p50 us", "p99 us", "max us", "failures");
+	double worst = 0;
+	for (auto& latency : latencies)
+	{
+		auto count = latency.Samples.size();
+		auto p50 = Percentile(latency.Samples, 0.5);
+		auto p99 = Percentile(latency.Samples, 0.99);
+		auto max = count ? *std::max_element(latency.Samples.begin(), latency.Samples.end()) : 0;
+		worst = std::max(worst, p99);
+		fmt::print("{:<14} {:>8} {:>10.1f} {:>10.1f} {:>10.1f} {:>9}\n", latency.Name, count, p50, p99, max, latency.Failures);
+	}
+	fmt::print("Worst p99 {:.1f} us, {} the 1 ms target\n", worst, worst < 1000 ? "within" : "over");
+
+	client.Close();
+	server.Stop();
+	serving.join();
+	if (!served) { fmt::print("Can't serve on {}\n", endpoint); ok = false; }
+	return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,80 @@
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "fixture.h"
+#include "../Dumper/profiles.h"
+#include "../Dumper/snapshot.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+/*
+* Stand-in for a game process, maps a fixture at its base address and keeps it until stdin is closed.
+* The dumper attaches to it with ReaderInit(pid) and reads it like a game.
+* Prints "<pid> <base> <module size> <ObjObjects> <NamePoolData>" once the image is mapped, offsets are from the base.
+* With '--snapshot' the fixture is saved as a snapshot that the dumper opens instead of a process, nothing is mapped then.
+* Usage: Target [--snapshot <file>] [objects] [DeadByDaylight|RogueCompany] [seed]
+*/
+
+static void* Map(uint64_t base, size_t size)
+{
+#ifdef _WIN32
+	return VirtualAlloc(reinterpret_cast<void*>(base), size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+	auto mapped = mmap(reinterpret_cast<void*>(base), size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+	return mapped == MAP_FAILED || mapped != reinterpret_cast<void*>(base) ? nullptr : mapped;
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+	const char* snapshot = nullptr;
+	if (argc > 2 && !strcmp(argv[1], "--snapshot"))
+	{
+		snapshot = argv[2];
+		argc -= 2;
+		argv += 2;
+	}
+	uint32_t objects = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], nullptr, 10)) : 100000;
+	std::string profile = argc > 2 ? argv[2] : "DeadByDaylight";
+	uint64_t seed = argc > 3 ? strtoull(argv[3], nullptr, 10) : 1;
+
+	Offsets offsets;
+	if (profile == "DeadByDaylight") { offsets = std::bit_cast<Offsets>(DeadByDaylight{}); }
+	else if (profile == "RogueCompany") { offsets = std::bit_cast<Offsets>(RogueCompany{}); }
+	else { fprintf(stderr, "Unknown profile %s\n", profile.c_str()); return EXIT_FAILURE; }
+
+	auto fixture = GenerateFixture(offsets, objects, seed);
+	if (snapshot)
+	{
+		// Game name selects the same profile in the dumper
+		auto game = profile == "DeadByDaylight" ? "DeadByDaylight-Win64-Shipping" : profile;
+		if (!SaveSnapshot(snapshot, { fixture.Base, fixture.Base, fixture.ModuleSize, game, std::move(fixture.Image) }))
+		{
+			fprintf(stderr, "Can't write %s\n", snapshot);
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+	auto image = Map(fixture.Base, fixture.Image.size());
+	if (!image) { fprintf(stderr, "Can't map the image at 0x%llX\n", static_cast<unsigned long long>(fixture.Base)); return EXIT_FAILURE; }
+	memcpy(image, fixture.Image.data(), fixture.Image.size());
+	fixture.Image = {};
+
+#ifdef _WIN32
+	auto pid = GetCurrentProcessId();
+#else
+	auto pid = getpid();
+#endif
+	printf("%lu 0x%llX 0x%X 0x%llX 0x%llX\n", static_cast<unsigned long>(pid), static_cast<unsigned long long>(fixture.Base), fixture.ModuleSize,
+		static_cast<unsigned long long>(fixture.ObjObjects), static_cast<unsigned long long>(fixture.NamePoolData));
+	fflush(stdout);
+
+	while (getchar() != EOF) {}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,110 @@
+#include "archive.h"
+#include <cstring>
+#include <memory>
+
+static constexpr char ArchiveMagic[4] = { 'U', 'S', 'D', 'K' };
+static constexpr uint32_t ArchiveVersion = 1;
+
+ArchiveWriter::ArchiveWriter(const fs::path& path)
+{
+	fopen_s(&file, path.string().c_str(), "wb");
+	if (!file) { return; }
+	if (!(Put(ArchiveMagic, sizeof(ArchiveMagic)) && Put(&ArchiveVersion, sizeof(ArchiveVersion)))) { fclose(file); file = nullptr; }
+}
+
+bool ArchiveWriter::Put(const void* data, size_t size)
+{
+	if (fwrite(data, 1, size, file) != size) { return false; }
+	offset += size;
+	return true;
+}
+
+bool ArchiveWriter::Add(std::string name, const char* data, size_t size)
+{
+	if (!file) { return false; }
+	toc.push_back({ std::move(name), offset, size });
+	return Put(data, size);
+}
+
+bool ArchiveWriter::Close()
+{
+	if (!file) { return false; }
+	uint64_t tocOffset = offset;
+	bool written = true;
+	for (auto& entry : toc)
+	{
+		uint32_t length = static_cast<uint32_t>(entry.Name.size());
+		written &= Put(&entry.Offset, sizeof(entry.Offset)) && Put(&entry.Size, sizeof(entry.Size)) && Put(&length, sizeof(length)) && Put(entry.Name.data(), length);
+	}
+	uint32_t count = static_cast<uint32_t>(toc.size());
+	written &= Put(&tocOffset, sizeof(tocOffset)) && Put(&count, sizeof(count)) && Put(ArchiveMagic, sizeof(ArchiveMagic));
+	written &= fclose(file) == 0;
+	file = nullptr;
+	return written;
+}
+
+bool ExtractArchive(const fs::path& path, const fs::path& dir)
+{
+	FILE* raw = nullptr;
+	fopen_s(&raw, path.string().c_str(), "rb");
+	if (!raw) { return false; }
+	std::unique_ptr<FILE, decltype(&fclose)> file(raw, &fclose);
+	std::error_code error;
+	auto fileSize = fs::file_size(path, error);
+	if (error) { return false; }
+
+	auto read = [&file](void* data, size_t size) { return fread(data, 1, size, file.get()) == size; };
+
+	char magic[4]{};
+	uint32_t version = 0;
+	if (!read(magic, sizeof(magic)) || memcmp(magic, ArchiveMagic, sizeof(magic)) || !read(&version, sizeof(version)) || version != ArchiveVersion) { return false; }
+
+	uint64_t tocOffset = 0;
+	uint32_t count = 0;
+	if (_fseeki64(file.get(), -16, SEEK_END) || !read(&tocOffset, sizeof(tocOffset)) || !read(&count, sizeof(count)) || !read(magic, sizeof(magic))) { return false; }
+	if (memcmp(magic, ArchiveMagic, sizeof(magic)) || tocOffset > fileSize) { return false; }
+
+	struct Entry
+	{
+		uint64_t Offset;
+		uint64_t Size;
+		fs::path Name;
+	};
+	// An entry takes at least 20 bytes of the table
+	if (count > (fileSize - tocOffset) / 20) { return false; }
+	std::vector<Entry> toc(count);
+	if (_fseeki64(file.get(), tocOffset, SEEK_SET)) { return false; }
+	for (auto& entry : toc)
+	{
+		uint32_t length = 0;
+		if (!(read(&entry.Offset, sizeof(entry.Offset)) && read(&entry.Size, sizeof(entry.Size)) && read(&length, sizeof(length)))) { return false; }
+		// Payload has to be inside the archive, so a broken entry can't make the reader allocate its size
+		if (entry.Offset > tocOffset || entry.Size > tocOffset - entry.Offset || length > fileSize - tocOffset) { return false; }
+		std::string name(length, '\0');
+		if (!read(name.data(), length)) { return false; }
+
+		// Names can't leave 'dir', neither rooted nor through '..', checked before anything is written
+		entry.Name = fs::path(name).lexically_normal();
+		if (entry.Name.empty() || entry.Name.has_root_path() || *entry.Name.begin() == "..") { return false; }
+	}
+
+	// Payloads are read in the order they were stored, so the archive is still read sequentially
+	std::vector<char> data;
+	for (auto& entry : toc)
+	{
+		auto target = dir / entry.Name;
+		fs::create_directories(target.parent_path());
+		data.resize(entry.Size);
+		if (_fseeki64(file.get(), entry.Offset, SEEK_SET) || !read(data.data(), data.size())) { return false; }
+
+		// Text mode like the files written by the dumper itself
+		FILE* out = nullptr;
+		fopen_s(&out, target.string().c_str(), "w");
+		if (!out) { return false; }
+		bool written = fwrite(data.data(), 1, data.size(), out) == data.size();
+		fclose(out);
+		if (!written) { return false; }
+	}
+
+	return true;
+}
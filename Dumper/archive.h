@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "platform.h"
+
+namespace fs = std::filesystem;
+
+/*
+* SDK archive layout, every field is little endian:
+* Header { char Magic[4]; uint32_t Version; }
+* Payloads stored back to back in the order they were added
+* Table of contents, for each entry { uint64_t Offset; uint64_t Size; uint32_t NameLength; char Name[NameLength]; }
+* Footer { uint64_t TocOffset; uint32_t Count; char Magic[4]; }
+* Table of contents goes last, so the archive is written sequentially with one file handle.
+*/
+class ArchiveWriter
+{
+private:
+	struct Entry
+	{
+		std::string Name;
+		uint64_t Offset;
+		uint64_t Size;
+	};
+	FILE* file = nullptr;
+	uint64_t offset = 0;
+	std::vector<Entry> toc;
+	bool Put(const void* data, size_t size);
+public:
+	ArchiveWriter(const fs::path& path);
+	~ArchiveWriter() { Close(); }
+	operator bool() const { return file != nullptr; }
+	// Appends payload, 'name' is relative path that is restored on extraction
+	bool Add(std::string name, const char* data, size_t size);
+	// Writes table of contents and closes the archive
+	bool Close();
+};
+
+// Restores per-package files of the archive into 'dir'
+bool ExtractArchive(const fs::path& path, const fs::path& dir);
@@ -0,0 +1,126 @@
+#include "batch.h"
+#include "trace.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+
+bool LoadBatch(const fs::path& path, std::vector<BatchTarget>& targets)
+{
+	std::ifstream file(path);
+	if (!file) { return false; }
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream fields(line);
+		std::string kind, value;
+		if (!(fields >> kind) || kind[0] == '#') { continue; }
+		// Paths with spaces are quoted
+		fields >> std::ws;
+		if (fields.peek() == '"')
+		{
+			fields.get();
+			if (!std::getline(fields, value, '"') || fields.eof()) { return false; }
+		}
+		else { fields >> value; }
+		if (value.empty()) { return false; }
+		BatchTarget target;
+		if (kind == "pid")
+		{
+			target.Pid = static_cast<uint32_t>(strtoul(value.c_str(), nullptr, 10));
+			if (!target.Pid) { return false; }
+		}
+		else if (kind == "snapshot") { target.Snapshot = value; }
+		else { return false; }
+		fields >> target.Engine;
+		targets.push_back(std::move(target));
+	}
+	return true;
+}
+
+std::vector<BatchResult> RunBatch(const std::vector<BatchTarget>& targets, const fs::path& root, uint32_t threads, uint32_t parts, bool incremental, const Dumper::Log& log)
+{
+	std::vector<BatchResult> results(targets.size());
+	if (targets.empty()) { return results; }
+	threads = std::max(1u, threads);
+	auto concurrent = std::min<uint32_t>(threads, static_cast<uint32_t>(targets.size()));
+	auto workers = std::max(1u, threads / concurrent);
+
+	SharedScans scans;
+	std::mutex mutex;
+	std::condition_variable named;
+	std::unordered_set<std::string> names;
+	size_t reserved = 0;
+	std::atomic<size_t> next = 0;
+	// Names are taken in the order of the targets, so repeated names get the same suffixes on every run.
+	// Targets that failed to open take no name, but still let the next ones take theirs.
+	auto reserve = [&](size_t target, const std::string& name)
+	{
+		std::unique_lock lock(mutex);
+		named.wait(lock, [&]() { return reserved == target; });
+		auto unique = name;
+		for (auto i = 2; name.size() && !names.insert(unique).second; i++) { unique = fmt::format("{}-{}", name, i); }
+		reserved++;
+		named.notify_all();
+		return unique;
+	};
+
+	auto run = [&](uint32_t lane)
+	{
+		TraceThread(fmt::format("Target {}", lane));
+		for (size_t i; (i = next++) < targets.size();)
+		{
+			auto& target = targets[i];
+			auto& result = results[i];
+			auto label = target.Snapshot.empty() ? fmt::format("pid {}", target.Pid) : target.Snapshot.filename().string();
+			auto begin = std::chrono::steady_clock::now();
+
+			// Progress that replaces itself can't be told apart between targets, so only whole lines are passed on, with the target
+			std::string pending;
+			auto print = [&log, &label, &pending](const std::string& text)
+			{
+				if (!log || (text.size() && text[0] == '\r')) { return; }
+				pending += text;
+				for (size_t end; (end = pending.find('\n')) != std::string::npos; pending.erase(0, end + 1))
+				{
+					if (end) { log(fmt::format("[{}] {}\n", label, std::string_view(pending).substr(0, end))); }
+				}
+			};
+			Dumper dumper;
+			dumper.SetLog(print);
+			dumper.SetThreads(workers);
+			dumper.SetIncremental(incremental);
+			dumper.SetSharedScans(&scans);
+			dumper.SetEngine(target.Engine);
+			TraceScope trace("Target");
+			if (trace) { trace.Detail(label); }
+			result.Status = target.Snapshot.empty() ? dumper.Open(target.Pid, root) : dumper.OpenSnapshot(target.Snapshot, root);
+			result.Name = reserve(i, result.Status != SUCCESS ? std::string() : target.Snapshot.empty() ? dumper.GetGame() : target.Snapshot.stem().string());
+			if (result.Status == SUCCESS)
+			{
+				auto directory = root / result.Name;
+				Writer writer;
+				Writer::Prepare(directory);
+				if (parts & Dumper::Packages) { Writer::Prepare(directory / "DUMP"); }
+				result.Status = dumper.Dump(writer, directory, parts);
+				auto failed = writer.Close();
+				for (auto& path : failed) { print(fmt::format("Can't write: {}\n", path.string())); }
+				if (failed.size() && result.Status == SUCCESS) { result.Status = FILE_NOT_OPEN; }
+			}
+			if (result.Name.empty()) { result.Name = label; }
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+			result.Seconds = elapsed.count();
+			print(fmt::format("\n{} in {:.2f} s\n", GetStatusMessage(result.Status), result.Seconds));
+		}
+	};
+
+	// Every target is opened and dumped on one thread, its helpers run in its context
+	std::vector<std::thread> lanes;
+	for (auto i = 0u; i < concurrent; i++) { lanes.emplace_back(run, i); }
+	for (auto& lane : lanes) { lane.join(); }
+	return results;
+}
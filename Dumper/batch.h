@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "dumper.h"
+
+namespace fs = std::filesystem;
+
+// One game of a batch, a running process or a snapshot of one
+struct BatchTarget
+{
+	uint32_t Pid = 0;
+	fs::path Snapshot;
+	// Engine profile, e.g. "DeadByDaylight", the game's own if it's empty
+	std::string Engine;
+};
+
+struct BatchResult
+{
+	// Name of the output directory, e.g. the game or the snapshot file
+	std::string Name;
+	int Status = FAILED;
+	double Seconds = 0;
+};
+
+/*
+* Reads the list of targets, one per line: 'pid <id> [engine]' or 'snapshot <path> [engine]'.
+* Paths with spaces are written in double quotes, e.g. 'snapshot "C:\My Dumps\game.snap" RogueCompany'.
+* Empty lines and lines starting with '#' are skipped, fails on any other line.
+*/
+bool LoadBatch(const fs::path& path, std::vector<BatchTarget>& targets);
+
+/*
+* Dumps the targets concurrently, each one into its own '<root>/<name>', and caches their offsets in 'root' like the executable.
+* 'threads' is the budget of the whole batch: up to that many targets are dumped at once, and their package workers split it.
+* Snapshots are named after their files and processes after their games, repeated names get a '-<n>' suffix in the order of the targets.
+* Targets of the same build share scan results, results come in the order of the targets.
+* With 'incremental' only packages that changed since the last batch are generated, see 'Dumper::SetIncremental'.
+*/
+std::vector<BatchResult> RunBatch(const std::vector<BatchTarget>& targets, const fs::path& root, uint32_t threads, uint32_t parts, bool incremental, const Dumper::Log& log);
@@ -0,0 +1,109 @@
+#include "cache.h"
+#include "memory.h"
+#include "pe.h"
+#include "platform.h"
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+
+static uint64_t Hash(const uint8_t* data, size_t size)
+{
+	// FNV-1a
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (size_t i = 0; i < size; i++) { hash = (hash ^ data[i]) * 0x100000001B3ull; }
+	return hash;
+}
+
+bool GetModuleIdentity(uint8_t* base, ModuleIdentity& identity)
+{
+	// Headers always fit into the first page of the image
+	uint8_t headers[ImageHeadersSize]{};
+	if (!Read(base, headers, sizeof(headers))) { return false; }
+	ImageHeaders fields;
+	if (!ParseHeaders(headers, sizeof(headers), fields)) { return false; }
+
+	identity.TimeDateStamp = fields.TimeDateStamp;
+	identity.SizeOfImage = fields.SizeOfImage;
+	auto size = fields.SizeOfHeaders < sizeof(headers) ? fields.SizeOfHeaders : sizeof(headers);
+	identity.HeaderHash = Hash(headers, size);
+	return true;
+}
+
+bool LoadScanCache(const fs::path& path, const ModuleIdentity& identity, ScanCache& cache)
+{
+	FILE* raw = nullptr;
+	fopen_s(&raw, path.string().c_str(), "r");
+	if (!raw) { return false; }
+	std::unique_ptr<FILE, decltype(&fclose)> file(raw, &fclose);
+
+	ScanCache loaded;
+	auto& module = loaded.Module;
+	auto read = fscanf_s(file.get(), "TimeDateStamp %" SCNx32 "\nSizeOfImage %" SCNx32 "\nHeaderHash %" SCNx64 "\nObjObjects %" SCNx64 "\nNamePoolData %" SCNx64 "\n",
+		&module.TimeDateStamp, &module.SizeOfImage, &module.HeaderHash, &loaded.ObjObjects, &loaded.NamePoolData);
+	if (read != 5 || !(module == identity)) { return false; }
+	cache = loaded;
+	return true;
+}
+
+bool SaveScanCache(const fs::path& path, const ScanCache& cache)
+{
+	FILE* file = nullptr;
+	fopen_s(&file, path.string().c_str(), "w");
+	if (!file) { return false; }
+	auto& module = cache.Module;
+	bool written = fprintf(file, "TimeDateStamp %" PRIx32 "\nSizeOfImage %" PRIx32 "\nHeaderHash %" PRIx64 "\nObjObjects %" PRIx64 "\nNamePoolData %" PRIx64 "\n",
+		module.TimeDateStamp, module.SizeOfImage, module.HeaderHash, cache.ObjObjects, cache.NamePoolData) > 0;
+	return (fclose(file) == 0) && written;
+}
+
+// Profile is the raw module identity, size of 'Offsets' and the offsets themselves, so a changed layout of 'Offsets' invalidates it
+bool LoadProfile(const fs::path& path, const ModuleIdentity& identity, Offsets& offsets)
+{
+	FILE* raw = nullptr;
+	fopen_s(&raw, path.string().c_str(), "rb");
+	if (!raw) { return false; }
+	std::unique_ptr<FILE, decltype(&fclose)> file(raw, &fclose);
+
+	ModuleIdentity module;
+	uint32_t size = 0;
+	Offsets loaded;
+	if (fread(&module, sizeof(module), 1, file.get()) != 1 || !(module == identity)) { return false; }
+	if (fread(&size, sizeof(size), 1, file.get()) != 1 || size != sizeof(Offsets)) { return false; }
+	if (fread(&loaded, sizeof(loaded), 1, file.get()) != 1) { return false; }
+	offsets = loaded;
+	return true;
+}
+
+bool SaveProfile(const fs::path& path, const ModuleIdentity& identity, const Offsets& offsets)
+{
+	FILE* file = nullptr;
+	fopen_s(&file, path.string().c_str(), "wb");
+	if (!file) { return false; }
+	uint32_t size = sizeof(Offsets);
+	bool written = fwrite(&identity, sizeof(identity), 1, file) == 1 && fwrite(&size, sizeof(size), 1, file) == 1 && fwrite(&offsets, sizeof(offsets), 1, file) == 1;
+	return (fclose(file) == 0) && written;
+}
+
+std::shared_ptr<SharedScans::Entry> SharedScans::Get(const ModuleIdentity& identity)
+{
+	std::lock_guard lock(mutex);
+	for (auto& [module, entry] : entries)
+	{
+		if (module == identity) { return entry; }
+	}
+	return entries.emplace_back(identity, std::make_shared<Entry>()).second;
+}
+
+std::unique_lock<std::mutex> SharedScans::LockGame(const std::string& game)
+{
+	std::mutex* found = nullptr;
+	{
+		std::lock_guard lock(mutex);
+		for (auto& [name, gameMutex] : games)
+		{
+			if (name == game) { found = gameMutex.get(); break; }
+		}
+		if (!found) { found = games.emplace_back(game, std::make_unique<std::mutex>()).second.get(); }
+	}
+	return std::unique_lock(*found);
+}
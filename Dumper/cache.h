@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "engine.h"
+
+namespace fs = std::filesystem;
+
+// Identifies build of the module, any rebuild or patch changes at least one of the fields
+struct ModuleIdentity
+{
+	uint32_t TimeDateStamp = 0;
+	uint32_t SizeOfImage = 0;
+	uint64_t HeaderHash = 0;
+	bool operator==(const ModuleIdentity&) const = default;
+};
+
+// Results of the signature scan as offsets from the module base
+struct ScanCache
+{
+	ModuleIdentity Module;
+	uint64_t ObjObjects = 0;
+	uint64_t NamePoolData = 0;
+};
+
+// Reads PE headers of the module loaded at 'base' in the target process
+bool GetModuleIdentity(uint8_t* base, ModuleIdentity& identity);
+// Loads cache, fails if there's no cache or it was saved for another build of the module
+bool LoadScanCache(const fs::path& path, const ModuleIdentity& identity, ScanCache& cache);
+bool SaveScanCache(const fs::path& path, const ScanCache& cache);
+// Offsets inferred for a build of the module, loading fails if the profile was saved for another build
+bool LoadProfile(const fs::path& path, const ModuleIdentity& identity, Offsets& offsets);
+bool SaveProfile(const fs::path& path, const ModuleIdentity& identity, const Offsets& offsets);
+
+/*
+* Scan results shared by the dumpers of one process, e.g. in batch mode, so every build of a module is scanned once.
+* A dumper holds the entry of its module while it attaches, so dumpers of the same build wait for it and reuse what it found.
+* Dumpers of one game also attach one at a time, as they share the files of its cache.
+*/
+class SharedScans
+{
+public:
+	struct Entry
+	{
+		std::mutex Mutex;
+		bool Found = false;
+		ScanCache Cache;
+		// Offsets inferred for the build, if it has no profile
+		bool Inferred = false;
+		Offsets Profile;
+	};
+	std::shared_ptr<Entry> Get(const ModuleIdentity& identity);
+	std::unique_lock<std::mutex> LockGame(const std::string& game);
+private:
+	std::mutex mutex;
+	// A batch has a few dozen builds at most
+	std::vector<std::pair<ModuleIdentity, std::shared_ptr<Entry>>> entries;
+	std::vector<std::pair<std::string, std::unique_ptr<std::mutex>>> games;
+};
@@ -0,0 +1,33 @@
+#include "context.h"
+
+std::shared_ptr<const Context> CaptureContext()
+{
+	auto context = std::make_shared<Context>();
+	context->Reader = GetReaderTarget();
+#ifndef DUMPER_PROFILE
+	context->Defs = defs;
+#endif
+	context->Objects = ObjObjects;
+	context->Names = NamePoolData;
+	context->Classes = Classes;
+	return context;
+}
+
+void BindContext(const Context& context)
+{
+	SetReaderTarget(context.Reader);
+#ifndef DUMPER_PROFILE
+	defs = context.Defs;
+#endif
+	ObjObjects = context.Objects;
+	NamePoolData = context.Names;
+	Classes = context.Classes;
+}
+
+void ResetContext()
+{
+	ReaderClose();
+	ObjObjects = {};
+	NamePoolData = {};
+	Classes = {};
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <memory>
+#include <thread>
+#include <utility>
+#include "memory.h"
+#include "wrappers.h"
+
+/*
+* Everything a dump reads through: the reader's target, engine offsets, globals of the game and its core classes.
+* All of it is thread-local, so every thread can attach to its own game and several games can be dumped in one process.
+* Threads that help with a dump run in the context of the thread that started them, see 'ContextThread'.
+*/
+struct Context
+{
+	ReaderTarget Reader;
+#ifndef DUMPER_PROFILE
+	Offsets Defs;
+#endif
+	TUObjectArray Objects;
+	FNamePool Names;
+	CoreClasses Classes;
+};
+
+// Copies the context of the calling thread, classes that it resolved so far are shared with the helpers
+std::shared_ptr<const Context> CaptureContext();
+void BindContext(const Context& context);
+// Forgets the target of the calling thread, e.g. before it attaches to another game
+void ResetContext();
+
+// Starts a thread that runs 'fn' in the context of the calling thread
+template<typename Fn>
+std::thread ContextThread(Fn&& fn)
+{
+	return std::thread([context = CaptureContext(), fn = std::forward<Fn>(fn)]() mutable
+	{
+		BindContext(*context);
+		fn();
+	});
+}
@@ -0,0 +1,522 @@
+#include "daemon.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <thread>
+#include "memory.h"
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+static size_t Hash(std::string_view str)
+{
+	return std::hash<std::string_view>{}(str);
+}
+
+// Generations are unique across indices, so a thread can tell if its globals are of the current one
+static std::atomic<uint64_t> generations = 0;
+static thread_local uint64_t bound = 0;
+
+QueryIndex::QueryIndex(byte* objects, byte* names) : objectsAddress(objects), namesAddress(names), context(*CaptureContext())
+{
+	bound = generation = ++generations;
+	Refresh();
+}
+
+void QueryIndex::Bind()
+{
+	if (bound == generation) { return; }
+	BindContext(context);
+	bound = generation;
+}
+
+void QueryIndex::AddName(std::string_view name, uint32_t id)
+{
+	auto [it, added] = names.try_emplace(id, name);
+	if (!added) { return; }
+	nameIds.emplace(Hash(name), id);
+}
+
+void QueryIndex::IndexObject(uint32_t index, byte* address)
+{
+	if (index >= objects.size()) { objects.resize(index + 1); }
+	auto& slot = objects[index];
+	if (slot.Address)
+	{
+		auto [begin, end] = objectIds.equal_range(Hash(slot.FullName));
+		for (auto it = begin; it != end; ++it)
+		{
+			if (it->second == index) { objectIds.erase(it); break; }
+		}
+		addresses.erase(slot.Address);
+		layouts.erase(slot.Address);
+	}
+	slot = {};
+
+	UE_UObject object = address;
+	if (!object) { return; }
+	slot.Address = object;
+	slot.Class = object.GetClass();
+	slot.FullName = object.GetFullName();
+	if (object.IsA<UE_UStruct>())
+	{
+		slot.Struct = true;
+		slot.Super = object.Cast<UE_UStruct>().GetSuper();
+	}
+	objectIds.emplace(Hash(slot.FullName), index);
+	addresses[slot.Address] = index;
+}
+
+std::pair<uint32_t, uint32_t> QueryIndex::Refresh()
+{
+	refreshed = std::chrono::steady_clock::now();
+	refreshes++;
+	std::pair<uint32_t, uint32_t> found;
+
+	// Only the header of the pool changes when names are added, blocks are read from the last known one
+	if (Read(namesAddress + offsetof(FNamePool, CurrentBlock), &NamePoolData.CurrentBlock, sizeof(uint32_t) * 2, ReadTag::Name) && NamePoolData.CurrentBlock < std::size(NamePoolData.Blocks) && NamePoolData.CurrentBlock >= namesBlock)
+	{
+		auto count = NamePoolData.CurrentBlock - namesBlock + 1;
+		if (Read(namesAddress + offsetof(FNamePool, Blocks) + namesBlock * sizeof(byte*), &NamePoolData.Blocks[namesBlock], count * sizeof(byte*), ReadTag::Name))
+		{
+			auto before = names.size();
+			NamePoolData.DumpSince(namesBlock, namesCursor, [this](std::string_view name, uint32_t id) { AddName(name, id); });
+			found.first = static_cast<uint32_t>(names.size() - before);
+			namesBlock = NamePoolData.CurrentBlock;
+			namesCursor = NamePoolData.CurrentByteCursor;
+		}
+	}
+
+	// Items are read a chunk at a time, new slots and slots whose object was freed or replaced are indexed
+	if (Read(objectsAddress, &ObjObjects, sizeof(ObjObjects), ReadTag::Object))
+	{
+		auto before = static_cast<uint32_t>(objects.size());
+		std::vector<byte*> chunks(std::min(ObjObjects.NumChunks, (ObjObjects.NumElements + TUObjectArray::ObjectsPerChunk - 1) / TUObjectArray::ObjectsPerChunk));
+		std::vector<uint8_t> items;
+		// Chunks that can't be read are left as they were, a failed read doesn't empty their slots
+		if (chunks.empty() || !Read(ObjObjects.Objects, chunks.data(), chunks.size() * sizeof(byte*), ReadTag::Object)) { chunks.clear(); }
+		for (uint32_t chunk = 0; chunk < chunks.size(); chunk++)
+		{
+			auto first = chunk * TUObjectArray::ObjectsPerChunk;
+			auto count = std::min(TUObjectArray::ObjectsPerChunk, ObjObjects.NumElements - first);
+			items.resize(static_cast<size_t>(count) * defs.FUObjectItem.Size);
+			if (!chunks[chunk] || !Read(chunks[chunk], items.data(), items.size(), ReadTag::Object)) { continue; }
+			for (uint32_t i = 0; i < count; i++)
+			{
+				byte* address;
+				memcpy(&address, items.data() + static_cast<size_t>(i) * defs.FUObjectItem.Size + defs.FUObjectItem.Object, sizeof(address));
+				if (first + i >= objects.size() || objects[first + i].Address != address) { IndexObject(first + i, address); }
+			}
+		}
+		if (ObjObjects.NumElements > before) { found.second = ObjObjects.NumElements - before; }
+	}
+
+	// Globals of this thread are the newest now, other threads take them on their next query
+	context.Objects = ObjObjects;
+	context.Names = NamePoolData;
+	context.Classes = Classes;
+	bound = generation = ++generations;
+	return found;
+}
+
+void QueryIndex::RefreshIfStale()
+{
+	if (std::chrono::steady_clock::now() - refreshed >= RefreshInterval) { Refresh(); }
+}
+
+bool QueryIndex::Validate(uint32_t index)
+{
+	if (index >= objects.size()) { return false; }
+	// Freed slots are reused, so the slot has to point to the same object
+	if (auto address = ObjObjects.GetObjectPtr(index); address != objects[index].Address) { IndexObject(index, address); }
+	return objects[index].Address != nullptr;
+}
+
+int64_t QueryIndex::FindName(std::string_view name) const
+{
+	auto [begin, end] = nameIds.equal_range(Hash(name));
+	for (auto it = begin; it != end; ++it)
+	{
+		if (names.at(it->second) == name) { return it->second; }
+	}
+	return -1;
+}
+
+int64_t QueryIndex::FindObject(std::string_view fullName) const
+{
+	auto [begin, end] = objectIds.equal_range(Hash(fullName));
+	for (auto it = begin; it != end; ++it)
+	{
+		if (objects[it->second].FullName == fullName) { return it->second; }
+	}
+	return -1;
+}
+
+const QueryIndex::Layout& QueryIndex::GetLayout(byte* address)
+{
+	auto [it, added] = layouts.try_emplace(address);
+	auto& layout = it->second;
+	if (!added) { return layout; }
+
+	UE_UStruct object(address);
+	layout.Size = object.GetSize();
+	if (auto super = object.GetSuper())
+	{
+		layout.Super = super.GetFullName();
+		layout.Inherited = super.GetSize();
+	}
+	for (auto prop = object.GetChildProperties().Cast<UE_FProperty>(); prop; prop = prop.GetNext().Cast<UE_FProperty>())
+	{
+		auto type = prop.GetType();
+		Member m{ prop.GetName(), type.second, prop.GetOffset(), prop.GetSize(), prop.GetArrayDim(), 0 };
+		if (type.first == PropertyType::BoolProperty && type.second != "bool") { m.FieldMask = prop.Cast<UE_FBoolProperty>().GetFieldMask(); }
+		layout.Members.push_back(std::move(m));
+	}
+	return layout;
+}
+
+void QueryIndex::PutObject(MessageWriter& response, uint32_t index) const
+{
+	auto& object = objects[index];
+	response.Put(index).Put(reinterpret_cast<uint64_t>(object.Address)).Put(reinterpret_cast<uint64_t>(object.Class)).PutString(object.FullName);
+}
+
+void QueryIndex::Handle(MessageReader request, MessageWriter& response)
+{
+	std::lock_guard lock(mutex);
+	queries++;
+	Bind();
+	RefreshIfStale();
+
+	auto op = request.Get<QueryOp>();
+	auto fail = [&response](QueryStatus status) { response.Clear(); response.Put(status); };
+	// Finds the object given by index or full name, refreshing once on a miss, -1 if there's none
+	auto index = [&]() -> int64_t
+	{
+		if (op == QueryOp::ObjectByIndex)
+		{
+			auto id = request.Get<uint32_t>();
+			if (!request) { return -1; }
+			if (id >= objects.size()) { Refresh(); }
+			return Validate(id) ? id : -1;
+		}
+		auto name = request.GetString();
+		if (!request) { return -1; }
+		auto found = FindObject(name);
+		if (found < 0) { Refresh(); found = FindObject(name); }
+		if (found >= 0 && !Validate(static_cast<uint32_t>(found))) { found = FindObject(name); }
+		return found;
+	};
+
+	response.Put(QueryStatus::Ok);
+	switch (op)
+	{
+	case QueryOp::Ping:
+		break;
+	case QueryOp::NameById:
+	{
+		auto id = request.Get<uint32_t>();
+		if (!request) { break; }
+		auto it = names.find(id);
+		if (it == names.end()) { Refresh(); it = names.find(id); }
+		if (it == names.end()) { fail(QueryStatus::NotFound); break; }
+		response.PutString(it->second);
+		break;
+	}
+	case QueryOp::IdByName:
+	{
+		auto name = request.GetString();
+		if (!request) { break; }
+		auto id = FindName(name);
+		if (id < 0) { Refresh(); id = FindName(name); }
+		if (id < 0) { fail(QueryStatus::NotFound); break; }
+		response.Put(static_cast<uint32_t>(id));
+		break;
+	}
+	case QueryOp::ObjectByIndex:
+	case QueryOp::FindObject:
+	{
+		auto found = index();
+		if (!request) { break; }
+		if (found < 0) { fail(QueryStatus::NotFound); break; }
+		PutObject(response, static_cast<uint32_t>(found));
+		break;
+	}
+	case QueryOp::StructLayout:
+	{
+		auto found = index();
+		if (!request) { break; }
+		if (found < 0 || !objects[found].Struct) { fail(QueryStatus::NotFound); break; }
+		auto& layout = GetLayout(objects[found].Address);
+		response.Put(layout.Size).Put(layout.Inherited).PutString(layout.Super).Put(static_cast<uint32_t>(layout.Members.size()));
+		for (auto& m : layout.Members)
+		{
+			response.PutString(m.Name).PutString(m.Type).Put(m.Offset).Put(m.Size).Put(m.ArrayDim).Put(m.FieldMask);
+		}
+		break;
+	}
+	case QueryOp::Hierarchy:
+	{
+		auto found = index();
+		if (!request) { break; }
+		if (found < 0 || !objects[found].Struct) { fail(QueryStatus::NotFound); break; }
+		std::vector<std::string> chain{ objects[found].FullName };
+		// Supers that aren't indexed yet are read from the process, the depth is bounded in case of a cycle in broken memory
+		for (auto super = objects[found].Super; super && chain.size() < 256;)
+		{
+			auto it = addresses.find(super);
+			if (it != addresses.end())
+			{
+				chain.push_back(objects[it->second].FullName);
+				super = objects[it->second].Super;
+			}
+			else
+			{
+				UE_UStruct object(super);
+				chain.push_back(object.GetFullName());
+				super = object.GetSuper();
+			}
+		}
+		response.Put(static_cast<uint32_t>(chain.size()));
+		for (auto& name : chain) { response.PutString(name); }
+		break;
+	}
+	case QueryOp::Refresh:
+	{
+		auto [newNames, newObjects] = Refresh();
+		response.Put(newNames).Put(newObjects);
+		break;
+	}
+	case QueryOp::Stats:
+		response.Put(static_cast<uint32_t>(names.size())).Put(static_cast<uint32_t>(objects.size())).Put(static_cast<uint32_t>(layouts.size())).Put(refreshes).Put(queries);
+		break;
+	default:
+		fail(QueryStatus::BadRequest);
+		break;
+	}
+	if (!request || !request.AtEnd()) { fail(QueryStatus::BadRequest); }
+}
+
+// Connections are file descriptors on Linux and pipe handles on Windows
+static bool Transfer(intptr_t connection, void* data, size_t size, bool send)
+{
+	auto it = static_cast<char*>(data);
+	while (size)
+	{
+#ifdef _WIN32
+		DWORD done = 0;
+		auto chunk = static_cast<DWORD>(std::min<size_t>(size, 1 << 20));
+		auto ok = send ? WriteFile(reinterpret_cast<HANDLE>(connection), it, chunk, &done, nullptr) : ReadFile(reinterpret_cast<HANDLE>(connection), it, chunk, &done, nullptr);
+		if (!ok || !done) { return false; }
+#else
+		auto done = send ? ::send(static_cast<int>(connection), it, size, MSG_NOSIGNAL) : recv(static_cast<int>(connection), it, size, 0);
+		if (done < 0 && errno == EINTR) { continue; }
+		if (done <= 0) { return false; }
+#endif
+		it += done;
+		size -= done;
+	}
+	return true;
+}
+
+static bool Send(intptr_t connection, const std::vector<uint8_t>& data)
+{
+	auto size = static_cast<uint32_t>(data.size());
+	// Size and payload go out in one write, a query is a single round trip
+	std::vector<uint8_t> message(sizeof(size) + data.size());
+	memcpy(message.data(), &size, sizeof(size));
+	if (data.size()) { memcpy(message.data() + sizeof(size), data.data(), data.size()); }
+	return Transfer(connection, message.data(), message.size(), true);
+}
+
+static bool Receive(intptr_t connection, std::vector<uint8_t>& data)
+{
+	uint32_t size = 0;
+	if (!Transfer(connection, &size, sizeof(size), false) || size > MaxMessageSize) { return false; }
+	data.resize(size);
+	return !size || Transfer(connection, data.data(), size, false);
+}
+
+static void CloseConnection(intptr_t connection)
+{
+#ifdef _WIN32
+	CloseHandle(reinterpret_cast<HANDLE>(connection));
+#else
+	close(static_cast<int>(connection));
+#endif
+}
+
+void QueryServer::Serve(intptr_t connection)
+{
+	std::vector<uint8_t> request;
+	MessageWriter response;
+	while (!stopped && Receive(connection, request))
+	{
+		response.Clear();
+		index.Handle(MessageReader(request), response);
+		if (!Send(connection, response.Data())) { break; }
+	}
+
+	std::lock_guard lock(mutex);
+	connections.erase(std::find(connections.begin(), connections.end(), connection));
+	CloseConnection(connection);
+	finished.notify_all();
+}
+
+#ifndef _WIN32
+// Only sockets nobody listens on are removed, so a wrong path can't delete a file or take over a running daemon
+static void RemoveStaleSocket(const sockaddr_un& address)
+{
+	struct stat info{};
+	if (lstat(address.sun_path, &info) || !S_ISSOCK(info.st_mode)) { return; }
+	auto probe = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (probe < 0) { return; }
+	bool stale = connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) && errno == ECONNREFUSED;
+	close(probe);
+	if (stale) { unlink(address.sun_path); }
+}
+
+// Directory of the default socket, only its user can enter it, so other users can't connect or plant a socket there
+static std::filesystem::path GetUserDirectory()
+{
+	return std::filesystem::temp_directory_path() / ("UnrealDumper-" + std::to_string(getuid()));
+}
+
+// Creates the directory of the default socket, fails if it exists but isn't private to the user
+static bool PrepareUserDirectory()
+{
+	auto dir = GetUserDirectory();
+	if (mkdir(dir.c_str(), 0700) && errno != EEXIST) { return false; }
+	struct stat info{};
+	return !lstat(dir.c_str(), &info) && S_ISDIR(info.st_mode) && info.st_uid == getuid() && !(info.st_mode & 077);
+}
+#endif
+
+std::string GetDefaultQueryName()
+{
+#ifdef _WIN32
+	return "\\\\.\\pipe\\UnrealDumper";
+#else
+	return (GetUserDirectory() / "UnrealDumper.sock").string();
+#endif
+}
+
+bool QueryServer::Run()
+{
+#ifndef _WIN32
+	{
+		// Listener is created under the lock, so 'Stop' either sees it or prevents it
+		std::lock_guard lock(mutex);
+		if (stopped) { return false; }
+		sockaddr_un address{};
+		address.sun_family = AF_UNIX;
+		if (name.size() >= sizeof(address.sun_path)) { return false; }
+		memcpy(address.sun_path, name.c_str(), name.size());
+		if (name == GetDefaultQueryName() && !PrepareUserDirectory()) { return false; }
+		listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listener < 0) { return false; }
+		// Socket of a previous daemon that wasn't stopped cleanly is replaced, a live one makes 'bind' fail
+		RemoveStaleSocket(address);
+		// Only the user of the daemon can connect, the socket is restricted before it starts listening
+		if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) || chmod(name.c_str(), 0600) || listen(listener, 16))
+		{
+			close(listener);
+			listener = -1;
+			return false;
+		}
+	}
+#endif
+	bool ok = true;
+	while (!stopped)
+	{
+#ifdef _WIN32
+		auto pipe = CreateNamedPipeA(name.c_str(), PIPE_ACCESS_DUPLEX, PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT, PIPE_UNLIMITED_INSTANCES, 64 << 10, 64 << 10, 0, nullptr);
+		if (pipe == INVALID_HANDLE_VALUE) { ok = false; break; }
+		bool connected = ConnectNamedPipe(pipe, nullptr) || GetLastError() == ERROR_PIPE_CONNECTED;
+		if (stopped || !connected) { CloseHandle(pipe); continue; }
+		auto connection = reinterpret_cast<intptr_t>(pipe);
+#else
+		auto client = accept(listener, nullptr, nullptr);
+		if (client < 0)
+		{
+			if (errno == EINTR || errno == ECONNABORTED) { continue; }
+			break;
+		}
+		auto connection = static_cast<intptr_t>(client);
+#endif
+		std::lock_guard lock(mutex);
+		if (stopped) { CloseConnection(connection); break; }
+		connections.push_back(connection);
+		std::thread(&QueryServer::Serve, this, connection).detach();
+	}
+	Stop();
+
+	// Threads of the clients use the server, so it waits until all of them are done
+	std::unique_lock lock(mutex);
+	finished.wait(lock, [this]() { return connections.empty(); });
+#ifndef _WIN32
+	close(listener);
+	listener = -1;
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	memcpy(address.sun_path, name.c_str(), name.size());
+	RemoveStaleSocket(address);
+#endif
+	return ok;
+}
+
+void QueryServer::Stop()
+{
+	std::lock_guard lock(mutex);
+	if (stopped.exchange(true)) { return; }
+#ifdef _WIN32
+	// Connecting wakes up the pending 'ConnectNamedPipe', reads of the clients are cancelled
+	auto wake = CreateFileA(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+	if (wake != INVALID_HANDLE_VALUE) { CloseHandle(wake); }
+	for (auto connection : connections) { CancelIoEx(reinterpret_cast<HANDLE>(connection), nullptr); }
+#else
+	// Shutting down wakes up 'accept' and reads of the clients, descriptors are closed by their threads
+	if (listener >= 0) { shutdown(listener, SHUT_RDWR); }
+	for (auto connection : connections) { shutdown(static_cast<int>(connection), SHUT_RDWR); }
+#endif
+}
+
+bool QueryClient::Connect(const std::string& name)
+{
+	Close();
+#ifdef _WIN32
+	auto pipe = CreateFileA(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+	if (pipe == INVALID_HANDLE_VALUE) { return false; }
+	connection = reinterpret_cast<intptr_t>(pipe);
+#else
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (name.size() >= sizeof(address.sun_path)) { return false; }
+	memcpy(address.sun_path, name.c_str(), name.size());
+	auto client = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (client < 0) { return false; }
+	if (connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address))) { close(client); return false; }
+	connection = client;
+#endif
+	return true;
+}
+
+void QueryClient::Close()
+{
+	if (connection == -1) { return; }
+	CloseConnection(connection);
+	connection = -1;
+}
+
+bool QueryClient::Query(const MessageWriter& request, MessageReader& response)
+{
+	if (connection == -1) { return false; }
+	if (!Send(connection, request.Data()) || !Receive(connection, buffer)) { Close(); return false; }
+	response = MessageReader(buffer);
+	return true;
+}
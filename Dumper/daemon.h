@@ -0,0 +1,140 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "context.h"
+#include "protocol.h"
+
+/*
+* Warm state of an attached game that answers queries without walking the process:
+* names by id and by string, objects by index and by full name, supers of every struct and layouts of queried structs.
+* It's built once from 'ObjObjects' and 'NamePoolData', and revalidated incrementally:
+* - names added since the last refresh are indexed at most every 'RefreshInterval', or on a lookup miss
+* - on the same refresh the object array is read a chunk at a time, new slots and slots whose object changed are indexed
+* - an object is checked to still be in its slot when it's returned, a stale slot is indexed again
+* Queries of all clients are serialized, each one costs a few reads at most.
+* The index keeps the context of the game it was built in, and binds it on the thread of every query.
+*/
+class QueryIndex
+{
+private:
+	struct Object
+	{
+		byte* Address = nullptr;
+		byte* Class = nullptr;
+		// Super of a struct, null for other objects and root structs
+		byte* Super = nullptr;
+		bool Struct = false;
+		std::string FullName;
+	};
+	struct Member
+	{
+		std::string Name;
+		std::string Type;
+		int32_t Offset;
+		int32_t Size;
+		int32_t ArrayDim;
+		uint8_t FieldMask;
+	};
+	struct Layout
+	{
+		int32_t Size = 0;
+		int32_t Inherited = 0;
+		std::string Super;
+		std::vector<Member> Members;
+	};
+	static constexpr std::chrono::milliseconds RefreshInterval{ 250 };
+	// Addresses of the globals in the target, they're read again on refresh
+	byte* objectsAddress;
+	byte* namesAddress;
+	// Context with the globals as of the last refresh, a thread binds it again when its copy is older
+	Context context;
+	uint64_t generation = 0;
+	std::mutex mutex;
+	std::unordered_map<uint32_t, std::string> names;
+	// Hashes of strings to ids and indices, collisions are resolved by comparing the stored strings
+	std::unordered_multimap<size_t, uint32_t> nameIds;
+	std::vector<Object> objects;
+	std::unordered_multimap<size_t, uint32_t> objectIds;
+	std::unordered_map<byte*, uint32_t> addresses;
+	std::unordered_map<byte*, Layout> layouts;
+	uint32_t namesBlock = 0;
+	uint32_t namesCursor = 0;
+	std::chrono::steady_clock::time_point refreshed;
+	uint64_t refreshes = 0;
+	uint64_t queries = 0;
+	void AddName(std::string_view name, uint32_t id);
+	// Indexes the object now in the slot, null empties it
+	void IndexObject(uint32_t index, byte* address);
+	// Indexes names and objects added to the process since the last refresh and slots that changed, returns the numbers of the added ones
+	std::pair<uint32_t, uint32_t> Refresh();
+	void RefreshIfStale();
+	void Bind();
+	// Checks that the object is still in its slot, indexes the slot again if it isn't
+	bool Validate(uint32_t index);
+	int64_t FindName(std::string_view name) const;
+	int64_t FindObject(std::string_view fullName) const;
+	const Layout& GetLayout(byte* address);
+	void PutObject(MessageWriter& response, uint32_t index) const;
+public:
+	// Globals have to be read and the engine initialized, 'objects' and 'names' are addresses of the globals in the target
+	QueryIndex(byte* objects, byte* names);
+	// Answers one request, see protocol.h
+	void Handle(MessageReader request, MessageWriter& response);
+	size_t GetNameCount() const { return names.size(); }
+	size_t GetObjectCount() const { return objects.size(); }
+};
+
+/*
+* Serves the index on a Unix domain socket, or on a named pipe on Windows, every client gets its own thread.
+* 'name' is the socket path, or the pipe name like "\\.\pipe\UnrealDumper".
+* A stale socket of a daemon that wasn't stopped cleanly is replaced, a socket that is still served or any other file at the path
+* is left alone and 'Run' fails. Sockets are only accessible to their user.
+*/
+class QueryServer
+{
+private:
+	QueryIndex& index;
+	std::string name;
+	std::atomic<bool> stopped = false;
+	// Open connections, they're closed by 'Stop' to wake up their threads
+	std::mutex mutex;
+	std::condition_variable finished;
+	std::vector<intptr_t> connections;
+#ifndef _WIN32
+	int listener = -1;
+#endif
+	void Serve(intptr_t connection);
+public:
+	QueryServer(QueryIndex& index, std::string name) : index(index), name(std::move(name)) {}
+	~QueryServer() { Stop(); }
+	// Accepts clients until stopped, returns false if the socket or pipe can't be created
+	bool Run();
+	void Stop();
+};
+
+// Name served without one given, the pipe on Windows and elsewhere a socket in a directory of the user under the temp directory
+std::string GetDefaultQueryName();
+
+// Blocking client of the daemon, one request at a time
+class QueryClient
+{
+private:
+	intptr_t connection = -1;
+	std::vector<uint8_t> buffer;
+public:
+	QueryClient() = default;
+	~QueryClient() { Close(); }
+	QueryClient(const QueryClient&) = delete;
+	QueryClient& operator=(const QueryClient&) = delete;
+	bool Connect(const std::string& name);
+	void Close();
+	// Sends the request and waits for the response, the reader points into the client's buffer until the next query
+	bool Query(const MessageWriter& request, MessageReader& response);
+};
@@ -0,0 +1,422 @@
+#include "database.h"
+#include "trace.h"
+#include <algorithm>
+
+uint32_t ReflectionBuilder::AddString(std::string_view str)
+{
+	auto it = ids.find(str);
+	if (it != ids.end()) { return it->second; }
+	it = ids.emplace(std::string(str), static_cast<uint32_t>(strings.size())).first;
+	strings.push_back(&it->first);
+	return it->second;
+}
+
+void ReflectionBuilder::AddName(uint32_t id, std::string_view name)
+{
+	names.push_back({ id, AddString(name) });
+}
+
+uint32_t ReflectionBuilder::AddType(uint8_t kind, std::string_view text, uint64_t refHash, uint32_t inner, uint32_t value)
+{
+	Type type{ refHash, AddString(text), inner, value, kind };
+	auto [it, inserted] = typeIds.try_emplace(type, static_cast<uint32_t>(types.size()));
+	if (inserted) { types.push_back(type); }
+	return it->second;
+}
+
+void ReflectionBuilder::AddStruct(std::string_view fullName, std::string_view cppName, std::string_view package, std::string_view superName, uint64_t superHash, int32_t size, int32_t inherited, bool isClass)
+{
+	auto& record = structs.emplace_back();
+	record.Hash = ReflectionHash(fullName);
+	record.SuperHash = superHash;
+	record.FullName = AddString(fullName);
+	record.CppName = AddString(cppName);
+	record.Package = AddString(package);
+	record.Super = ReflectionNone;
+	record.SuperName = superName.size() ? AddString(superName) : ReflectionNone;
+	record.Size = size;
+	record.Inherited = inherited;
+	record.MembersBegin = static_cast<uint32_t>(members.size());
+	record.FunctionsBegin = static_cast<uint32_t>(functions.size());
+	record.Flags = isClass ? ReflectionClass : 0;
+}
+
+ReflectionMember ReflectionBuilder::MakeMember(std::string_view name, uint32_t type, int32_t offset, int32_t size, int32_t arrayDim, uint64_t flags)
+{
+	ReflectionMember member{};
+	member.NameHash = ReflectionHash(name);
+	member.Flags = flags;
+	member.Name = AddString(name);
+	member.Type = type;
+	member.Offset = offset;
+	member.Size = size;
+	member.ArrayDim = arrayDim;
+	return member;
+}
+
+void ReflectionBuilder::AddMember(std::string_view name, uint32_t type, int32_t offset, int32_t size, int32_t arrayDim, uint8_t bitOffset, uint8_t bitSize, uint64_t flags)
+{
+	auto& member = members.emplace_back(MakeMember(name, type, offset, size, arrayDim, flags));
+	member.BitOffset = bitOffset;
+	member.BitSize = bitSize;
+	structs.back().MembersCount++;
+}
+
+void ReflectionBuilder::AddFunction(std::string_view fullName, std::string_view name, uint32_t flags, uint32_t returnType, uint64_t rva)
+{
+	ReflectionFunction function{ rva, AddString(fullName), AddString(name), flags, returnType, static_cast<uint32_t>(params.size()), 0 };
+	functions.push_back(function);
+	structs.back().FunctionsCount++;
+}
+
+void ReflectionBuilder::AddParam(std::string_view name, uint32_t type, int32_t offset, int32_t size, int32_t arrayDim, uint64_t flags)
+{
+	params.push_back(MakeMember(name, type, offset, size, arrayDim, flags));
+	functions.back().ParamsCount++;
+}
+
+void ReflectionBuilder::AddEnum(std::string_view fullName, std::string_view name, std::string_view package)
+{
+	ReflectionEnum record{ ReflectionHash(fullName), AddString(fullName), AddString(name), AddString(package), static_cast<uint32_t>(values.size()), 0, 0 };
+	enums.push_back(record);
+}
+
+void ReflectionBuilder::AddValue(std::string_view name, int64_t value)
+{
+	values.push_back({ value, AddString(name), 0 });
+	enums.back().ValuesCount++;
+}
+
+uint32_t ReflectionBuilder::CopyType(const ReflectionView& view, uint32_t index, int depth)
+{
+	// Types of a broken database can't recurse forever
+	auto type = view.Type(index);
+	if (!type || depth > 8) { return ReflectionNone; }
+	auto inner = CopyType(view, type->Inner, depth + 1);
+	auto value = CopyType(view, type->Value, depth + 1);
+	return AddType(type->Kind, view.String(type->Text), type->RefHash, inner, value);
+}
+
+void ReflectionBuilder::AddStructs(const ReflectionView& view, const std::vector<uint32_t>& indices)
+{
+	auto all = view.Structs();
+	auto string = [&view](uint32_t index) { return view.String(index); };
+	for (auto index : indices)
+	{
+		auto& s = all[index];
+		AddStruct(string(s.FullName), string(s.CppName), string(s.Package), string(s.SuperName), s.SuperHash, s.Size, s.Inherited, s.Flags & ReflectionClass);
+		structs.back().Flags = s.Flags;
+		for (auto& m : view.Members(s)) { AddMember(string(m.Name), CopyType(view, m.Type), m.Offset, m.Size, m.ArrayDim, m.BitOffset, m.BitSize, m.Flags); }
+		for (auto& f : view.Functions(s))
+		{
+			AddFunction(string(f.FullName), string(f.Name), f.Flags, CopyType(view, f.ReturnType), f.Rva);
+			for (auto& p : view.Params(f)) { AddParam(string(p.Name), CopyType(view, p.Type), p.Offset, p.Size, p.ArrayDim, p.Flags); }
+		}
+	}
+}
+
+void ReflectionBuilder::AddEnums(const ReflectionView& view, const std::vector<uint32_t>& indices)
+{
+	auto all = view.Enums();
+	for (auto index : indices)
+	{
+		auto& e = all[index];
+		AddEnum(view.String(e.FullName), view.String(e.Name), view.String(e.Package));
+		for (auto& v : view.Values(e)) { AddValue(view.String(v.Name), v.Value); }
+	}
+}
+
+void ReflectionBuilder::Merge(const ReflectionBuilder& other, const std::function<bool(std::string_view package)>& skip)
+{
+	// Strings and types of the other builder are added once each, records are copied with their indices mapped
+	std::vector<uint32_t> map(other.strings.size());
+	for (size_t i = 0; i < other.strings.size(); i++) { map[i] = AddString(*other.strings[i]); }
+	auto remap = [&map](uint32_t index) { return index == ReflectionNone ? index : map[index]; };
+	// Inner types are always added before the types that contain them
+	std::vector<uint32_t> typeMap(other.types.size());
+	auto retype = [&typeMap](uint32_t index) { return index == ReflectionNone ? index : typeMap[index]; };
+	for (size_t i = 0; i < other.types.size(); i++)
+	{
+		auto& type = other.types[i];
+		typeMap[i] = AddType(type.Kind, *other.strings[type.Text], type.RefHash, retype(type.Inner), retype(type.Value));
+	}
+	auto skipped = [&other, &skip](uint32_t package) { return skip && skip(*other.strings[package]); };
+
+	for (auto name : other.names)
+	{
+		name.String = remap(name.String);
+		names.push_back(name);
+	}
+	// Records are copied per struct, so members and functions of skipped structs are left out as well
+	auto copy = [&remap, &retype](const std::vector<ReflectionMember>& from, uint32_t begin, uint32_t count, std::vector<ReflectionMember>& to)
+	{
+		auto base = static_cast<uint32_t>(to.size());
+		for (auto i = begin; i < begin + count; i++)
+		{
+			auto member = from[i];
+			member.Name = remap(member.Name);
+			member.Type = retype(member.Type);
+			to.push_back(member);
+		}
+		return base;
+	};
+	for (auto record : other.structs)
+	{
+		if (skipped(record.Package)) { continue; }
+		auto functionsBase = static_cast<uint32_t>(functions.size());
+		for (auto i = record.FunctionsBegin; i < record.FunctionsBegin + record.FunctionsCount; i++)
+		{
+			auto function = other.functions[i];
+			function.FullName = remap(function.FullName);
+			function.Name = remap(function.Name);
+			function.ReturnType = retype(function.ReturnType);
+			function.ParamsBegin = copy(other.params, function.ParamsBegin, function.ParamsCount, params);
+			functions.push_back(function);
+		}
+		record.FullName = remap(record.FullName);
+		record.CppName = remap(record.CppName);
+		record.Package = remap(record.Package);
+		record.SuperName = remap(record.SuperName);
+		record.MembersBegin = copy(other.members, record.MembersBegin, record.MembersCount, members);
+		record.FunctionsBegin = functionsBase;
+		structs.push_back(record);
+	}
+
+	for (auto record : other.enums)
+	{
+		if (skipped(record.Package)) { continue; }
+		auto valuesBase = static_cast<uint32_t>(values.size());
+		for (auto i = record.ValuesBegin; i < record.ValuesBegin + record.ValuesCount; i++)
+		{
+			auto value = other.values[i];
+			value.Name = remap(value.Name);
+			values.push_back(value);
+		}
+		record.FullName = remap(record.FullName);
+		record.Name = remap(record.Name);
+		record.Package = remap(record.Package);
+		record.ValuesBegin = valuesBase;
+		enums.push_back(record);
+	}
+}
+
+// Order of records by hash, names and then the order of the dump decide between equal hashes
+template<typename T>
+static std::vector<uint32_t> SortByHash(const std::vector<T>& records, const std::vector<const std::string*>& strings)
+{
+	std::vector<uint32_t> order(records.size());
+	for (uint32_t i = 0; i < order.size(); i++) { order[i] = i; }
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+	{
+		auto& x = records[a];
+		auto& y = records[b];
+		return x.Hash != y.Hash ? x.Hash < y.Hash : *strings[x.FullName] < *strings[y.FullName];
+	});
+	return order;
+}
+
+template<typename T>
+static std::unordered_map<uint64_t, uint32_t> IndexByHash(const std::vector<T>& records, const std::vector<uint32_t>& order)
+{
+	std::unordered_map<uint64_t, uint32_t> indices;
+	indices.reserve(order.size());
+	for (uint32_t i = 0; i < order.size(); i++) { indices.try_emplace(records[order[i]].Hash, i); }
+	return indices;
+}
+
+WriteBuffer ReflectionBuilder::Serialize() const
+{
+	TraceScope trace("Serialize reflection");
+	// Strings and types are sorted, so the file doesn't depend on which worker saw them first
+	std::vector<uint32_t> sortedStrings(strings.size());
+	for (uint32_t i = 0; i < sortedStrings.size(); i++) { sortedStrings[i] = i; }
+	std::sort(sortedStrings.begin(), sortedStrings.end(), [this](uint32_t a, uint32_t b) { return *strings[a] < *strings[b]; });
+	std::vector<uint32_t> map(strings.size());
+	for (uint32_t i = 0; i < sortedStrings.size(); i++) { map[sortedStrings[i]] = i; }
+	auto remap = [&map](uint32_t index) { return index == ReflectionNone ? index : map[index]; };
+
+	std::vector<uint32_t> sortedTypes(types.size());
+	for (uint32_t i = 0; i < sortedTypes.size(); i++) { sortedTypes[i] = i; }
+	auto typeLess = [this](auto& self, uint32_t a, uint32_t b) -> bool
+	{
+		if (a == b || b == ReflectionNone) { return false; }
+		if (a == ReflectionNone) { return true; }
+		auto& x = types[a];
+		auto& y = types[b];
+		if (x.Text != y.Text) { return *strings[x.Text] < *strings[y.Text]; }
+		if (x.Kind != y.Kind) { return x.Kind < y.Kind; }
+		if (x.RefHash != y.RefHash) { return x.RefHash < y.RefHash; }
+		if (x.Inner != y.Inner) { return self(self, x.Inner, y.Inner); }
+		return self(self, x.Value, y.Value);
+	};
+	std::sort(sortedTypes.begin(), sortedTypes.end(), [&typeLess](uint32_t a, uint32_t b) { return typeLess(typeLess, a, b); });
+	std::vector<uint32_t> typeMap(types.size());
+	for (uint32_t i = 0; i < sortedTypes.size(); i++) { typeMap[sortedTypes[i]] = i; }
+	auto retype = [&typeMap](uint32_t index) { return index == ReflectionNone ? index : typeMap[index]; };
+
+	auto structOrder = SortByHash(structs, strings);
+	auto structIndices = IndexByHash(structs, structOrder);
+	auto enumOrder = SortByHash(enums, strings);
+	auto enumIndices = IndexByHash(enums, enumOrder);
+	auto resolve = [](const std::unordered_map<uint64_t, uint32_t>& indices, uint64_t hash)
+	{
+		auto it = hash ? indices.find(hash) : indices.end();
+		return it != indices.end() ? it->second : ReflectionNone;
+	};
+
+	std::vector<ReflectionType> typeTable;
+	typeTable.reserve(types.size());
+	for (auto i : sortedTypes)
+	{
+		auto& type = types[i];
+		ReflectionType record{};
+		record.RefHash = type.RefHash;
+		record.Text = remap(type.Text);
+		record.Ref = resolve(type.Kind == ReflectionEnumProperty ? enumIndices : structIndices, type.RefHash);
+		record.Inner = retype(type.Inner);
+		record.Value = retype(type.Value);
+		record.Kind = type.Kind;
+		typeTable.push_back(record);
+	}
+
+	auto copy = [&remap, &retype](const ReflectionMember& member)
+	{
+		auto copied = member;
+		copied.Name = remap(copied.Name);
+		copied.Type = retype(copied.Type);
+		return copied;
+	};
+	std::vector<ReflectionStruct> structTable;
+	std::vector<ReflectionMember> memberTable, paramTable;
+	std::vector<ReflectionFunction> functionTable;
+	structTable.reserve(structs.size());
+	memberTable.reserve(members.size());
+	functionTable.reserve(functions.size());
+	paramTable.reserve(params.size());
+	for (auto i : structOrder)
+	{
+		auto record = structs[i];
+		record.Super = resolve(structIndices, record.SuperHash);
+		record.FullName = remap(record.FullName);
+		record.CppName = remap(record.CppName);
+		record.Package = remap(record.Package);
+		record.SuperName = remap(record.SuperName);
+
+		auto member = members.begin() + record.MembersBegin;
+		record.MembersBegin = static_cast<uint32_t>(memberTable.size());
+		for (auto end = member + record.MembersCount; member != end; member++) { memberTable.push_back(copy(*member)); }
+		std::stable_sort(memberTable.begin() + record.MembersBegin, memberTable.end(), [](const ReflectionMember& a, const ReflectionMember& b)
+		{
+			return a.NameHash != b.NameHash ? a.NameHash < b.NameHash : a.Name < b.Name;
+		});
+
+		// Functions and params keep the order of the game
+		auto function = functions.begin() + record.FunctionsBegin;
+		record.FunctionsBegin = static_cast<uint32_t>(functionTable.size());
+		for (auto end = function + record.FunctionsCount; function != end; function++)
+		{
+			auto f = *function;
+			f.FullName = remap(f.FullName);
+			f.Name = remap(f.Name);
+			f.ReturnType = retype(f.ReturnType);
+			auto param = params.begin() + f.ParamsBegin;
+			f.ParamsBegin = static_cast<uint32_t>(paramTable.size());
+			for (auto last = param + f.ParamsCount; param != last; param++) { paramTable.push_back(copy(*param)); }
+			functionTable.push_back(f);
+		}
+		structTable.push_back(record);
+	}
+
+	std::vector<ReflectionEnum> enumTable;
+	std::vector<ReflectionValue> valueTable;
+	enumTable.reserve(enums.size());
+	valueTable.reserve(values.size());
+	for (auto i : enumOrder)
+	{
+		auto record = enums[i];
+		record.FullName = remap(record.FullName);
+		record.Name = remap(record.Name);
+		record.Package = remap(record.Package);
+		auto value = values.begin() + record.ValuesBegin;
+		record.ValuesBegin = static_cast<uint32_t>(valueTable.size());
+		for (auto end = value + record.ValuesCount; value != end; value++)
+		{
+			valueTable.push_back(*value);
+			valueTable.back().Name = remap(value->Name);
+		}
+		enumTable.push_back(record);
+	}
+
+	auto nameTable = names;
+	for (auto& name : nameTable) { name.String = remap(name.String); }
+	std::sort(nameTable.begin(), nameTable.end(), [](const ReflectionName& a, const ReflectionName& b) { return a.Id < b.Id; });
+
+	std::vector<ReflectionString> stringTable(strings.size());
+	uint64_t chars = 0;
+	for (size_t i = 0; i < sortedStrings.size(); i++)
+	{
+		auto& str = *strings[sortedStrings[i]];
+		stringTable[i] = { static_cast<uint32_t>(chars), static_cast<uint32_t>(str.size()) };
+		chars += str.size();
+	}
+
+	ReflectionHeader header{};
+	memcpy(header.Magic, ReflectionMagic, sizeof(ReflectionMagic));
+	header.Version = ReflectionVersion;
+	uint64_t offset = sizeof(header);
+	auto place = [&offset](ReflectionTable& table, uint64_t count, size_t size)
+	{
+		table = { offset, count };
+		offset = (offset + count * size + 7) & ~7ull;
+	};
+	place(header.Strings, stringTable.size(), sizeof(ReflectionString));
+	place(header.Chars, chars, sizeof(char));
+	place(header.Names, nameTable.size(), sizeof(ReflectionName));
+	place(header.Structs, structTable.size(), sizeof(ReflectionStruct));
+	place(header.Members, memberTable.size(), sizeof(ReflectionMember));
+	place(header.Types, typeTable.size(), sizeof(ReflectionType));
+	place(header.Enums, enumTable.size(), sizeof(ReflectionEnum));
+	place(header.Values, valueTable.size(), sizeof(ReflectionValue));
+	place(header.Functions, functionTable.size(), sizeof(ReflectionFunction));
+	place(header.Params, paramTable.size(), sizeof(ReflectionMember));
+
+	WriteBuffer buf;
+	buf.resize(offset);
+	auto out = buf.data();
+	memset(out, 0, offset);
+	memcpy(out, &header, sizeof(header));
+	auto write = [out](const ReflectionTable& table, const auto& records) { memcpy(out + table.Offset, records.data(), records.size() * sizeof(records[0])); };
+	write(header.Strings, stringTable);
+	for (size_t i = 0; i < sortedStrings.size(); i++) { memcpy(out + header.Chars.Offset + stringTable[i].Offset, strings[sortedStrings[i]]->data(), stringTable[i].Size); }
+	write(header.Names, nameTable);
+	write(header.Structs, structTable);
+	write(header.Members, memberTable);
+	write(header.Types, typeTable);
+	write(header.Enums, enumTable);
+	write(header.Values, valueTable);
+	write(header.Functions, functionTable);
+	write(header.Params, paramTable);
+	return buf;
+}
+
+bool ReflectionDatabase::Load(const fs::path& path)
+{
+	packages.clear();
+	return file.Open(path.string().c_str());
+}
+
+void ReflectionDatabase::IndexPackages()
+{
+	auto& view = file.View();
+	auto structs = view.Structs();
+	for (uint32_t i = 0; i < structs.size(); i++) { packages[view.String(structs[i].Package)].Structs.push_back(i); }
+	auto enums = view.Enums();
+	for (uint32_t i = 0; i < enums.size(); i++) { packages[view.String(enums[i].Package)].Enums.push_back(i); }
+}
+
+const ReflectionDatabase::Package& ReflectionDatabase::GetPackage(std::string_view package) const
+{
+	static const Package empty;
+	auto it = packages.find(package);
+	return it != packages.end() ? it->second : empty;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "reflection.h"
+#include "writer.h"
+
+namespace fs = std::filesystem;
+
+/*
+* Collects the records of a dump and serializes them in the format of reflection.h.
+* Every package worker fills its own builder, and they're merged into one when the workers are done.
+* Records reference strings and types by the indices of the builder, they're sorted and resolved when it's serialized.
+*/
+class ReflectionBuilder
+{
+private:
+	struct Type
+	{
+		uint64_t RefHash = 0;
+		uint32_t Text = ReflectionNone;
+		uint32_t Inner = ReflectionNone;
+		uint32_t Value = ReflectionNone;
+		uint8_t Kind = ReflectionUnknown;
+		bool operator==(const Type&) const = default;
+	};
+	struct TypeHasher
+	{
+		size_t operator()(const Type& type) const
+		{
+			uint64_t hash = type.RefHash;
+			for (uint64_t value : { type.Text, type.Inner, type.Value, uint32_t(type.Kind) }) { hash = (hash ^ value) * 0x100000001B3ull; }
+			return static_cast<size_t>(hash);
+		}
+	};
+	struct StringHasher
+	{
+		using is_transparent = void;
+		size_t operator()(std::string_view str) const { return std::hash<std::string_view>()(str); }
+	};
+	// Keys own the strings, 'strings' gives them by index, they're looked up without copies
+	std::unordered_map<std::string, uint32_t, StringHasher, std::equal_to<>> ids;
+	std::vector<const std::string*> strings;
+	std::unordered_map<Type, uint32_t, TypeHasher> typeIds;
+	std::vector<Type> types;
+	std::vector<ReflectionName> names;
+	std::vector<ReflectionStruct> structs;
+	std::vector<ReflectionMember> members;
+	std::vector<ReflectionFunction> functions;
+	std::vector<ReflectionMember> params;
+	std::vector<ReflectionEnum> enums;
+	std::vector<ReflectionValue> values;
+private:
+	uint32_t CopyType(const ReflectionView& view, uint32_t index, int depth = 0);
+	ReflectionMember MakeMember(std::string_view name, uint32_t type, int32_t offset, int32_t size, int32_t arrayDim, uint64_t flags);
+public:
+	uint32_t AddString(std::string_view str);
+	void AddName(uint32_t id, std::string_view name);
+	// Types are added once, 'inner' and 'value' are indices returned by earlier calls or 'ReflectionNone'
+	uint32_t AddType(uint8_t kind, std::string_view text, uint64_t refHash, uint32_t inner, uint32_t value);
+	// Starts a struct, members and functions added after it belong to it, 'superHash' is 'ReflectionHash' of the super's full name or 0
+	void AddStruct(std::string_view fullName, std::string_view cppName, std::string_view package, std::string_view superName, uint64_t superHash, int32_t size, int32_t inherited, bool isClass);
+	void AddMember(std::string_view name, uint32_t type, int32_t offset, int32_t size, int32_t arrayDim, uint8_t bitOffset, uint8_t bitSize, uint64_t flags);
+	// Starts a function of the last struct, params added after it belong to it
+	void AddFunction(std::string_view fullName, std::string_view name, uint32_t flags, uint32_t returnType, uint64_t rva);
+	void AddParam(std::string_view name, uint32_t type, int32_t offset, int32_t size, int32_t arrayDim, uint64_t flags);
+	// Starts an enum, values added after it belong to it
+	void AddEnum(std::string_view fullName, std::string_view name, std::string_view package);
+	void AddValue(std::string_view name, int64_t value);
+	// Copies structs and enums of another database, e.g. of a package that wasn't generated again
+	void AddStructs(const ReflectionView& view, const std::vector<uint32_t>& indices);
+	void AddEnums(const ReflectionView& view, const std::vector<uint32_t>& indices);
+	// Structs and enums of packages that 'skip' returns true for aren't copied, e.g. of a package that was generated again
+	void Merge(const ReflectionBuilder& other, const std::function<bool(std::string_view package)>& skip = {});
+	size_t GetStructCount() const { return structs.size(); }
+	size_t GetEnumCount() const { return enums.size(); }
+	// Sorts the records, resolves references and lays out the file
+	WriteBuffer Serialize() const;
+};
+
+// Database mapped from a file, with records grouped by package on demand
+class ReflectionDatabase
+{
+public:
+	struct Package
+	{
+		std::vector<uint32_t> Structs;
+		std::vector<uint32_t> Enums;
+	};
+private:
+	ReflectionFile file;
+	std::unordered_map<std::string_view, Package> packages;
+public:
+	bool Load(const fs::path& path);
+	const ReflectionView& View() const { return file.View(); }
+	// Groups structs and enums by package, call once before 'GetPackage'
+	void IndexPackages();
+	// Indices of the structs and enums of the package, empty if it has none
+	const Package& GetPackage(std::string_view package) const;
+};
@@ -0,0 +1,109 @@
+#include "diff.h"
+#include <algorithm>
+#include <span>
+
+/*
+* Pairs records of two arrays sorted by 'key', 'fn' gets both of a pair or one of them and null.
+* Records with equal keys are paired by 'same', which only runs for hash collisions and in runs of equal keys.
+*/
+template<typename T, typename Key, typename Same, typename Fn>
+static void Merge(std::span<const T> a, std::span<const T> b, Key key, Same same, Fn fn)
+{
+	size_t i = 0, j = 0;
+	while (i < a.size() || j < b.size())
+	{
+		if (j == b.size() || (i < a.size() && key(a[i]) < key(b[j]))) { fn(&a[i++], nullptr); continue; }
+		if (i == a.size() || key(b[j]) < key(a[i])) { fn(nullptr, &b[j++]); continue; }
+
+		auto k = key(a[i]);
+		auto ie = i + 1, je = j + 1;
+		while (ie < a.size() && key(a[ie]) == k) { ie++; }
+		while (je < b.size() && key(b[je]) == k) { je++; }
+		if (ie == i + 1 && je == j + 1 && same(a[i], b[j])) { fn(&a[i++], &b[j++]); continue; }
+
+		std::vector<bool> paired(je - j);
+		for (; i < ie; i++)
+		{
+			auto y = j;
+			while (y < je && (paired[y - j] || !same(a[i], b[y]))) { y++; }
+			if (y < je) { paired[y - j] = true; }
+			fn(&a[i], y < je ? &b[y] : nullptr);
+		}
+		for (auto y = j; y < je; y++) { if (!paired[y - j]) { fn(nullptr, &b[y]); } }
+		j = je;
+	}
+}
+
+void DiffLayouts(const ReflectionView& old, const ReflectionView& current, LayoutDiff& diff)
+{
+	auto structHash = [](const ReflectionStruct& s) { return s.Hash; };
+	auto sameStruct = [&](const ReflectionStruct& a, const ReflectionStruct& b) { return old.String(a.FullName) == current.String(b.FullName); };
+	auto memberHash = [](const ReflectionMember& m) { return m.NameHash; };
+	auto sameMember = [&](const ReflectionMember& a, const ReflectionMember& b) { return old.String(a.Name) == current.String(b.Name); };
+
+	Merge(old.Structs(), current.Structs(), structHash, sameStruct, [&](const ReflectionStruct* a, const ReflectionStruct* b)
+	{
+		diff.Compared++;
+		if (!a || !b)
+		{
+			diff.Structs.push_back({ a, b, static_cast<uint8_t>(a ? LayoutDiff::Removed : LayoutDiff::Added), 0, 0 });
+			return;
+		}
+
+		uint8_t changes = 0;
+		if (a->Size != b->Size) { changes |= LayoutDiff::Moved; }
+		if (a->Inherited != b->Inherited || old.String(a->SuperName) != current.String(b->SuperName)) { changes |= LayoutDiff::Retyped; }
+		auto begin = static_cast<uint32_t>(diff.Members.size());
+		Merge(old.Members(*a), current.Members(*b), memberHash, sameMember, [&](const ReflectionMember* x, const ReflectionMember* y)
+		{
+			uint8_t member = 0;
+			if (!x || !y) { member = x ? LayoutDiff::Removed : LayoutDiff::Added; }
+			else
+			{
+				if (x->Offset != y->Offset) { member |= LayoutDiff::Moved; }
+				if (x->Size != y->Size || x->ArrayDim != y->ArrayDim || x->BitOffset != y->BitOffset || x->BitSize != y->BitSize || old.TypeText(x->Type) != current.TypeText(y->Type))
+				{
+					member |= LayoutDiff::Retyped;
+				}
+			}
+			if (member) { diff.Members.push_back({ x, y, member }); }
+		});
+
+		auto end = static_cast<uint32_t>(diff.Members.size());
+		if (!changes && begin == end) { return; }
+		// Members of a changed struct are listed like they're laid out
+		auto offset = [](const LayoutDiff::Member& m) { return m.New ? m.New->Offset : m.Old->Offset; };
+		std::sort(diff.Members.begin() + begin, diff.Members.end(), [&offset](const LayoutDiff::Member& x, const LayoutDiff::Member& y) { return offset(x) < offset(y); });
+		diff.Structs.push_back({ a, b, changes, begin, end });
+	});
+}
+
+void PrintDiff(const ReflectionView& old, const ReflectionView& current, const LayoutDiff& diff, WriteBuffer& buf)
+{
+	for (auto& s : diff.Structs)
+	{
+		if (s.Changes & LayoutDiff::Added) { FormatTo(buf, "+ {} ({:#x})\n", current.String(s.New->FullName), s.New->Size); continue; }
+		if (s.Changes & LayoutDiff::Removed) { FormatTo(buf, "- {} ({:#x})\n", old.String(s.Old->FullName), s.Old->Size); continue; }
+
+		FormatTo(buf, "~ {}", current.String(s.New->FullName));
+		if (s.Changes & LayoutDiff::Moved) { FormatTo(buf, " size {:#x} -> {:#x}", s.Old->Size, s.New->Size); }
+		if (s.Changes & LayoutDiff::Retyped)
+		{
+			FormatTo(buf, " super {} ({:#x}) -> {} ({:#x})", old.String(s.Old->SuperName), s.Old->Inherited, current.String(s.New->SuperName), s.New->Inherited);
+		}
+		buf.push_back('\n');
+		for (auto i = s.MembersBegin; i < s.MembersEnd; i++)
+		{
+			auto& m = diff.Members[i];
+			if (m.Changes & LayoutDiff::Added) { FormatTo(buf, "\t+ {} {} at {:#x}\n", current.TypeText(m.New->Type), current.String(m.New->Name), m.New->Offset); continue; }
+			if (m.Changes & LayoutDiff::Removed) { FormatTo(buf, "\t- {} {} at {:#x}\n", old.TypeText(m.Old->Type), old.String(m.Old->Name), m.Old->Offset); continue; }
+			FormatTo(buf, "\t~ {}", current.String(m.New->Name));
+			if (m.Changes & LayoutDiff::Moved) { FormatTo(buf, " offset {:#x} -> {:#x}", m.Old->Offset, m.New->Offset); }
+			if (m.Changes & LayoutDiff::Retyped)
+			{
+				FormatTo(buf, " type {} ({:#x}) -> {} ({:#x})", old.TypeText(m.Old->Type), m.Old->Size, current.TypeText(m.New->Type), m.New->Size);
+			}
+			buf.push_back('\n');
+		}
+	}
+}
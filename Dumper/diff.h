@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "reflection.h"
+#include "writer.h"
+
+/*
+* Structural difference of two reflection databases, e.g. of the dumps before and after a patch.
+* Structs are matched by the hash of their full name and members by the hash of their name, both tables are sorted by them,
+* so the whole diff is one merge pass without lookups or string comparisons of unchanged records.
+*/
+struct LayoutDiff
+{
+	enum Change : uint8_t
+	{
+		Added = 1,
+		Removed = 2,
+		// Struct changed size, or member changed offset
+		Moved = 4,
+		// Member changed type, size, array dim or bits, or struct changed super
+		Retyped = 8
+	};
+	struct Member
+	{
+		// Null when the member was added or removed
+		const ReflectionMember* Old;
+		const ReflectionMember* New;
+		uint8_t Changes;
+	};
+	struct Struct
+	{
+		const ReflectionStruct* Old;
+		const ReflectionStruct* New;
+		uint8_t Changes;
+		// Range of 'Members', ordered by offset
+		uint32_t MembersBegin;
+		uint32_t MembersEnd;
+	};
+	// Structs that were added, removed or changed, in the order of their hashes
+	std::vector<Struct> Structs;
+	std::vector<Member> Members;
+	size_t Compared = 0;
+};
+
+void DiffLayouts(const ReflectionView& old, const ReflectionView& current, LayoutDiff& diff);
+// Renders the diff as text, one line per struct and one per member
+void PrintDiff(const ReflectionView& old, const ReflectionView& current, const LayoutDiff& diff, WriteBuffer& buf);
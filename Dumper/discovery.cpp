@@ -0,0 +1,142 @@
+#include "discovery.h"
+#include "wrappers.h"
+#include "memory.h"
+#include "context.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+static constexpr uint32_t ElementsPerChunk = 65536;
+// Objects that are checked per object array candidate, spread evenly across the array
+static constexpr uint32_t ObjectSamples = 64;
+// Class of every object ends up at 'Class', which is its own class
+static bool HasClassChain(UE_UObject object)
+{
+	UE_UObject current = object;
+	for (auto i = 0; i < 4; i++)
+	{
+		UE_UObject cls = current.GetClass();
+		if (!IsPointer(cls)) { return false; }
+		if (cls == current) { return true; }
+		current = cls;
+	}
+	return false;
+}
+
+static uint32_t ScoreObjectArray(const byte* data)
+{
+	TUObjectArray array;
+	memcpy(&array, data, sizeof(array));
+	if (!IsPointer(array.Objects) || (array.PreAllocatedObjects && !IsPointer(array.PreAllocatedObjects))) { return 0; }
+	if (!array.NumElements || array.NumElements > array.MaxElements || array.MaxElements > 0x4000000) { return 0; }
+	auto chunks = (array.NumElements + ElementsPerChunk - 1) / ElementsPerChunk;
+	if (array.NumChunks < chunks || array.NumChunks > chunks + 1 || array.NumChunks > array.MaxChunks) { return 0; }
+	if (array.MaxChunks > array.MaxElements / ElementsPerChunk + 1) { return 0; }
+
+	// Layout is plausible, objects are checked in the process
+	uint32_t score = 0;
+	auto step = array.NumElements > ObjectSamples ? array.NumElements / ObjectSamples : 1;
+	for (uint32_t id = 0; id < array.NumElements; id += step)
+	{
+		UE_UObject object = array.GetObjectPtr(id);
+		// Slots of destroyed objects are empty
+		if (!object) { continue; }
+		if (!IsPointer(object) || object.GetIndex() != id || !HasClassChain(object))
+		{
+			if (!id) { return 0; }
+			continue;
+		}
+		score++;
+	}
+	return score;
+}
+
+static uint32_t ScoreNamePool(const byte* data, const byte* end)
+{
+	// FNamePool { byte Lock[8]; uint32_t CurrentBlock; uint32_t CurrentByteCursor; byte* Blocks[8192]; }
+	uint32_t current = 0, cursor = 0;
+	memcpy(&current, data + 8, sizeof(current));
+	memcpy(&cursor, data + 12, sizeof(cursor));
+	if (current >= std::size(FNamePool{}.Blocks) || cursor > defs.Stride * ElementsPerChunk) { return 0; }
+	auto blocks = reinterpret_cast<byte* const*>(data + 16);
+	// Blocks in use are allocated and the next one isn't
+	if (reinterpret_cast<const byte*>(blocks + current + 2) > end) { return 0; }
+	for (uint32_t i = 0; i <= current; i++)
+	{
+		byte* block = nullptr;
+		memcpy(&block, blocks + i, sizeof(block));
+		if (!IsPointer(block)) { return 0; }
+	}
+	byte* next = nullptr;
+	memcpy(&next, blocks + current + 1, sizeof(next));
+	if (next) { return 0; }
+
+	// Layout is plausible, names are checked in the process
+	byte* block = nullptr;
+	memcpy(&block, blocks, sizeof(block));
+	uint32_t score = 0, offset = 0;
+	for (auto name : HardcodedNames)
+	{
+		auto entry = UE_FNameEntry(block + offset);
+		auto [wide, len] = entry.Info();
+		if (wide || len != strlen(name) || entry.String(wide, len) != name) { break; }
+		offset += UE_FNameEntry::Size(wide, len);
+		score++;
+	}
+	return score;
+}
+
+Discovery DiscoverGlobals(byte* base, const std::vector<ImageSection>& sections)
+{
+	Discovery discovery;
+	std::mutex mutex;
+	auto threads = std::thread::hardware_concurrency();
+	threads = threads ? threads : 1;
+
+	for (auto& section : sections)
+	{
+		// Data sections are small compared to code, each one is read whole
+		std::vector<byte> data(section.End - section.Start);
+		if (!Read(base + section.Start, data.data(), data.size())) { continue; }
+
+		// Stripes of aligned offsets are handed out to threads, candidates are validated with reads from the process
+		static constexpr size_t StripeSize = 1 << 16;
+		std::atomic<size_t> next = 0;
+		auto worker = [&]()
+		{
+			std::vector<Candidate> objects, names;
+			auto end = data.data() + data.size();
+			for (size_t start; (start = next.fetch_add(StripeSize)) < data.size();)
+			{
+				auto limit = std::min(start + StripeSize, data.size());
+				for (auto offset = start; offset < limit; offset += 8)
+				{
+					auto ptr = data.data() + offset;
+					if (ptr + sizeof(TUObjectArray) <= end)
+					{
+						if (auto score = ScoreObjectArray(ptr)) { objects.push_back({ section.Start + offset, score }); }
+					}
+					if (ptr + 16 <= end)
+					{
+						if (auto score = ScoreNamePool(ptr, end)) { names.push_back({ section.Start + offset, score }); }
+					}
+				}
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			discovery.ObjObjects.insert(discovery.ObjObjects.end(), objects.begin(), objects.end());
+			discovery.NamePoolData.insert(discovery.NamePoolData.end(), names.begin(), names.end());
+		};
+
+		std::vector<std::thread> pool;
+		for (unsigned i = 1; i < threads; i++) { pool.push_back(ContextThread(worker)); }
+		worker();
+		for (auto& thread : pool) { thread.join(); }
+	}
+
+	auto rank = [](const Candidate& lhs, const Candidate& rhs) { return lhs.Score != rhs.Score ? lhs.Score > rhs.Score : lhs.Offset < rhs.Offset; };
+	std::sort(discovery.ObjObjects.begin(), discovery.ObjObjects.end(), rank);
+	std::sort(discovery.NamePoolData.begin(), discovery.NamePoolData.end(), rank);
+	return discovery;
+}
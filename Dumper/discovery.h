@@ -0,0 +1,25 @@
+#pragma once
+#include "utils.h"
+#include <vector>
+
+// Structure found by its shape, offset is from the module base
+struct Candidate
+{
+	uint64_t Offset;
+	uint32_t Score;
+};
+
+struct Discovery
+{
+	// Best candidates go first, candidates with equal score are ordered by offset
+	std::vector<Candidate> ObjObjects;
+	std::vector<Candidate> NamePoolData;
+};
+
+/*
+* Fallback for builds where signatures don't match anymore.
+* Writable data sections are scanned on all cores for structures shaped like TUObjectArray and FNamePool,
+* every candidate that passes the layout checks is validated against the live process and scored.
+* Depends on 'defs', so the engine has to be initialized.
+*/
+Discovery DiscoverGlobals(byte* base, const std::vector<ImageSection>& sections);
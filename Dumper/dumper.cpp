@@ -0,0 +1,780 @@
+#include "dumper.h"
+#include "utils.h"
+#include "discovery.h"
+#include "inference.h"
+#include "memory.h"
+#include "queue.h"
+#include "trace.h"
+#include "context.h"
+#include "fingerprint.h"
+#include "database.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <unordered_set>
+
+thread_local bool Dumper::opened = false;
+
+const char* GetStatusMessage(int status)
+{
+	switch (status)
+	{
+	case SUCCESS: { return "Success"; }
+	case WINDOW_NOT_FOUND: { return "Can't find UE4 window"; }
+	case PROCESS_NOT_FOUND: { return "Can't find process"; }
+	case READER_ERROR: { return "Can't init reader"; }
+	case CANNOT_GET_PROCNAME: { return "Can't get process name"; }
+	case ENGINE_ERROR: { return "Can't find offsets for this game"; }
+	case MODULE_NOT_FOUND: { return "Can't enumerate modules (protected process?)"; }
+	case CANNOT_READ: { return "Can't read process memory"; }
+	case INVALID_IMAGE: { return "Can't get executable sections"; }
+	case NAMES_NOT_FOUND: { return "Can't find names array"; }
+	case OBJECTS_NOT_FOUND: { return "Can't find objects array"; }
+	case FILE_NOT_OPEN: { return "Can't open file"; }
+	case ZERO_PACKAGES: { return "Size of packages is zero"; }
+	case EXTRACTED: { return "Extracted"; }
+	case ARCHIVE_ERROR: { return "Can't extract archive"; }
+	case ALREADY_OPEN: { return "Another dumper is open"; }
+	case NOT_OPEN: { return "Dumper isn't open"; }
+	case SNAPSHOT_ERROR: { return "Can't load snapshot"; }
+	default: { return "Failed"; }
+	}
+}
+
+uint32_t FindGameWindow(const char* windowClass)
+{
+#ifndef _WIN32
+	return 0;
+#else
+	HWND hWnd = FindWindowA(windowClass, nullptr);
+	if (!hWnd) { return 0; }
+	DWORD pid = 0;
+	GetWindowThreadProcessId(hWnd, &pid);
+	return pid;
+#endif
+}
+
+// Finds offsets of the globals from the module base
+int Dumper::FindGlobals(byte* base, const std::vector<ImageSection>& sections, ScanCache& cache, bool validate) const
+{
+	MultiScanner scanner;
+	for (auto& [global, pattern] : Signatures) { scanner.Add(pattern); }
+
+	// Windows overlap by the longest pattern, a match belongs to the window it starts in
+	struct Window { uint32_t Start; uint32_t Size; uint32_t Limit; };
+	std::vector<Window> windows;
+	auto overlap = static_cast<uint32_t>(scanner.MaxPatternSize() - 1);
+	for (auto& section : sections)
+	{
+		for (auto start = section.Start; start < section.End; start += ScanWindow)
+		{
+			auto limit = section.End - start > ScanWindow ? start + ScanWindow : section.End;
+			auto end = section.End - limit > overlap ? limit + overlap : section.End;
+			windows.push_back({ start, end - start, limit - start });
+		}
+	}
+
+	std::vector<byte> buffers[2] = { std::vector<byte>(ScanWindow + overlap), std::vector<byte>(ScanWindow + overlap) };
+	// Windows are read on another thread, so it reads from the target of this one
+	auto target = GetReaderTarget();
+	// Gets the readable parts of the window in its buffer, empty if none of it can be read
+	auto read = [&](size_t i)
+	{
+		SetReaderTarget(target);
+		TraceScope trace("Read window");
+		auto& window = windows[i];
+		auto data = buffers[i % 2].data();
+		std::vector<MultiScanner::Range> readable;
+		if (Read(base + window.Start, data, window.Size))
+		{
+			readable.push_back({ data, data + window.Size });
+			return readable;
+		}
+		// Read of a partially committed section fails as a whole, so it's read again page by page and unreadable pages are skipped
+		for (uint32_t offset = 0; offset < window.Size;)
+		{
+			auto size = std::min(ScanPage - (window.Start + offset) % ScanPage, window.Size - offset);
+			if (Read(base + window.Start + offset, data + offset, size))
+			{
+				if (readable.size() && readable.back().second == data + offset) { readable.back().second += size; }
+				else { readable.push_back({ data + offset, data + offset + size }); }
+			}
+			offset += size;
+		}
+		return readable;
+	};
+	std::future<std::vector<MultiScanner::Range>> next;
+	if (windows.size()) { next = std::async(std::launch::async, read, 0); }
+
+	// Offset of the first match of every signature, 0 if it wasn't found yet
+	std::vector<uint64_t> offsets(std::size(Signatures));
+	size_t left = offsets.size();
+	bool readAny = false;
+	for (size_t i = 0; i < windows.size() && left; i++)
+	{
+		auto readable = next.get();
+		if (i + 1 < windows.size()) { next = std::async(std::launch::async, read, i + 1); }
+		if (readable.empty()) { continue; }
+		readAny = true;
+
+		auto& window = windows[i];
+		auto data = buffers[i % 2].data();
+		TraceScope trace("Scan window");
+		auto results = scanner.ScanParallel(readable);
+		for (size_t id = 0; id < results.size(); id++)
+		{
+			if (offsets[id] || !results[id] || results[id] - data >= window.Limit) { continue; }
+			auto address = reinterpret_cast<byte*>(ResolvePointer(const_cast<byte*>(results[id]), Signatures[id].second));
+			if (!address) { continue; }
+			offsets[id] = window.Start + (address - data);
+			left--;
+		}
+	}
+	if (!readAny) { return CANNOT_READ; }
+
+	// Hits of every global are its candidates, in the priority of 'Signatures'
+	std::vector<uint64_t> objects, names;
+	for (size_t i = 0; i < offsets.size(); i++)
+	{
+		if (!offsets[i]) { continue; }
+		auto& candidates = Signatures[i].first == Global::ObjObjects ? objects : names;
+		if (std::find(candidates.begin(), candidates.end(), offsets[i]) == candidates.end()) { candidates.push_back(offsets[i]); }
+	}
+
+	// Candidates can't be checked before offsets are inferred, then the first hit is used and validated after inference
+	if (!validate)
+	{
+		if (objects.empty()) { return OBJECTS_NOT_FOUND; }
+		if (names.empty()) { return NAMES_NOT_FOUND; }
+		cache.ObjObjects = objects.front();
+		cache.NamePoolData = names.front();
+		return SUCCESS;
+	}
+
+	// Every candidate is read and validated, the first one that looks alive is used
+	auto objectsAlive = [base](uint64_t offset) { return Read(base + offset, &ObjObjects, sizeof(ObjObjects)) && ValidateObjects(); };
+	auto namesAlive = [base](uint64_t offset) { return Read(base + offset, &NamePoolData, sizeof(NamePoolData)) && ValidateNames(); };
+	auto select = [](const std::vector<uint64_t>& candidates, auto alive)
+	{
+		for (auto offset : candidates) { if (alive(offset)) { return offset; } }
+		return uint64_t(0);
+	};
+	cache.ObjObjects = select(objects, objectsAlive);
+	cache.NamePoolData = select(names, namesAlive);
+
+	if (!(cache.ObjObjects && cache.NamePoolData))
+	{
+		// Signatures were broken by an update or hit something else, globals are looked for by the shape of their data
+		TraceScope trace("Discover globals");
+		auto discovery = DiscoverGlobals(base, GetDataSections(base));
+		auto discover = [this](const char* global, const std::vector<Candidate>& candidates, auto alive)
+		{
+			for (size_t i = 0; i < candidates.size(); i++)
+			{
+				if (!alive(candidates[i].Offset)) { continue; }
+				Print("Discovered {} at +0x{:X} (score {}, candidate {} of {})\n", global, candidates[i].Offset, candidates[i].Score, i + 1, candidates.size());
+				return candidates[i].Offset;
+			}
+			return uint64_t(0);
+		};
+		if (!cache.ObjObjects) { cache.ObjObjects = discover("ObjObjects", discovery.ObjObjects, objectsAlive); }
+		if (!cache.NamePoolData) { cache.NamePoolData = discover("NamePoolData", discovery.NamePoolData, namesAlive); }
+	}
+
+	if (!cache.ObjObjects) { return OBJECTS_NOT_FOUND; }
+	if (!cache.NamePoolData) { return NAMES_NOT_FOUND; }
+	return SUCCESS;
+}
+
+/*
+* Globals are read from the process and then checked to look alive:
+* the first name is "None" and the first object has index 0.
+*/
+int Dumper::ReadGlobals(byte* base, const ScanCache& cache)
+{
+	TraceScope trace("Read globals");
+	if (!Read(base + cache.ObjObjects, &ObjObjects, sizeof(ObjObjects))) { return CANNOT_READ; }
+	if (!Read(base + cache.NamePoolData, &NamePoolData, sizeof(NamePoolData))) { return CANNOT_READ; }
+	return SUCCESS;
+}
+
+bool Dumper::ValidateObjects()
+{
+	if (!(ObjObjects.Objects && ObjObjects.NumElements && ObjObjects.NumElements <= ObjObjects.MaxElements && ObjObjects.NumChunks <= ObjObjects.MaxChunks)) { return false; }
+	auto object = ObjObjects.GetObjectPtr(0);
+	return object && UE_UObject(object).GetIndex() == 0;
+}
+
+bool Dumper::ValidateNames()
+{
+	if (!(NamePoolData.CurrentBlock < std::size(NamePoolData.Blocks) && NamePoolData.Blocks[0])) { return false; }
+	auto entry = UE_FNameEntry(NamePoolData.GetEntry(0));
+	auto [wide, len] = entry.Info();
+	return !wide && len == 4 && entry.String(wide, len) == "None";
+}
+
+int Dumper::ValidateGlobals()
+{
+	if (!ValidateObjects()) { return OBJECTS_NOT_FOUND; }
+	if (!ValidateNames()) { return NAMES_NOT_FOUND; }
+	return SUCCESS;
+}
+
+int Dumper::Attach(byte* base, uint32_t size, const fs::path& cache)
+{
+	moduleBase = (size_t)base;
+
+	// Offsets are persisted per game, without a cache directory everything is found again on every open
+	fs::path dir;
+	if (!cache.empty())
+	{
+		dir = cache / game;
+		std::error_code ec;
+		fs::create_directories(dir, ec);
+	}
+	bool persist = !dir.empty();
+
+	ScanCache offsets;
+	{
+		TraceScope trace("Module read");
+		if (!GetModuleIdentity(base, offsets.Module)) { return INVALID_IMAGE; }
+	}
+
+	// Other dumpers of the same build wait until this one is attached and then reuse its results
+	std::shared_ptr<SharedScans::Entry> shared;
+	std::unique_lock<std::mutex> gameLock, sharing;
+	if (scans)
+	{
+		gameLock = scans->LockGame(game);
+		shared = scans->Get(offsets.Module);
+		sharing = std::unique_lock(shared->Mutex);
+	}
+
+	// Games without a hand-written profile get offsets inferred once per build
+	auto profilePath = dir / "Profile.bin";
+	bool profile = EngineInit(engine.empty() ? game : engine);
+	bool infer = !profile;
+#ifndef DUMPER_PROFILE
+	if (infer && shared && shared->Inferred) { defs = shared->Profile; infer = false; }
+	if (infer && persist && LoadProfile(profilePath, offsets.Module, defs)) { infer = false; }
+#endif
+
+	// Offsets found for the same build of the game are reused, so scanning is skipped after the first run
+	auto cachePath = dir / "ScanCache.txt";
+	bool cached = shared && shared->Found;
+	if (cached) { offsets = shared->Cache; }
+	else { cached = persist && LoadScanCache(cachePath, offsets.Module, offsets); }
+	int found = FAILED;
+	for (auto scan = !cached; ; scan = true)
+	{
+		if (scan)
+		{
+			TraceScope trace("Section scan");
+			cached = false;
+			auto sections = GetExSections(base);
+			if (!sections.size()) { return INVALID_IMAGE; }
+			// Candidates are validated with offsets, so they can't be checked before they're inferred
+			found = FindGlobals(base, sections, offsets, !infer);
+			if (found != SUCCESS) { return found; }
+		}
+		found = ReadGlobals(base, offsets);
+		if (found == SUCCESS && infer)
+		{
+			TraceScope trace("Infer offsets");
+			if (!InferOffsets(base, size)) { found = ENGINE_ERROR; }
+		}
+		if (found == SUCCESS) { found = ValidateGlobals(); }
+		// Stale cache is replaced by a fresh scan
+		if (found == SUCCESS || scan) { break; }
+	}
+	if (found != SUCCESS) { return found; }
+	objectsAddress = base + offsets.ObjObjects;
+	namesAddress = base + offsets.NamePoolData;
+	if (shared && !shared->Found)
+	{
+		shared->Found = true;
+		shared->Cache = offsets;
+		shared->Inferred = !profile;
+		shared->Profile = defs;
+	}
+
+	if (infer)
+	{
+		Print("Inferred offsets\n");
+		if (persist && !SaveProfile(profilePath, offsets.Module, defs)) { Print("Can't write: {}\n", profilePath.string()); }
+	}
+	if (cached) { Print("Using cached offsets\n"); }
+	else if (persist && !SaveScanCache(cachePath, offsets)) { Print("Can't write: {}\n", cachePath.string()); }
+
+	return SUCCESS;
+}
+
+bool Dumper::Acquire()
+{
+	Close();
+	if (opened) { return false; }
+	opened = open = true;
+	ResetContext();
+	return true;
+}
+
+int Dumper::Open(uint32_t pid, const fs::path& cache)
+{
+	if (!Acquire()) { return ALREADY_OPEN; }
+	TraceScope trace("Init");
+	auto fail = [this](int status) { Close(); return status; };
+
+	if (!pid) { return fail(PROCESS_NOT_FOUND); }
+	if (!ReaderInit(pid)) { return fail(READER_ERROR); }
+
+	fs::path processName;
+	{
+		wchar_t processPath[MAX_PATH]{};
+		if (!GetProccessPath(pid, processPath, MAX_PATH)) { return fail(CANNOT_GET_PROCNAME); }
+		processName = fs::path(processPath).filename();
+		Print("Found UE4 game: {}\n", processName.string());
+	}
+	game = processName.stem().string();
+
+	auto [base, size] = GetModuleInfo(pid, processName.wstring());
+	if (!(base && size)) { return fail(MODULE_NOT_FOUND); }
+
+	auto status = Attach(base, size, cache);
+	return status == SUCCESS ? status : fail(status);
+}
+
+int Dumper::Open(const uint8_t* image, size_t size, uint64_t base, uint64_t moduleBase, uint32_t moduleSize, std::string game, const fs::path& cache)
+{
+	if (!Acquire()) { return ALREADY_OPEN; }
+	TraceScope trace("Init");
+	ReaderInit(image, base, size);
+	this->game = std::move(game);
+	auto status = Attach(reinterpret_cast<byte*>(moduleBase), moduleSize, cache);
+	if (status != SUCCESS) { Close(); }
+	return status;
+}
+
+int Dumper::OpenSnapshot(const fs::path& path, const fs::path& cache)
+{
+	Close();
+	Snapshot loaded;
+	if (!LoadSnapshot(path, loaded) || loaded.ModuleSize > UINT32_MAX) { return SNAPSHOT_ERROR; }
+	auto status = Open(loaded.Image.data(), loaded.Image.size(), loaded.Base, loaded.ModuleBase, static_cast<uint32_t>(loaded.ModuleSize), loaded.Game, cache);
+	// Moving the image keeps its storage, so the reader still points at it
+	if (status == SUCCESS) { snapshot = std::move(loaded); }
+	return status;
+}
+
+void Dumper::Close()
+{
+	if (!open) { return; }
+	ResetContext();
+	snapshot = {};
+	game.clear();
+	moduleBase = 0;
+	objectsAddress = nullptr;
+	namesAddress = nullptr;
+	open = false;
+	opened = false;
+}
+
+size_t Dumper::DumpNames(const std::function<void(std::string_view name, uint32_t id)>& callback) const
+{
+	if (!open) { return 0; }
+	size_t size = 0;
+	NamePoolData.Dump([&callback, &size](std::string_view name, uint32_t id) { callback(name, id); size++; });
+	return size;
+}
+
+size_t Dumper::DumpObjects(const std::function<void(UE_UObject object)>& callback) const
+{
+	if (!open) { return 0; }
+	size_t size = 0;
+	ObjObjects.Dump([&callback, &size](UE_UObject object) { callback(object); size++; });
+	return size;
+}
+
+// Adds the time and the reads of the calling thread between construction and destruction to the stage
+class StageScope
+{
+private:
+	Dumper::Stage& stage;
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	uint64_t reads = GetThreadReadCount();
+public:
+	StageScope(Dumper::Stage& stage) : stage(stage) {}
+	~StageScope()
+	{
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+		stage.Seconds += elapsed.count();
+		stage.Reads += GetThreadReadCount() - reads;
+	}
+	StageScope(const StageScope&) = delete;
+	StageScope& operator=(const StageScope&) = delete;
+};
+
+static void AddStage(Dumper::Stage& total, const Dumper::Stage& stage)
+{
+	total.Items += stage.Items;
+	total.Seconds += stage.Seconds;
+	total.Reads += stage.Reads;
+}
+
+/*
+* Packages are generated by a pipeline of stages connected with bounded queues:
+* enumerate (structs and enums) -> group (by package) -> generate (one package per worker) -> write.
+* Objects of a package are created together, so a package is taken as complete once enumeration is 'PackageWindow' types past its last one,
+* and it's generated while enumeration goes on. Grouping only holds types of packages that are still open, generated packages are released
+* as soon as they're queued for writing. A type that turns up after its package was handed over, e.g. in a slot freed by an earlier load,
+* makes the package late: it's generated again after enumeration with the types of its first part and the late ones, replacing its files and records.
+* Only plain files can be replaced, so other writers get the packages when enumeration is over.
+*/
+int Dumper::GeneratePackages(Writer& writer, const fs::path& dir, ReflectionBuilder& reflection)
+{
+	using Package = std::pair<byte* const, std::vector<UE_UObject>>;
+	// Struct or enum with its slot, and its hash if it's fingerprinted
+	struct Type
+	{
+		UE_UObject Object;
+		uint32_t Index = 0;
+		std::optional<uint64_t> Hash;
+	};
+	struct Job
+	{
+		std::unique_ptr<Package> Objects;
+		// Generated again with every type of the package after enumeration
+		bool Late = false;
+		uint64_t Fingerprint = 0;
+	};
+	struct Group
+	{
+		std::vector<UE_UObject> Objects;
+		// Types that turned up after the package was queued
+		std::vector<UE_UObject> Late;
+		// Hashes of all types of the package, the late ones as well
+		std::vector<uint64_t> Hashes;
+		// Types of the package so far, it's generated only with two or more
+		uint32_t Count = 0;
+		// Number of the last type in the order of enumeration
+		uint64_t Last = 0;
+		// Slots of the types that were queued, they're read again only if the package is late
+		uint32_t First = UINT32_MAX;
+		uint32_t Until = 0;
+		bool Queued = false;
+	};
+	struct Result
+	{
+		UE_UObject Package;
+		bool Rendered = false;
+		bool Unchanged = false;
+		bool Late = false;
+		PackageFingerprint Fingerprint;
+	};
+
+	TraceScope trace("Generate packages");
+	auto path = dir / "DUMP";
+	stages = {};
+
+	// Fingerprints are removed until the dump is complete, so headers of an interrupted dump are never taken as up to date
+	auto fingerprintsPath = dir / "Fingerprints.bin";
+	bool fingerprints = incremental && writer.WritesPlainFiles();
+	std::vector<PackageFingerprint> previous;
+	// Structs of packages that aren't generated again are taken from the last database
+	ReflectionDatabase database;
+	if (writer.WritesPlainFiles())
+	{
+		if (fingerprints && database.Load(dir / "Reflection.bin"))
+		{
+			LoadFingerprints(fingerprintsPath, previous);
+			database.IndexPackages();
+		}
+		std::error_code error;
+		fs::remove(fingerprintsPath, error);
+	}
+
+	auto workers = threadCount ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+	// Workers test and name classes, so the classes are found once here instead of on every worker
+	GetClasses();
+	GetActorClass();
+	BlockingQueue<Type> objects(4096);
+	BlockingQueue<Job> pending(workers * 2);
+	BlockingQueue<Result> results(workers * 2);
+	std::atomic<size_t> queued = 0;
+	size_t total = 0;
+	size_t wiped = 0;
+	std::atomic<uint32_t> running = workers;
+	std::vector<std::thread> threads;
+	// Late packages go to their own builders, their first records are skipped when the builders are merged
+	std::vector<ReflectionBuilder> builders(workers);
+	std::vector<ReflectionBuilder> lateBuilders(workers);
+	// Every thread counts its own stages, they're summed when the threads are done
+	Stage enumerate, grouping;
+	std::vector<PackageStages> workerStages(workers);
+
+	// Types are fingerprinted here from the fields that are read anyway, so unchanged packages are never read again
+	threads.push_back(ContextThread([this, fingerprints, &objects, &enumerate]()
+	{
+		TraceThread("Enumerate");
+		TraceScope trace("Enumerate");
+		// Blocks while grouping is behind, so the time includes waits for the queue
+		StageScope stage(enumerate);
+		LayoutHasher hasher(moduleBase);
+		ObjObjects.ForEach([fingerprints, &objects, &enumerate, &hasher](byte* address, uint32_t i)
+		{
+			UE_UObject object = address;
+			auto kind = hasher.GetKind(object.GetClass());
+			if (kind == TypeKind::Other) { return; }
+			objects.Push({ object, i, fingerprints ? hasher.HashType(object, kind) : std::nullopt });
+			enumerate.Items++;
+		});
+		objects.Close();
+	}));
+
+	threads.push_back(ContextThread([early = writer.WritesPlainFiles(), &objects, &pending, &queued, &total, &wiped, &grouping]()
+	{
+		TraceThread("Group");
+		std::unordered_map<byte*, Group> groups;
+		// Open packages by the number of a type, a package is complete when its last type leaves the window
+		std::deque<std::pair<byte*, uint64_t>> window;
+		auto push = [&pending, &queued, &grouping](byte* package, std::vector<UE_UObject>&& objects, const Group& group, bool late)
+		{
+			queued++;
+			grouping.Items++;
+			pending.Push({ std::make_unique<Package>(package, std::move(objects)), late, LayoutHasher::HashPackage(group.Hashes) });
+		};
+		auto close = [&push](byte* package, Group& group)
+		{
+			group.Queued = true;
+			if (group.Count > 1) { push(package, std::move(group.Objects), group, false); }
+			group.Objects = {};
+		};
+
+		{
+			TraceScope trace("Grouping");
+			// Time of the stage includes waits for types and for free workers
+			StageScope stage(grouping);
+			Type type;
+			uint64_t last = 0;
+			while (objects.Pop(type))
+			{
+				auto [object, index, hash] = type;
+				auto package = object.GetPackageObject();
+				auto& group = groups[package];
+				group.Count++;
+				if (hash) { group.Hashes.push_back(*hash); }
+				if (group.Queued) { group.Late.push_back(object); continue; }
+				group.Objects.push_back(object);
+				group.First = std::min(group.First, index);
+				group.Until = index;
+				group.Last = ++last;
+				if (!early) { continue; }
+				window.emplace_back(package, last);
+				while (window.front().second + PackageWindow <= last)
+				{
+					auto [oldest, number] = window.front();
+					window.pop_front();
+					auto& open = groups[oldest];
+					if (!open.Queued && open.Last == number) { close(oldest, open); }
+				}
+			}
+		}
+		for (auto& [package, group] : groups)
+		{
+			if (!group.Queued) { close(package, group); }
+			if (group.Count > 1) { total++; }
+		}
+		wiped = groups.size() - total;
+
+		// Types that were queued are read again from their slots instead of keeping every type until the end
+		for (auto& [package, group] : groups)
+		{
+			if (group.Late.empty() || group.Count < 2) { continue; }
+			TraceScope trace("Late package");
+			StageScope stage(grouping);
+			std::vector<UE_UObject> types;
+			for (auto i = group.First; i <= group.Until; i++)
+			{
+				UE_UObject object = ObjObjects.GetObjectPtr(i);
+				if (object && (object.IsA<UE_UStruct>() || object.IsA<UE_UEnum>()) && object.GetPackageObject() == UE_UObject(package)) { types.push_back(object); }
+			}
+			types.insert(types.end(), group.Late.begin(), group.Late.end());
+			push(package, std::move(types), group, true);
+		}
+		pending.Close();
+	}));
+
+	// Rendered files go straight to the writer thread
+	for (auto i = 0u; i < workers; i++)
+	{
+		threads.push_back(ContextThread([this, i, fingerprints, &path, &previous, &database, &builders, &lateBuilders, &pending, &results, &running, &writer, &workerStages]()
+		{
+			TraceThread(fmt::format("Worker {}", i));
+			Job job;
+			std::vector<FileBuffer> files;
+			auto& stage = workerStages[i];
+			while (pending.Pop(job))
+			{
+				std::optional<StageScope> process(stage.Process);
+				stage.Process.Items++;
+				auto& package = *job.Objects;
+				auto& builder = job.Late ? lateBuilders[i] : builders[i];
+				Result result{ UE_UObject(package.first) };
+				result.Late = job.Late;
+				if (fingerprints)
+				{
+					// Packages are keyed by the names of their headers, so packages whose headers collide are always generated
+					auto name = result.Package.GetName();
+					auto& fingerprint = result.Fingerprint;
+					fingerprint.Package = ReflectionHash(name);
+					fingerprint.Fingerprint = job.Fingerprint;
+					// Headers of an unchanged package are kept, unless they're gone or a late package replaced them with a part of it
+					auto last = FindFingerprint(previous, fingerprint.Package);
+					if (last && last->Fingerprint == fingerprint.Fingerprint && !job.Late)
+					{
+						if ((!(last->Files & ClassesFile) || fs::exists(path / (name + "_classes.h"))) && (!(last->Files & StructFile) || fs::exists(path / (name + "_struct.h"))))
+						{
+							auto& records = database.GetPackage(name);
+							builder.AddStructs(database.View(), records.Structs);
+							builder.AddEnums(database.View(), records.Enums);
+							fingerprint.Files = last->Files;
+							result.Rendered = last->Files != 0;
+							result.Unchanged = true;
+							process.reset();
+							results.Push(result);
+							continue;
+						}
+					}
+				}
+
+				UE_UPackage generator(package);
+				generator.Process(moduleBase);
+				generator.Export(builder);
+				result.Rendered = generator.Render(path, files);
+				for (auto& file : files) { result.Fingerprint.Files |= file.Path.filename().string().ends_with("_classes.h") ? ClassesFile : StructFile; }
+				process.reset();
+				{
+					// Blocks while the writer is behind, so long events here are I/O stalls
+					TraceScope trace("Save");
+					StageScope save(stage.Save);
+					stage.Save.Items += files.size();
+					for (auto& file : files) { writer.Write(std::move(file.Path), std::move(file.Data)); }
+				}
+				files.clear();
+				results.Push(result);
+			}
+			if (--running == 0) { results.Close(); }
+		}));
+	}
+
+	// Results by package, the result of a late package replaces the one of its first part
+	std::unordered_map<byte*, Result> done;
+	std::unordered_set<std::string> late;
+	size_t i = 1;
+	Result result;
+	while (results.Pop(result))
+	{
+		Print("\rProcessing: {}/{}", i++, queued.load());
+		if (result.Late) { late.insert(result.Package.GetName()); }
+		done[result.Package] = result;
+	}
+
+	for (auto& thread : threads) { thread.join(); }
+	stages.Enumerate = enumerate;
+	stages.Grouping = grouping;
+	for (auto& worker : workerStages)
+	{
+		AddStage(stages.Process, worker.Process);
+		AddStage(stages.Save, worker.Save);
+	}
+
+	Print("\nWiped {} out of {}", wiped, wiped + total);
+	// Checking if we have any package after clearing.
+	if (!total) { return ZERO_PACKAGES; }
+	Print("\nPackages: {}", total);
+	if (late.size()) { Print("\nLate packages: {}", late.size()); }
+
+	int saved = 0; int unchanged = 0;
+	std::string unsaved{};
+	std::vector<PackageFingerprint> current;
+	for (auto& [package, result] : done)
+	{
+		if (result.Rendered) { saved++; }
+		else { unsaved += (result.Package.GetName() + ", "); }
+		if (result.Unchanged) { unchanged++; }
+		if (fingerprints) { current.push_back(result.Fingerprint); }
+	}
+
+	auto skip = [&late](std::string_view package) { return late.contains(std::string(package)); };
+	for (auto& builder : builders) { reflection.Merge(builder, late.size() ? skip : std::function<bool(std::string_view)>()); }
+	for (auto& builder : lateBuilders) { reflection.Merge(builder); }
+	Print("\nReflection structs: {}, enums: {}", reflection.GetStructCount(), reflection.GetEnumCount());
+	writer.WriteBinary(dir / "Reflection.bin", reflection.Serialize());
+	// Queued after every header and the database, so the writer stores them last
+	if (fingerprints) { writer.WriteBinary(fingerprintsPath, SerializeFingerprints(current)); }
+
+	Print("\nSaved packages: {}", saved);
+	if (fingerprints) { Print("\nUnchanged packages: {}", unchanged); }
+
+	if (unsaved.size())
+	{
+		unsaved.erase(unsaved.size() - 2);
+		Print("\nUnsaved packages (empty classes): [ {} ]", unsaved);
+	}
+
+	return SUCCESS;
+}
+
+int Dumper::Dump(Writer& writer, const fs::path& dir, uint32_t parts)
+{
+	if (!open) { return NOT_OPEN; }
+
+	/*
+	* Names dumping.
+	* We go through each block, except last, that is not fully filled.
+	* In each block we calculate next entry depending on previous entry size.
+	*/
+	// Names dumped with the packages are stored in the reflection database as well
+	ReflectionBuilder reflection;
+	if (parts & Names)
+	{
+		TraceScope trace("Names dump");
+		WriteStream file(writer, dir / "NamesDump.txt");
+		bool packages = parts & Packages;
+		auto size = DumpNames([&file, &reflection, packages](std::string_view name, uint32_t id)
+		{
+			file.Print("[{:0>6}] {}\n", id, name);
+			if (packages) { reflection.AddName(id, name); }
+		});
+		Print("Names: {}\n", size);
+	}
+
+	int result = SUCCESS;
+	size_t size = 0;
+	auto dump = [this, &writer, &dir, &size]()
+	{
+		TraceScope trace("Objects dump");
+		WriteStream file(writer, dir / "ObjectsDump.txt");
+		size = DumpObjects([&file](UE_UObject object) { file.Print("[{:0>6}] <{}> {}\n", object.GetIndex(), object.GetAddress(), object.GetFullName()); });
+	};
+
+	if (parts & Packages)
+	{
+		// Resolving full names of every object is the slowest walk, so it runs while packages are generated
+		std::thread objectsThread;
+		if (parts & Objects) { objectsThread = ContextThread([&dump]() { TraceThread("Objects"); dump(); }); }
+		result = GeneratePackages(writer, dir, reflection);
+		if (objectsThread.joinable()) { objectsThread.join(); }
+		Print("\n");
+	}
+	else if (parts & Objects)
+	{
+		dump();
+	}
+	if (parts & Objects) { Print("Objects: {}\n", size); }
+
+	return result;
+}
@@ -0,0 +1,181 @@
+#pragma once
+#include <fmt/format.h>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include "wrappers.h"
+#include "writer.h"
+#include "scanner.h"
+#include "pe.h"
+#include "cache.h"
+#include "snapshot.h"
+
+namespace fs = std::filesystem;
+
+enum {
+	SUCCESS,
+	FAILED,
+	WINDOW_NOT_FOUND,
+	PROCESS_NOT_FOUND,
+	READER_ERROR,
+	CANNOT_GET_PROCNAME,
+	ENGINE_ERROR,
+	MODULE_NOT_FOUND,
+	CANNOT_READ,
+	INVALID_IMAGE,
+	NAMES_NOT_FOUND,
+	OBJECTS_NOT_FOUND,
+	FILE_NOT_OPEN,
+	ZERO_PACKAGES,
+	EXTRACTED,
+	ARCHIVE_ERROR,
+	ALREADY_OPEN,
+	NOT_OPEN,
+	SNAPSHOT_ERROR
+};
+
+// Describes a status code in a few words, e.g. to print it before exiting
+const char* GetStatusMessage(int status);
+
+// Finds the process that owns a window of the class, 0 if there's no such window
+uint32_t FindGameWindow(const char* windowClass = "UnrealWindow");
+
+/*
+* Dumps one game: attaches to the process or to an image of it, finds the globals and dumps names, objects and packages.
+* Engine state is per thread (see context.h), so one dumper can be open per thread and it's used from the thread that opened it,
+* others fail to open with ALREADY_OPEN. Games are dumped side by side from several threads, see batch.h.
+* An open dumper stays attached, so names, objects and packages can be dumped again without scanning.
+*/
+class Dumper
+{
+public:
+	// Parts of a dump, combined as flags
+	enum Part : uint32_t
+	{
+		Names = 1,
+		Objects = 2,
+		Packages = 4,
+		All = Names | Objects | Packages
+	};
+	// Receives progress of the dumper, lines end with '\n', progress that replaces itself starts with '\r'
+	using Log = std::function<void(const std::string&)>;
+	// Work of one stage of package generation, time and reads are summed over the threads that ran it
+	struct Stage
+	{
+		size_t Items = 0;
+		double Seconds = 0;
+		uint64_t Reads = 0;
+	};
+	/*
+	* Stages of the last package generation: structs and enums taken from the object array and fingerprinted, packages grouped from them,
+	* packages processed and rendered, and files handed to the writer.
+	*/
+	struct PackageStages
+	{
+		Stage Enumerate;
+		Stage Grouping;
+		Stage Process;
+		Stage Save;
+	};
+private:
+	enum class Global
+	{
+		ObjObjects,
+		NamePoolData
+	};
+	/*
+	* Signatures of instructions that reference globals, all of them are found in one parallel pass over the executable sections.
+	* Earlier entries of the same global have priority, new patterns can be added here at no extra scan cost.
+	*/
+	static constexpr std::pair<Global, Pattern> Signatures[] =
+	{
+		{ Global::ObjObjects, Pattern("48 8B 05 ?? ?? ?? ?? 48 8B 0C C8 48 8D 04 D1 EB", 3) },
+		{ Global::ObjObjects, Pattern("48 8B 0D ?? ?? ?? ?? 81 4C D1 08 00 00 00 40", 3) },
+		{ Global::ObjObjects, Pattern("48 8D 1D ?? ?? ?? ?? 39 44 24 68", 3) },
+		{ Global::NamePoolData, Pattern("48 8D 35 ?? ?? ?? ?? EB 16", 3) },
+	};
+	// Executable sections are read in windows of this size, the next window is read while the current one is scanned
+	static constexpr uint32_t ScanWindow = 16 << 20;
+	// Windows that can't be read at once are read in pages of this size, so unreadable pages are skipped
+	static constexpr uint32_t ScanPage = 0x1000;
+	// Package is taken as complete once enumeration is this many structs and enums past its last one, see GeneratePackages
+	static constexpr uint64_t PackageWindow = 16384;
+	static thread_local bool opened;
+	bool open = false;
+	// Package workers, 0 for one per hardware thread
+	uint32_t threadCount = 0;
+	bool incremental = false;
+	SharedScans* scans = nullptr;
+	// Engine profile, the game's own if it's empty
+	std::string engine;
+	std::string game;
+	size_t moduleBase = 0;
+	// Addresses of the globals in the target
+	byte* objectsAddress = nullptr;
+	byte* namesAddress = nullptr;
+	// Image of a loaded snapshot, reads are served from it
+	Snapshot snapshot;
+	PackageStages stages;
+	Log log;
+	template<typename S, typename... Args>
+	void Print(const S& format, const Args&... args) const
+	{
+		if (log) { log(fmt::format(format, args...)); }
+	}
+	bool Acquire();
+	// Signature hits and then discovered candidates are tried until one of them looks alive, only the first hit is taken without 'validate'
+	int FindGlobals(byte* base, const std::vector<ImageSection>& sections, ScanCache& cache, bool validate) const;
+	static int ReadGlobals(byte* base, const ScanCache& cache);
+	static bool ValidateObjects();
+	static bool ValidateNames();
+	static int ValidateGlobals();
+	// Finds globals of the module and the engine offsets, 'cache' is the directory of cached offsets
+	int Attach(byte* base, uint32_t size, const fs::path& cache);
+	int GeneratePackages(Writer& writer, const fs::path& dir, ReflectionBuilder& reflection);
+public:
+	Dumper() = default;
+	~Dumper() { Close(); }
+	Dumper(const Dumper&) = delete;
+	Dumper& operator=(const Dumper&) = delete;
+	void SetLog(Log log) { this->log = std::move(log); }
+	void SetThreads(uint32_t threads) { threadCount = threads; }
+	// Reuses scan results of dumpers of the same build, 'scans' has to outlive the dumper
+	void SetSharedScans(SharedScans* scans) { this->scans = scans; }
+	/*
+	* Generates and writes only packages whose fingerprint changed since the last dump into the same directory, see fingerprint.h.
+	* Fingerprints are kept in '<dir>/Fingerprints.bin', and only when the writer writes plain files.
+	*/
+	void SetIncremental(bool incremental) { this->incremental = incremental; }
+	// Selects the engine profile by name instead of by the game, e.g. for a build whose process was renamed
+	void SetEngine(std::string engine) { this->engine = std::move(engine); }
+	/*
+	* Attaches to the game process.
+	* Offsets found for a build are cached in '<cache>/<game>' and reused on the next open, nothing is cached if 'cache' is empty.
+	*/
+	int Open(uint32_t pid, const fs::path& cache);
+	// Reads from an image of the process that the caller keeps alive until the dumper is closed, 'game' selects the engine profile
+	int Open(const uint8_t* image, size_t size, uint64_t base, uint64_t moduleBase, uint32_t moduleSize, std::string game, const fs::path& cache);
+	int OpenSnapshot(const fs::path& path, const fs::path& cache);
+	void Close();
+	bool IsOpen() const { return open; }
+	// Name of the game, process name without extension for processes
+	const std::string& GetGame() const { return game; }
+	size_t GetModuleBase() const { return moduleBase; }
+	// Addresses of 'ObjObjects' and 'NamePoolData' in the target, e.g. to read them again while it runs
+	byte* GetObjectsAddress() const { return objectsAddress; }
+	byte* GetNamesAddress() const { return namesAddress; }
+	// Both return the number of dumped items
+	size_t DumpNames(const std::function<void(std::string_view name, uint32_t id)>& callback) const;
+	size_t DumpObjects(const std::function<void(UE_UObject object)>& callback) const;
+	/*
+	* Queues files of the dump in 'writer', paths start with 'dir':
+	* 'NamesDump.txt', 'ObjectsDump.txt' and package headers in 'DUMP'.
+	* Directories are created by the caller, the writer may as well store files elsewhere.
+	*/
+	int Dump(Writer& writer, const fs::path& dir, uint32_t parts = All);
+	// Stages of the packages of the last dump, e.g. to tell processing from writing
+	const PackageStages& GetPackageStages() const { return stages; }
+};
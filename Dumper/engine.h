@@ -2,6 +2,7 @@
 #include <cstdint>
 #include <unordered_map>
 #include <functional>
+#include <string>
 
 struct Offsets {
 	uint16_t Stride = 0; // alignof(FNameEntry)
@@ -114,6 +115,17 @@ struct Offsets {
 	} FUObjectItem;
 };
 
-extern Offsets defs;
+/*
+* Offsets are selected at runtime by the game name by default.
+* Builds for a single game can define DUMPER_PROFILE as the name of its profile (e.g. DUMPER_PROFILE=DeadByDaylight),
+* then 'defs' is a constant and every offset in the accessors is an immediate, inference and saved profiles are disabled.
+*/
+#ifdef DUMPER_PROFILE
+#include "profiles.h"
+#include <bit>
+inline constexpr Offsets defs = std::bit_cast<Offsets>(DUMPER_PROFILE{});
+#else
+extern thread_local Offsets defs;
+#endif
 
 bool EngineInit(std::string game);
\ No newline at end of file
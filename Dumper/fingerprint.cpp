@@ -0,0 +1,354 @@
+#include "fingerprint.h"
+#include "memory.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+
+static constexpr char FingerprintMagic[4] = { 'U', 'D', 'F', 'P' };
+
+// Properties whose rendered type depends on more than their class, see 'UE_FProperty::GetType'
+enum class PropertyKind : uint8_t
+{
+	Plain,
+	Struct,
+	Object,
+	Class,
+	Enum,
+	Bool,
+	Array,
+	Set,
+	Map,
+	Interface
+};
+
+static PropertyKind GetPropertyKind(std::string_view name)
+{
+	// Weak object properties are rendered from the struct slot
+	if (name == "StructProperty" || name == "WeakObjectProperty") { return PropertyKind::Struct; }
+	if (name == "ObjectProperty" || name == "SoftObjectProperty") { return PropertyKind::Object; }
+	if (name == "ClassProperty") { return PropertyKind::Class; }
+	if (name == "EnumProperty") { return PropertyKind::Enum; }
+	if (name == "BoolProperty") { return PropertyKind::Bool; }
+	if (name == "ArrayProperty") { return PropertyKind::Array; }
+	if (name == "SetProperty") { return PropertyKind::Set; }
+	if (name == "MapProperty") { return PropertyKind::Map; }
+	if (name == "InterfaceProperty") { return PropertyKind::Interface; }
+	return PropertyKind::Plain;
+}
+
+static uint64_t Mix(uint64_t value)
+{
+	// Finalizer of splitmix64
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+	return value ^ (value >> 31);
+}
+
+static void Add(uint64_t& hash, uint64_t value)
+{
+	hash = (hash ^ Mix(value)) * 0x100000001B3ull;
+}
+
+// Fields of an object or a property read at once
+class FieldWindow
+{
+private:
+	static constexpr uint16_t MaxSize = 0x200;
+	byte* address;
+	ReadTag tag;
+	uint16_t size;
+	bool valid;
+	uint8_t data[MaxSize];
+public:
+	FieldWindow(byte* address, uint16_t size, ReadTag tag) : address(address), tag(tag), size(std::min(size, MaxSize))
+	{
+		valid = Read(address, data, this->size, tag);
+	}
+	// Fields past the window, or of a window that can't be read as a whole, e.g. at the end of a mapping, are read one by one
+	template<typename T>
+	T Get(uint16_t offset) const
+	{
+		if (!valid || offset + sizeof(T) > size) { return Read<T>(address + offset, tag); }
+		T value;
+		memcpy(&value, data + offset, sizeof(T));
+		return value;
+	}
+};
+
+// Enums with more entries than this are taken as broken, their entries are read one by one
+static constexpr uint32_t MaxEnumNames = 0x10000;
+
+// Field of an enum entry, from the entries that were read at once or from the target if they couldn't be
+template<typename T>
+static T GetEntry(const std::vector<uint8_t>& entries, byte* data, uint64_t offset)
+{
+	if (entries.empty()) { return Read<T>(data + offset, ReadTag::Enum); }
+	T value;
+	memcpy(&value, entries.data() + offset, sizeof(T));
+	return value;
+}
+
+static uint16_t WindowEnd(std::initializer_list<uint32_t> ends)
+{
+	return static_cast<uint16_t>(std::max(ends));
+}
+
+LayoutHasher::LayoutHasher(size_t moduleBase) : moduleBase(moduleBase)
+{
+	auto name = std::max(defs.FName.ComparisonIndex, defs.FName.Number) + 4u;
+	objectWindow = WindowEnd({ defs.UObject.Class + 8u, defs.UObject.Name + name, defs.UObject.Outer + 8u, defs.UField.Next + 8u,
+		defs.UStruct.SuperStruct + 8u, defs.UStruct.Children + 8u, defs.UStruct.ChildProperties + 8u, defs.UStruct.PropertiesSize + 4u, defs.UEnum.Names + 16u });
+	functionWindow = WindowEnd({ objectWindow, defs.UFunction.Flags + 4u, defs.UFunction.FuncPtr + 8u });
+	propertyWindow = WindowEnd({ defs.FField.Class + 8u, defs.FField.Next + 8u, defs.FField.Name + name,
+		defs.FProperty.ArrayDim + 4u, defs.FProperty.ElementSize + 4u, defs.FProperty.PropertyFlags + 8u, defs.FProperty.Offset + 4u,
+		defs.FStructProperty.Struct + 8u, defs.FObjectPropertyBase.PropertyClass + 8u, defs.FClassProperty.MetaClass + 8u, defs.FEnumProperty.Enum + 8u,
+		defs.FArrayProperty.Inner + 8u, defs.FSetProperty.ElementProp + 8u, defs.FMapProperty.KeyProp + 8u, defs.FMapProperty.ValueProp + 8u,
+		defs.FInterfaceProperty.InterfaceClass + 8u, defs.FBoolProperty.FieldMask + 1u });
+}
+
+uint64_t LayoutHasher::HashName(uint32_t index, uint32_t number)
+{
+	auto [it, inserted] = names.try_emplace(static_cast<uint64_t>(index) << 32 | number, 0);
+	if (!inserted) { return it->second; }
+
+	auto entry = UE_FNameEntry(NamePoolData.GetEntry(index));
+	auto [wide, len] = entry.Info();
+	// Wide names are converted in place and may come out shorter, so the rest of the buffer has to be zeroed
+	char buf[1024]{};
+	if (len <= sizeof(buf)) { entry.String(buf, wide, len); }
+	else { len = 0; }
+	// FNV-1a
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (auto i = 0u; i < len; i++) { hash = (hash ^ static_cast<uint8_t>(buf[i])) * 0x100000001B3ull; }
+	Add(hash, number);
+	it->second = hash;
+	return hash;
+}
+
+uint64_t LayoutHasher::HashName(byte* fname)
+{
+	FieldWindow name(fname, std::max(defs.FName.ComparisonIndex, defs.FName.Number) + 4, ReadTag::Name);
+	return HashName(name.Get<uint32_t>(defs.FName.ComparisonIndex), name.Get<uint32_t>(defs.FName.Number));
+}
+
+uint64_t LayoutHasher::HashObjectName(byte* object)
+{
+	return object ? HashName(object + defs.UObject.Name) : 0;
+}
+
+TypeKind LayoutHasher::GetKind(UE_UClass cls)
+{
+	auto [it, inserted] = types.try_emplace(cls, TypeKind::Other);
+	if (!inserted) { return it->second; }
+	// The most derived of the classes decides, e.g. a class is a struct as well
+	auto& classes = GetClasses();
+	std::pair<UE_UClass, TypeKind> bases[] =
+	{
+		{ classes.Class, TypeKind::Class },
+		{ classes.ScriptStruct, TypeKind::ScriptStruct },
+		{ classes.Function, TypeKind::Function },
+		{ classes.Struct, TypeKind::Struct },
+		{ classes.Enum, TypeKind::Enum },
+	};
+	for (auto depth = 0; cls && depth < 64; cls = cls.GetSuper().Cast<UE_UClass>(), depth++)
+	{
+		for (auto& [base, kind] : bases)
+		{
+			if (base && cls == base) { it->second = kind; return kind; }
+		}
+	}
+	return TypeKind::Other;
+}
+
+const LayoutHasher::Super& LayoutHasher::GetSuper(byte* object, int depth)
+{
+	if (auto it = supers.find(object); it != supers.end()) { return it->second; }
+	FieldWindow fields(object, objectWindow, ReadTag::Object);
+	Super super{ static_cast<uint32_t>(fields.Get<int32_t>(defs.UStruct.PropertiesSize)) };
+	Add(super.Chain, HashName(fields.Get<uint32_t>(defs.UObject.Name + defs.FName.ComparisonIndex), fields.Get<uint32_t>(defs.UObject.Name + defs.FName.Number)));
+	// Broken super chains can't recurse forever
+	auto next = fields.Get<byte*>(defs.UStruct.SuperStruct);
+	Add(super.Chain, next && depth < 64 ? GetSuper(next, depth + 1).Chain : 0);
+	return supers.emplace(object, super).first->second;
+}
+
+uint64_t LayoutHasher::HashReference(byte* object)
+{
+	if (!object) { return 0; }
+	auto [it, inserted] = references.try_emplace(object, 0);
+	if (!inserted) { return it->second; }
+	FieldWindow fields(object, objectWindow, ReadTag::Object);
+	uint64_t hash = 0;
+	Add(hash, HashName(fields.Get<uint32_t>(defs.UObject.Name + defs.FName.ComparisonIndex), fields.Get<uint32_t>(defs.UObject.Name + defs.FName.Number)));
+	Add(hash, HashObjectName(fields.Get<byte*>(defs.UObject.Outer)));
+	it->second = hash;
+	return hash;
+}
+
+byte* LayoutHasher::AddProperty(uint64_t& hash, byte* prop, int depth)
+{
+	// Broken inner properties can't recurse forever
+	if (!prop || depth > 8) { Add(hash, 0); return nullptr; }
+	FieldWindow fields(prop, propertyWindow, ReadTag::Property);
+	auto classAddress = fields.Get<byte*>(defs.FField.Class);
+	auto [it, inserted] = fieldClasses.try_emplace(classAddress);
+	if (inserted && classAddress)
+	{
+		it->second.Kind = static_cast<uint8_t>(GetPropertyKind(UE_FFieldClass(classAddress).GetName()));
+		it->second.Name = HashName(classAddress + defs.FFieldClass.Name);
+	}
+
+	Add(hash, fields.Get<uint64_t>(defs.FProperty.PropertyFlags));
+	Add(hash, it->second.Name);
+	Add(hash, HashName(fields.Get<uint32_t>(defs.FField.Name + defs.FName.ComparisonIndex), fields.Get<uint32_t>(defs.FField.Name + defs.FName.Number)));
+	Add(hash, fields.Get<uint32_t>(defs.FProperty.Offset));
+	Add(hash, fields.Get<uint32_t>(defs.FProperty.ElementSize));
+	Add(hash, fields.Get<uint32_t>(defs.FProperty.ArrayDim));
+
+	// Referenced structs, classes and enums are hashed by name, like they're rendered, and by package, like the reflection database references them
+	switch (static_cast<PropertyKind>(it->second.Kind))
+	{
+	case PropertyKind::Struct: { Add(hash, HashReference(fields.Get<byte*>(defs.FStructProperty.Struct))); break; }
+	case PropertyKind::Object: { Add(hash, HashReference(fields.Get<byte*>(defs.FObjectPropertyBase.PropertyClass))); break; }
+	case PropertyKind::Class: { Add(hash, HashReference(fields.Get<byte*>(defs.FClassProperty.MetaClass))); break; }
+	case PropertyKind::Enum: { Add(hash, HashReference(fields.Get<byte*>(defs.FEnumProperty.Enum))); break; }
+	case PropertyKind::Bool: { Add(hash, fields.Get<uint8_t>(defs.FBoolProperty.FieldMask)); break; }
+	case PropertyKind::Array: { AddProperty(hash, fields.Get<byte*>(defs.FArrayProperty.Inner), depth + 1); break; }
+	case PropertyKind::Set: { AddProperty(hash, fields.Get<byte*>(defs.FSetProperty.ElementProp), depth + 1); break; }
+	case PropertyKind::Map:
+	{
+		AddProperty(hash, fields.Get<byte*>(defs.FMapProperty.KeyProp), depth + 1);
+		AddProperty(hash, fields.Get<byte*>(defs.FMapProperty.ValueProp), depth + 1);
+		break;
+	}
+	case PropertyKind::Interface: { AddProperty(hash, fields.Get<byte*>(defs.FInterfaceProperty.InterfaceClass), depth + 1); break; }
+	case PropertyKind::Plain: { break; }
+	}
+	return fields.Get<byte*>(defs.FField.Next);
+}
+
+uint64_t LayoutHasher::HashStruct(byte* object, bool isClass)
+{
+	FieldWindow fields(object, objectWindow, ReadTag::Object);
+	uint64_t hash = 0;
+	Add(hash, isClass);
+	Add(hash, HashName(fields.Get<uint32_t>(defs.UObject.Name + defs.FName.ComparisonIndex), fields.Get<uint32_t>(defs.UObject.Name + defs.FName.Number)));
+	Add(hash, fields.Get<uint32_t>(defs.UStruct.PropertiesSize));
+
+	// Super chain decides the prefix of class names as well, so all of it is hashed, and the inherited size
+	auto superAddress = fields.Get<byte*>(defs.UStruct.SuperStruct);
+	auto super = superAddress ? GetSuper(superAddress, 0) : Super{};
+	Add(hash, super.Size);
+	Add(hash, super.Chain);
+
+	uint32_t count = 0;
+	for (auto prop = fields.Get<byte*>(defs.UStruct.ChildProperties); prop; prop = AddProperty(hash, prop, 0), count++);
+	Add(hash, count);
+
+	for (auto fn = fields.Get<byte*>(defs.UStruct.Children); fn; )
+	{
+		FieldWindow function(fn, functionWindow, ReadTag::Function);
+		fn = function.Get<byte*>(defs.UField.Next);
+		if (GetKind(function.Get<byte*>(defs.UObject.Class)) != TypeKind::Function) { continue; }
+		Add(hash, HashName(function.Get<uint32_t>(defs.UObject.Name + defs.FName.ComparisonIndex), function.Get<uint32_t>(defs.UObject.Name + defs.FName.Number)));
+		Add(hash, function.Get<uint32_t>(defs.UFunction.Flags));
+		Add(hash, function.Get<size_t>(defs.UFunction.FuncPtr) - moduleBase);
+		for (auto prop = function.Get<byte*>(defs.UStruct.ChildProperties); prop; prop = AddProperty(hash, prop, 0));
+	}
+	return hash;
+}
+uint64_t LayoutHasher::HashEnum(byte* object)
+{
+	FieldWindow fields(object, objectWindow, ReadTag::Enum);
+	uint64_t hash = 0;
+	Add(hash, HashName(fields.Get<uint32_t>(defs.UObject.Name + defs.FName.ComparisonIndex), fields.Get<uint32_t>(defs.UObject.Name + defs.FName.Number)));
+	auto names = fields.Get<TArray>(defs.UEnum.Names);
+	auto size = (defs.FName.Number + 4u + 8 + 7u) & ~(7u);
+	auto valueOffset = (defs.FName.Number + 4u + 7u) & ~(7u);
+	// Entries are read at once, and one by one if there are too many of them or they can't be read as a whole
+	std::vector<uint8_t> entries;
+	if (names.Count <= MaxEnumNames)
+	{
+		entries.resize(static_cast<size_t>(names.Count) * size);
+		if (!Read(names.Data, entries.data(), entries.size(), ReadTag::Enum)) { entries.clear(); }
+	}
+	for (auto i = 0ull; i < names.Count; i++)
+	{
+		auto entry = i * size;
+		Add(hash, HashName(GetEntry<uint32_t>(entries, names.Data, entry + defs.FName.ComparisonIndex), GetEntry<uint32_t>(entries, names.Data, entry + defs.FName.Number)));
+		Add(hash, GetEntry<uint64_t>(entries, names.Data, entry + valueOffset));
+	}
+	Add(hash, names.Count);
+	return hash;
+}
+
+std::optional<uint64_t> LayoutHasher::HashType(UE_UObject object, TypeKind kind)
+{
+	switch (kind)
+	{
+	case TypeKind::Class: { return HashStruct(object, true); }
+	case TypeKind::ScriptStruct: { return HashStruct(object, false); }
+	case TypeKind::Enum: { return HashEnum(object); }
+	default: { return std::nullopt; }
+	}
+}
+
+uint64_t LayoutHasher::HashPackage(std::vector<uint64_t> hashes)
+{
+	// Objects are enumerated in a different order by every run of the game, so their hashes are sorted
+	std::sort(hashes.begin(), hashes.end());
+	uint64_t hash = 0;
+	Add(hash, FingerprintVersion);
+	for (auto value : hashes) { Add(hash, value); }
+	Add(hash, hashes.size());
+	return hash;
+}
+
+bool LoadFingerprints(const fs::path& path, std::vector<PackageFingerprint>& fingerprints)
+{
+	FILE* raw = nullptr;
+	fopen_s(&raw, path.string().c_str(), "rb");
+	if (!raw) { return false; }
+	std::unique_ptr<FILE, decltype(&fclose)> file(raw, &fclose);
+
+	char magic[4];
+	uint32_t version = 0;
+	uint64_t count = 0;
+	if (fread(magic, sizeof(magic), 1, file.get()) != 1 || memcmp(magic, FingerprintMagic, sizeof(magic))) { return false; }
+	if (fread(&version, sizeof(version), 1, file.get()) != 1 || version != FingerprintVersion) { return false; }
+	if (fread(&count, sizeof(count), 1, file.get()) != 1 || count > (1u << 24)) { return false; }
+	std::vector<PackageFingerprint> loaded(count);
+	if (count && fread(loaded.data(), sizeof(PackageFingerprint), count, file.get()) != count) { return false; }
+	fingerprints = std::move(loaded);
+	return true;
+}
+
+WriteBuffer SerializeFingerprints(std::vector<PackageFingerprint>& fingerprints)
+{
+	auto less = [](const PackageFingerprint& a, const PackageFingerprint& b) { return a.Package < b.Package; };
+	std::sort(fingerprints.begin(), fingerprints.end(), less);
+	std::vector<PackageFingerprint> unique;
+	unique.reserve(fingerprints.size());
+	for (size_t i = 0, next; i < fingerprints.size(); i = next)
+	{
+		for (next = i + 1; next < fingerprints.size() && fingerprints[next].Package == fingerprints[i].Package; next++);
+		if (next == i + 1) { unique.push_back(fingerprints[i]); }
+	}
+
+	WriteBuffer buf;
+	uint64_t count = unique.size();
+	auto append = [&buf](const void* data, size_t size) { buf.append(static_cast<const char*>(data), static_cast<const char*>(data) + size); };
+	append(FingerprintMagic, sizeof(FingerprintMagic));
+	append(&FingerprintVersion, sizeof(FingerprintVersion));
+	append(&count, sizeof(count));
+	append(unique.data(), unique.size() * sizeof(PackageFingerprint));
+	return buf;
+}
+
+const PackageFingerprint* FindFingerprint(const std::vector<PackageFingerprint>& fingerprints, uint64_t package)
+{
+	auto it = std::lower_bound(fingerprints.begin(), fingerprints.end(), package, [](const PackageFingerprint& a, uint64_t b) { return a.Package < b; });
+	return it != fingerprints.end() && it->Package == package ? &*it : nullptr;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "wrappers.h"
+
+namespace fs = std::filesystem;
+
+// Kinds of objects by their class, only structs and enums are grouped into packages
+enum class TypeKind : uint8_t
+{
+	Other,
+	Class,
+	ScriptStruct,
+	Function,
+	Struct,
+	Enum
+};
+
+/*
+* Cheap hash of everything a package header and its reflection records are made from, so an unchanged package is neither generated nor written again.
+* Structs are hashed by name, super chain, size and their properties' names, classes, flags, offsets, sizes and referenced types,
+* functions by name, flags, address relative to the module and parameters, enums by their entry names and values.
+* Types are hashed while the objects are enumerated: fields of an object or a property are read at once, enum entries in one read,
+* and names, kinds of classes, supers and referenced types once per hasher. Names are hashed by string, so fingerprints stay comparable between runs of the game.
+*/
+class LayoutHasher
+{
+private:
+	struct Super
+	{
+		uint32_t Size = 0;
+		// Names of the struct and its supers
+		uint64_t Chain = 0;
+	};
+	struct FieldClass
+	{
+		uint8_t Kind = 0;
+		uint64_t Name = 0;
+	};
+	size_t moduleBase;
+	// Bytes read at once for structs and enums, for functions and for properties, up to their last field in 'defs'
+	uint16_t objectWindow;
+	uint16_t functionWindow;
+	uint16_t propertyWindow;
+	// Hashes of name strings by 'ComparisonIndex' and 'Number'
+	std::unordered_map<uint64_t, uint64_t> names;
+	std::unordered_map<byte*, TypeKind> types;
+	// Property classes, there are a few dozen of them
+	std::unordered_map<byte*, FieldClass> fieldClasses;
+	std::unordered_map<byte*, Super> supers;
+	// Names of referenced types with the names of their packages
+	std::unordered_map<byte*, uint64_t> references;
+	uint64_t HashName(uint32_t index, uint32_t number);
+	uint64_t HashName(byte* fname);
+	uint64_t HashObjectName(byte* object);
+	const Super& GetSuper(byte* object, int depth);
+	uint64_t HashReference(byte* object);
+	// Returns the next property of the list
+	byte* AddProperty(uint64_t& hash, byte* prop, int depth);
+	uint64_t HashStruct(byte* object, bool isClass);
+	uint64_t HashEnum(byte* object);
+public:
+	// Hashes names and classes of one game, one hasher per thread of a dump
+	LayoutHasher(size_t moduleBase);
+	// Kind of the objects of the class, each class is tested once
+	TypeKind GetKind(UE_UClass cls);
+	// Hash of a class, script struct or enum, nothing for other objects, functions are hashed with their classes
+	std::optional<uint64_t> HashType(UE_UObject object, TypeKind kind);
+	// Fingerprint of the package from the hashes of its types, independent of their order
+	static uint64_t HashPackage(std::vector<uint64_t> hashes);
+};
+
+// Fingerprint of a package as of the last dump, and the headers written for it
+struct PackageFingerprint
+{
+	// Hash of the package name that its headers are named after
+	uint64_t Package = 0;
+	uint64_t Fingerprint = 0;
+	// 'ClassesFile' and 'StructFile' bits, 0 if the package had nothing to save
+	uint32_t Files = 0;
+	uint32_t Reserved = 0;
+};
+
+constexpr uint32_t ClassesFile = 1;
+constexpr uint32_t StructFile = 2;
+
+/*
+* Fingerprints are stored in the dump directory as { char Magic[4]; uint32_t Version; uint64_t Count; PackageFingerprint[Count] }, sorted by package.
+* 'FingerprintVersion' is bumped whenever headers are rendered or hashed differently, so headers of an older dumper are generated again.
+*/
+constexpr uint32_t FingerprintVersion = 3;
+// Loads sorted fingerprints, fails if there are none or they were saved by another version
+bool LoadFingerprints(const fs::path& path, std::vector<PackageFingerprint>& fingerprints);
+// Sorts the fingerprints and serializes them, packages whose names collide are left out so they're always generated
+WriteBuffer SerializeFingerprints(std::vector<PackageFingerprint>& fingerprints);
+const PackageFingerprint* FindFingerprint(const std::vector<PackageFingerprint>& fingerprints, uint64_t package);
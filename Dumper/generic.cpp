@@ -1,16 +1,19 @@
 #include "wrappers.h"
 #include "memory.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 byte* FNamePool::GetEntry(FNameEntryHandle handle) const
 {
 	return reinterpret_cast<byte*>(Blocks[handle.Block] + defs.Stride * static_cast<uint64_t>(handle.Offset));
 }
 
-void FNamePool::DumpBlock(uint32_t blockId, uint32_t blockSize, std::function<void(std::string_view, uint32_t)> callback) const
+void FNamePool::DumpBlock(uint32_t blockId, uint32_t blockSize, std::function<void(std::string_view, uint32_t)> callback, uint32_t start) const
 {
-	byte* it = Blocks[blockId];
-	byte* end = it + blockSize - defs.FNameEntry.HeaderSize;
-	FNameEntryHandle entryHandle = { blockId, 0 };
+	byte* it = Blocks[blockId] + start;
+	byte* end = Blocks[blockId] + blockSize - defs.FNameEntry.HeaderSize;
+	FNameEntryHandle entryHandle = { blockId, start / defs.Stride };
 	while (it < end)
 	{
 		auto entry = UE_FNameEntry(it);
@@ -30,32 +33,63 @@ void FNamePool::DumpBlock(uint32_t blockId, uint32_t blockSize, std::function<vo
 
 void FNamePool::Dump(std::function<void(std::string_view, uint32_t)> callback) const
 {
-	for (auto i = 0u; i < CurrentBlock; i++) { DumpBlock(i, defs.Stride * 65536, callback); }
-	DumpBlock(CurrentBlock, CurrentByteCursor, callback);
+	DumpSince(0, 0, callback);
+}
+
+void FNamePool::DumpSince(uint32_t block, uint32_t cursor, std::function<void(std::string_view, uint32_t)> callback) const
+{
+	for (auto i = block; i <= CurrentBlock; i++)
+	{
+		uint32_t start = i == block ? cursor : 0;
+		uint32_t size = i == CurrentBlock ? CurrentByteCursor : defs.Stride * 65536;
+		if (start < size) { DumpBlock(i, size, callback, start); }
+	}
 }
 
 byte* TUObjectArray::GetObjectPtr(uint32_t id) const
 {
 	if (id >= NumElements) return nullptr;
-	uint64_t chunkIndex = id / 65536;
+	uint64_t chunkIndex = id / ObjectsPerChunk;
 	if (chunkIndex >= NumChunks) return nullptr;
-	byte* chunk = Read<byte*>(Objects + chunkIndex);
+	byte* chunk = Read<byte*>(Objects + chunkIndex, ReadTag::Object);
 	if (!chunk) return nullptr;
-	uint32_t withinChunkIndex = id % 65536 * defs.FUObjectItem.Size;
-	auto item = Read<byte*>(chunk + withinChunkIndex + defs.FUObjectItem.Object);
+	uint32_t withinChunkIndex = id % ObjectsPerChunk * defs.FUObjectItem.Size;
+	auto item = Read<byte*>(chunk + withinChunkIndex + defs.FUObjectItem.Object, ReadTag::Object);
 	return item;
 }
 
-void TUObjectArray::Dump(std::function<void(byte*)> callback) const
+void TUObjectArray::ForEach(const std::function<void(byte*, uint32_t)>& callback) const
 {
-	for (auto i = 0u; i < NumElements; i++)
+	std::vector<byte*> chunks(std::min(NumChunks, (NumElements + ObjectsPerChunk - 1) / ObjectsPerChunk));
+	bool table = chunks.size() && Read(Objects, chunks.data(), chunks.size() * sizeof(byte*), ReadTag::Object);
+	std::vector<uint8_t> items;
+	for (uint32_t chunk = 0; chunk < chunks.size(); chunk++)
 	{
-		byte* object = GetObjectPtr(i);
-		if (!object) { continue; }
-		callback(object);
+		auto first = chunk * ObjectsPerChunk;
+		auto count = std::min(ObjectsPerChunk, NumElements - first);
+		items.resize(static_cast<size_t>(count) * defs.FUObjectItem.Size);
+		if (table && chunks[chunk] && Read(chunks[chunk], items.data(), items.size(), ReadTag::Object))
+		{
+			for (uint32_t i = 0; i < count; i++)
+			{
+				byte* object;
+				memcpy(&object, items.data() + static_cast<size_t>(i) * defs.FUObjectItem.Size + defs.FUObjectItem.Object, sizeof(object));
+				if (object) { callback(object, first + i); }
+			}
+			continue;
+		}
+		for (uint32_t i = 0; i < count; i++)
+		{
+			if (auto object = GetObjectPtr(first + i)) { callback(object, first + i); }
+		}
 	}
 }
 
+void TUObjectArray::Dump(std::function<void(byte*)> callback) const
+{
+	ForEach([&callback](byte* object, uint32_t) { callback(object); });
+}
+
 UE_UClass TUObjectArray::FindObject(const std::string& name) const
 {
 	for (auto i = 0u; i < NumElements; i++)
@@ -66,5 +100,5 @@ UE_UClass TUObjectArray::FindObject(const std::string& name) const
 	return nullptr;
 }
 
-TUObjectArray ObjObjects;
-FNamePool NamePoolData;
\ No newline at end of file
+thread_local TUObjectArray ObjObjects;
+thread_local FNamePool NamePoolData;
\ No newline at end of file
@@ -1,8 +1,7 @@
 #pragma once
-#include "Engine.h"
-#include <windows.h>
+#include "engine.h"
+#include "platform.h"
 #include <functional>
-#undef GetObject
 
 struct TArray 
 {
@@ -20,6 +19,9 @@ struct FNameEntryHandle
 	operator uint32_t() const { return (Block << 16 | Offset); }
 };
 
+// First hardcoded names of every engine build, in the order they're added to the pool
+inline constexpr const char* HardcodedNames[] = { "None", "ByteProperty", "IntProperty", "BoolProperty", "FloatProperty", "ObjectProperty" };
+
 struct FNamePool 
 {
 	byte Lock[8];
@@ -27,8 +29,11 @@ struct FNamePool
 	uint32_t CurrentByteCursor;
 	byte* Blocks[8192];
 	byte* GetEntry(FNameEntryHandle handle) const;
-	void DumpBlock(uint32_t blockId, uint32_t blockSize, std::function<void(std::string_view, uint32_t)> callback) const;
+	// Dumps entries of the block that start at 'start' bytes or later and end before 'blockSize'
+	void DumpBlock(uint32_t blockId, uint32_t blockSize, std::function<void(std::string_view, uint32_t)> callback, uint32_t start = 0) const;
 	void Dump(std::function<void(std::string_view, uint32_t)> callback) const;
+	// Dumps entries that were added after the pool was at 'block' and 'cursor', e.g. since the previous dump
+	void DumpSince(uint32_t block, uint32_t cursor, std::function<void(std::string_view, uint32_t)> callback) const;
 };
 
 struct TUObjectArray
@@ -40,10 +45,15 @@ struct TUObjectArray
 	uint32_t MaxChunks;
 	uint32_t NumChunks;
 
+	// Slots are allocated in chunks of this many items
+	static constexpr uint32_t ObjectsPerChunk = 65536;
+
 	byte* GetObjectPtr(uint32_t id) const;
+	// Calls back with every object and its slot, each chunk is read at once and slot by slot only if that fails
+	void ForEach(const std::function<void(byte*, uint32_t)>& callback) const;
 	void Dump(std::function<void(byte*)> callback) const;
 	class UE_UClass FindObject(const std::string& name) const;
 };
 
-extern TUObjectArray ObjObjects;
-extern FNamePool NamePoolData;
\ No newline at end of file
+extern thread_local TUObjectArray ObjObjects;
+extern thread_local FNamePool NamePoolData;
\ No newline at end of file
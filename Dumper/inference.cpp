@@ -0,0 +1,434 @@
+#include "inference.h"
+#include "wrappers.h"
+#include "memory.h"
+#include "utils.h"
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef DUMPER_PROFILE
+
+// Offsets are compiled in
+bool InferOffsets(byte* moduleBase, uint32_t moduleSize)
+{
+	return false;
+}
+
+#else
+
+// Objects that confirm offsets of UObject, the first ones are loaded early and are the most reliable
+static constexpr uint32_t ObjectSamples = 256;
+// Functions that confirm offsets of UFunction
+static constexpr size_t FunctionSamples = 64;
+// Enums that confirm offsets of UEnum
+static constexpr size_t EnumSamples = 8;
+// Start of an object that holds every member of UObject, samples are read once and probed in memory
+static constexpr size_t HeaderWindow = 0x50;
+
+// Objects that exist in every build, offsets of reflection types are derived from their known relations
+static const char* const AnchorNames[] =
+{
+	"Class CoreUObject.Object",
+	"Class CoreUObject.Field",
+	"Class CoreUObject.Struct",
+	"ScriptStruct CoreUObject.Vector",
+	"ScriptStruct CoreUObject.Quat",
+	"ScriptStruct CoreUObject.Transform",
+};
+
+struct Anchors
+{
+	std::unordered_map<std::string, byte*> Objects;
+	std::vector<byte*> Functions;
+	std::vector<byte*> Enums;
+};
+
+// Start of a sample object, fields out of the window or of a header that can't be read are read one by one
+struct Header
+{
+	// Zeroed before it's read into
+	uint8_t Data[HeaderWindow]{};
+	byte* Object;
+	bool Valid;
+
+	Header(byte* object) : Object(object), Valid(Read(object, Data, sizeof(Data))) {}
+
+	template<typename T>
+	T Get(uint16_t offset) const
+	{
+		if (!Valid || offset + sizeof(T) > sizeof(Data)) { return Read<T>(Object + offset); }
+		T value;
+		memcpy(&value, Data + offset, sizeof(T));
+		return value;
+	}
+};
+
+// Headers of the objects sampled so far, by address
+using Headers = std::unordered_map<byte*, Header>;
+
+// Gets the header of the object, it's read on the first use
+static const Header& GetHeader(Headers& headers, byte* object)
+{
+	return headers.try_emplace(object, object).first->second;
+}
+
+// Gets the first offset in [begin, end) with 'step' that is accepted, -1 if there's none
+template<typename Fn>
+static int32_t Probe(uint32_t begin, uint32_t end, uint32_t step, Fn accept)
+{
+	for (auto offset = begin; offset < end; offset += step) { if (accept(static_cast<uint16_t>(offset))) { return offset; } }
+	return -1;
+}
+
+// Decodes name without number, ids that point out of allocated blocks give an empty string
+static std::string RawName(uint32_t id)
+{
+	if ((id >> 16) > NamePoolData.CurrentBlock) { return {}; }
+	auto entry = UE_FNameEntry(NamePoolData.GetEntry(id));
+	auto [wide, len] = entry.Info();
+	if (!len || len >= 1024) { return {}; }
+	return entry.String(wide, len);
+}
+
+static bool MatchesHardcodedNames(byte* block)
+{
+	uint32_t offset = 0;
+	for (auto name : HardcodedNames)
+	{
+		auto entry = UE_FNameEntry(block + offset);
+		auto [wide, len] = entry.Info();
+		if (wide || len != strlen(name) || entry.String(wide, len) != name) { return false; }
+		offset += UE_FNameEntry::Size(wide, len);
+	}
+	return true;
+}
+
+// Name pool starts with "None", the header before it holds length of the string
+static bool InferNameEntry()
+{
+	byte* block = NamePoolData.Blocks[0];
+	char head[32]{};
+	if (!Read(block, head, sizeof(head))) { return false; }
+	auto none = std::string_view(head, sizeof(head)).find("None");
+	if (none == std::string_view::npos || !none || none > 16) { return false; }
+
+	auto header = static_cast<uint16_t>(none);
+	defs.FNameEntry.HeaderSize = header;
+	defs.FNameEntry.WideBitOffset = 0;
+	for (uint16_t info = 0; info + 2 <= header; info += 2)
+	{
+		for (uint16_t len = 1; len < 16; len++)
+		{
+			for (uint16_t stride : { 2, 4, 8 })
+			{
+				defs.FNameEntry.InfoOffset = info;
+				defs.FNameEntry.LenBitOffset = len;
+				defs.Stride = stride;
+				if (MatchesHardcodedNames(block)) { return true; }
+			}
+		}
+	}
+	return false;
+}
+
+// Objects store their own index, items of a wrong size give pointers that don't
+static bool InferObjectItem(std::vector<byte*>& objects, Headers& headers)
+{
+	defs.FUObjectItem.Object = 0;
+	auto count = ObjObjects.NumElements < ObjectSamples ? ObjObjects.NumElements : ObjectSamples;
+	for (uint16_t size : { 16, 24, 32 })
+	{
+		defs.FUObjectItem.Size = size;
+		objects.clear();
+		for (uint32_t id = 0; id < count; id++) { objects.push_back(ObjObjects.GetObjectPtr(id)); }
+		// Index 0 matches zeroed memory as well
+		std::vector<std::pair<uint32_t, const Header*>> samples;
+		for (uint32_t id = 1; id < count; id++) { if (IsPointer(objects[id])) { samples.emplace_back(id, &GetHeader(headers, objects[id])); } }
+		uint32_t total = static_cast<uint32_t>(samples.size());
+		auto index = Probe(0x4, 0x40, 4, [&](uint16_t offset)
+		{
+			uint32_t matched = 0;
+			for (auto [id, header] : samples) { if (header->Get<uint32_t>(offset) == id) { matched++; } }
+			return total * 2 >= count && matched * 10 >= total * 9;
+		});
+		if (index < 0) { continue; }
+		defs.UObject.Index = static_cast<uint16_t>(index);
+		std::erase_if(objects, [](byte* object) { return !IsPointer(object); });
+		return true;
+	}
+	return false;
+}
+
+// Class of every object ends up at 'Class', which is its own class
+static byte* InferObjectClass(const std::vector<byte*>& objects, Headers& headers)
+{
+	byte* meta = nullptr;
+	auto offset = Probe(0x8, 0x40, 8, [&](uint16_t offset)
+	{
+		if (offset == (defs.UObject.Index & ~7)) { return false; }
+		size_t matched = 0;
+		for (auto object : objects)
+		{
+			byte* current = object;
+			for (auto i = 0; i < 4; i++)
+			{
+				auto next = GetHeader(headers, current).Get<byte*>(offset);
+				if (!IsPointer(next)) { break; }
+				if (next == current) { meta = next; matched++; break; }
+				current = next;
+			}
+		}
+		return matched * 10 >= objects.size() * 9;
+	});
+	if (offset < 0) { return nullptr; }
+	defs.UObject.Class = static_cast<uint16_t>(offset);
+	return meta;
+}
+
+static bool InferObjectName(const std::vector<byte*>& objects, byte* meta, Headers& headers)
+{
+	auto name = Probe(0x8, 0x40, 4, [&](uint16_t offset)
+	{
+		if (offset == defs.UObject.Index || offset == defs.UObject.Class || offset == defs.UObject.Class + 4) { return false; }
+		return RawName(GetHeader(headers, meta).Get<uint32_t>(offset)) == "Class";
+	});
+	if (name < 0) { return false; }
+	defs.UObject.Name = static_cast<uint16_t>(name);
+	defs.FName.ComparisonIndex = 0;
+
+	// Most objects have no number, case preserving builds keep display index before it
+	for (uint16_t number : { 4, 8 })
+	{
+		size_t zeros = 0;
+		for (auto object : objects) { if (!GetHeader(headers, object).Get<uint32_t>(name + number)) { zeros++; } }
+		if (zeros * 10 >= objects.size() * 9) { defs.FName.Number = number; break; }
+	}
+	if (!defs.FName.Number) { return false; }
+
+	// 'Class' lives in the CoreUObject package, that has no outer
+	uint16_t end = (name + defs.FName.Number + 4 + 7) & ~7;
+	auto outer = Probe(end, 0x48, 8, [&](uint16_t offset)
+	{
+		auto package = GetHeader(headers, meta).Get<byte*>(offset);
+		if (!IsPointer(package)) { return false; }
+		auto& header = GetHeader(headers, package);
+		return RawName(header.Get<uint32_t>(name)) == "/Script/CoreUObject" && !header.Get<byte*>(offset);
+	});
+	if (outer < 0) { return false; }
+	defs.UObject.Outer = static_cast<uint16_t>(outer);
+	defs.UField.Next = defs.UObject.Outer + 8;
+	return true;
+}
+
+static bool FindAnchors(Anchors& anchors)
+{
+	for (auto i = 0u; i < ObjObjects.NumElements; i++)
+	{
+		UE_UObject object = ObjObjects.GetObjectPtr(i);
+		if (!object) { continue; }
+		auto name = object.GetFullName();
+		auto type = std::string_view(name).substr(0, name.find(' '));
+		if (type == "Function" && anchors.Functions.size() < FunctionSamples) { anchors.Functions.push_back(object); }
+		else if (type == "Enum" && anchors.Enums.size() < EnumSamples) { anchors.Enums.push_back(object); }
+		for (auto anchor : AnchorNames) { if (name == anchor) { anchors.Objects[anchor] = object; } }
+		if (anchors.Objects.size() == std::size(AnchorNames) && anchors.Functions.size() == FunctionSamples && anchors.Enums.size() == EnumSamples) { break; }
+	}
+	return anchors.Objects.size() == std::size(AnchorNames) && anchors.Functions.size() && anchors.Enums.size();
+}
+
+static byte* FindField(byte* first, const char* name)
+{
+	auto field = first;
+	for (auto i = 0; i < 64 && IsPointer(field); i++, field = Read<byte*>(field + defs.FField.Next))
+	{
+		if (RawName(Read<uint32_t>(field + defs.FField.Name)) == name) { return field; }
+	}
+	return nullptr;
+}
+
+static bool InferStruct(Anchors& anchors)
+{
+	auto object = anchors.Objects["Class CoreUObject.Object"];
+	auto field = anchors.Objects["Class CoreUObject.Field"];
+	auto structure = anchors.Objects["Class CoreUObject.Struct"];
+	auto vector = anchors.Objects["ScriptStruct CoreUObject.Vector"];
+
+	// Struct derives from Field, that derives from Object
+	auto super = Probe(defs.UField.Next + 8, 0x80, 8, [&](uint16_t offset)
+	{
+		return Read<byte*>(structure + offset) == field && Read<byte*>(field + offset) == object;
+	});
+	if (super < 0) { return false; }
+	defs.UStruct.SuperStruct = static_cast<uint16_t>(super);
+
+	// Object and Field have no properties, their sizes are known from the layout
+	auto size = Probe(super + 8, 0x80, 4, [&](uint16_t offset)
+	{
+		return Read<int32_t>(object + offset) == defs.UField.Next && Read<int32_t>(field + offset) == defs.UField.Next + 8;
+	});
+	if (size < 0) { return false; }
+	defs.UStruct.PropertiesSize = static_cast<uint16_t>(size);
+
+	// Object declares native functions
+	auto children = Probe(super + 8, size, 8, [&](uint16_t offset)
+	{
+		auto child = Read<byte*>(object + offset);
+		if (!IsPointer(child) || Read<byte*>(child + defs.UObject.Outer) != object) { return false; }
+		auto cls = Read<byte*>(child + defs.UObject.Class);
+		return IsPointer(cls) && RawName(Read<uint32_t>(cls + defs.UObject.Name)) == "Function";
+	});
+	if (children < 0) { return false; }
+	defs.UStruct.Children = static_cast<uint16_t>(children);
+
+	// Vector has X, Y and Z, property names are found together with the pointer to the first one
+	byte* x = nullptr;
+	auto properties = Probe(super + 8, size, 8, [&](uint16_t offset)
+	{
+		if (offset == children) { return false; }
+		x = Read<byte*>(vector + offset);
+		if (!IsPointer(x)) { return false; }
+		auto name = Probe(0x8, 0x40, 8, [&](uint16_t name) { return RawName(Read<uint32_t>(x + name)) == "X"; });
+		if (name < 0) { return false; }
+		defs.FField.Name = static_cast<uint16_t>(name);
+		return true;
+	});
+	if (properties < 0) { return false; }
+	defs.UStruct.ChildProperties = static_cast<uint16_t>(properties);
+	return true;
+}
+
+static bool InferField(Anchors& anchors)
+{
+	auto x = Read<byte*>(anchors.Objects["ScriptStruct CoreUObject.Vector"] + defs.UStruct.ChildProperties);
+	auto next = Probe(0x8, 0x40, 8, [&](uint16_t offset)
+	{
+		if (offset == defs.FField.Name) { return false; }
+		auto y = Read<byte*>(x + offset);
+		return IsPointer(y) && RawName(Read<uint32_t>(y + defs.FField.Name)) == "Y";
+	});
+	if (next < 0) { return false; }
+	defs.FField.Next = static_cast<uint16_t>(next);
+
+	// Name of the field class is its first member
+	defs.FFieldClass.Name = 0;
+	auto cls = Probe(0x8, 0x40, 8, [&](uint16_t offset)
+	{
+		auto fieldClass = Read<byte*>(x + offset);
+		if (!IsPointer(fieldClass)) { return false; }
+		auto name = RawName(Read<uint32_t>(fieldClass + defs.FFieldClass.Name));
+		return name == "FloatProperty" || name == "DoubleProperty";
+	});
+	if (cls < 0) { return false; }
+	defs.FField.Class = static_cast<uint16_t>(cls);
+
+	// X, Y and Z are single floats or doubles laid out one after another
+	auto y = Read<byte*>(x + next), z = Read<byte*>(y + next);
+	int32_t element = 0;
+	auto dim = Probe(defs.FField.Name + 8, 0x80, 4, [&](uint16_t offset)
+	{
+		element = Read<int32_t>(x + offset + 4);
+		if (element != 4 && element != 8) { return false; }
+		for (auto property : { x, y, z }) { if (Read<int32_t>(property + offset) != 1 || Read<int32_t>(property + offset + 4) != element) { return false; } }
+		return true;
+	});
+	if (dim < 0) { return false; }
+	defs.FProperty.ArrayDim = static_cast<uint16_t>(dim);
+	defs.FProperty.ElementSize = static_cast<uint16_t>(dim + 4);
+	defs.FProperty.PropertyFlags = static_cast<uint16_t>(dim + 8);
+
+	auto offset = Probe(dim + 16, 0x80, 4, [&](uint16_t offset)
+	{
+		return Read<int32_t>(x + offset) == 0 && Read<int32_t>(y + offset) == element && Read<int32_t>(z + offset) == element * 2;
+	});
+	if (offset < 0) { return false; }
+	defs.FProperty.Offset = static_cast<uint16_t>(offset);
+
+	// Members of property subclasses start right after FProperty, rotation of transform points to quat
+	auto rotation = FindField(Read<byte*>(anchors.Objects["ScriptStruct CoreUObject.Transform"] + defs.UStruct.ChildProperties), "Rotation");
+	if (!rotation) { return false; }
+	auto quat = anchors.Objects["ScriptStruct CoreUObject.Quat"];
+	auto base = Probe((offset + 4 + 7) & ~7, 0xA0, 8, [&](uint16_t offset) { return Read<byte*>(rotation + offset) == quat; });
+	if (base < 0) { return false; }
+	uint16_t first = static_cast<uint16_t>(base), second = static_cast<uint16_t>(base + 8);
+	defs.FStructProperty.Struct = first;
+	defs.FObjectPropertyBase.PropertyClass = first;
+	defs.FClassProperty.MetaClass = second;
+	defs.FArrayProperty.Inner = first;
+	defs.FEnumProperty.Enum = second;
+	defs.FSetProperty.ElementProp = first;
+	defs.FMapProperty.KeyProp = first;
+	defs.FMapProperty.ValueProp = second;
+	defs.FInterfaceProperty.InterfaceClass = first;
+	defs.FBoolProperty.FieldSize = first;
+	defs.FBoolProperty.ByteOffset = first + 1;
+	defs.FBoolProperty.ByteMask = first + 2;
+	defs.FBoolProperty.FieldMask = first + 3;
+	return true;
+}
+
+// Enum names are pairs of name and value, the first value is 0 almost always
+static bool InferEnum(Anchors& anchors)
+{
+	auto names = Probe(defs.UField.Next + 8, 0x80, 8, [&](uint16_t offset)
+	{
+		size_t matched = 0;
+		for (auto object : anchors.Enums)
+		{
+			auto names = Read<TArray>(object + offset);
+			if (!IsPointer(names.Data) || !names.Count || names.Count > names.Max || names.Count > 4096) { continue; }
+			if (Read<int64_t>(names.Data + 8) || RawName(Read<uint32_t>(names.Data)).empty()) { continue; }
+			matched++;
+		}
+		return matched * 2 > anchors.Enums.size();
+	});
+	if (names < 0) { return false; }
+	defs.UEnum.Names = static_cast<uint16_t>(names);
+	return true;
+}
+
+// Every function has an access specifier and a pointer to native code or the script interpreter
+static bool InferFunction(Anchors& anchors, byte* moduleBase, uint32_t moduleSize)
+{
+	auto access = static_cast<uint32_t>(UEFunctionFlags::Public) | static_cast<uint32_t>(UEFunctionFlags::Private) | static_cast<uint32_t>(UEFunctionFlags::Protected);
+	auto flags = Probe(defs.UStruct.PropertiesSize + 4, 0x100, 4, [&](uint16_t offset)
+	{
+		size_t matched = 0;
+		for (auto function : anchors.Functions) { if (Read<uint32_t>(function + offset) & access) { matched++; } }
+		return matched * 10 >= anchors.Functions.size() * 9;
+	});
+	if (flags < 0) { return false; }
+	defs.UFunction.Flags = static_cast<uint16_t>(flags);
+
+	auto ptr = Probe((flags + 4 + 7) & ~7, 0x120, 8, [&](uint16_t offset)
+	{
+		size_t matched = 0;
+		for (auto function : anchors.Functions)
+		{
+			auto code = Read<byte*>(function + offset);
+			if (code >= moduleBase && code < moduleBase + moduleSize) { matched++; }
+		}
+		return matched * 10 >= anchors.Functions.size() * 9;
+	});
+	if (ptr < 0) { return false; }
+	defs.UFunction.FuncPtr = static_cast<uint16_t>(ptr);
+	return true;
+}
+
+bool InferOffsets(byte* moduleBase, uint32_t moduleSize)
+{
+	defs = Offsets{};
+	if (!InferNameEntry()) { return false; }
+
+	std::vector<byte*> objects;
+	Headers headers;
+	if (!InferObjectItem(objects, headers) || objects.empty()) { return false; }
+	auto meta = InferObjectClass(objects, headers);
+	if (!meta || !InferObjectName(objects, meta, headers)) { return false; }
+
+	Anchors anchors;
+	if (!FindAnchors(anchors)) { return false; }
+	return InferStruct(anchors) && InferField(anchors) && InferEnum(anchors) && InferFunction(anchors, moduleBase, moduleSize);
+}
+
+#endif
@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+#include "platform.h"
+
+/*
+* Infers 'defs' for games without a hand-written profile.
+* ObjObjects and NamePoolData have to be read already, every offset is derived from known engine objects:
+* hardcoded names at the start of the name pool, the 'Class' class that is its own class, CoreUObject classes and structs.
+* Returns false if any offset can't be confirmed, 'defs' is left partially filled in that case.
+*/
+bool InferOffsets(byte* moduleBase, uint32_t moduleSize);
@@ -1,242 +1,167 @@
 #include <fmt/core.h>
-#include "utils.h"
-#include "wrappers.h"
+#include "dumper.h"
+#include "archive.h"
 #include "memory.h"
+#include "trace.h"
+#include "daemon.h"
+#include "batch.h"
+#include "database.h"
+#include "diff.h"
+#include <chrono>
 
 namespace fs = std::filesystem;
 
-enum {
-    SUCCESS,
-    FAILED,
-    WINDOW_NOT_FOUND,
-    PROCESS_NOT_FOUND,
-    READER_ERROR,
-    CANNOT_GET_PROCNAME,
-    ENGINE_ERROR,
-    MODULE_NOT_FOUND,
-    CANNOT_READ,
-    INVALID_IMAGE,
-    NAMES_NOT_FOUND,
-    OBJECTS_NOT_FOUND,
-    FILE_NOT_OPEN,
-    ZERO_PACKAGES
-};
-
-class Dumper
+int main(int argc, char* argv[])
 {
-protected:
-    bool Full = true;
-    bool Wait = false;
-    fs::path Directory;
-    size_t ModuleBase = 0;
-private:
-    Dumper() {};
-    static bool FindObjObjects(byte* start, byte* end) 
+    bool full = true;
+    bool wait = false;
+    bool archive = false;
+    bool amalgamate = false;
+    bool stats = false;
+    bool incremental = false;
+    fs::path extract;
+    fs::path trace;
+    std::string daemon;
+    fs::path batch;
+    fs::path diffOld, diffNew;
+    uint32_t threads = 0;
+
+    for (auto i = 1; i < argc; i++)
     {
-        static std::vector<byte> sigv[] = { {0x48, 0x8B, 0x05, 0x00, 0x00, 0x00, 0x00, 0x48, 0x8B, 0x0C, 0xC8, 0x48, 0x8D, 0x04, 0xD1, 0xEB}, {0x48 , 0x8b , 0x0d , 0x00 , 0x00 , 0x00 , 0x00 , 0x81 , 0x4c , 0xd1 , 0x08 , 0x00 , 0x00 , 0x00 , 0x40}, {0x48, 0x8d, 0x1d, 0x00, 0x00, 0x00, 0x00, 0x39, 0x44, 0x24, 0x68} };
-        for (auto& sig : sigv)
-        {
-            auto address = FindPointer(start, end, sig.data(), sig.size());
-            if (!address) continue;
-            ObjObjects = *reinterpret_cast<decltype(ObjObjects)*>(address);
-            return true;
-        }
-        return false;
+        auto arg = argv[i];
+        if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) { printf("'-p' - dump only names and objects\n'-w' - wait for input (it gives me time to inject mods)\n'-a' - store SDK in single 'DUMP.sdk' archive\n'-s' - write amalgamated 'SDK.hpp'\n'-i' - generate only packages that changed since the last dump, ignored with '-a' and '-s'\n'-x <archive>' - extract archive next to it\n'--diff <old> <new>' - compare layouts of two dumps, paths of their 'Reflection.bin' or directories\n'--stats' - print count, size and latency of memory reads\n'--trace <file>' - write timeline of the dump as Chrome trace JSON\n'--daemon [pipe]' - stay attached and answer queries on the pipe instead of dumping, see protocol.h\n'--batch <file>' - dump every process or snapshot of the list concurrently, see batch.h\n'--threads <n>' - threads of the dump or of the whole batch"); return FAILED; }
+        else if (!strcmp(arg, "-p")) { full = false; }
+        else if (!strcmp(arg, "-w")) { wait = true; }
+        else if (!strcmp(arg, "-a")) { archive = true; }
+        else if (!strcmp(arg, "-s")) { amalgamate = true; }
+        else if (!strcmp(arg, "-i")) { incremental = true; }
+        else if (!strcmp(arg, "-x") && i + 1 < argc) { extract = argv[++i]; }
+        else if (!strcmp(arg, "-x")) { puts("'-x' needs the path of an archive"); return FAILED; }
+        else if (!strcmp(arg, "--diff") && i + 2 < argc) { diffOld = argv[++i]; diffNew = argv[++i]; }
+        else if (!strcmp(arg, "--stats")) { stats = true; }
+        else if (!strcmp(arg, "--trace") && i + 1 < argc) { trace = argv[++i]; }
+        else if (!strcmp(arg, "--batch") && i + 1 < argc) { batch = argv[++i]; }
+        else if (!strcmp(arg, "--threads") && i + 1 < argc) { threads = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10)); }
+        else if (!strcmp(arg, "--daemon")) { daemon = i + 1 < argc && argv[i + 1][0] != '-' ? argv[++i] : GetDefaultQueryName(); }
     }
-    static bool FindNamePoolData(byte* start, byte* end) 
+
+    // Reads are always counted, timing them is only worth it when they're printed
+    if (stats) { EnableReadTiming(true); }
+    if (!trace.empty())
     {
-        static std::vector<byte> sigv[] = { { 0x48, 0x8d, 0x35, 0x00, 0x00, 0x00, 0x00, 0xeb, 0x16 } };
-        for (auto& sig : sigv)
-        {
-            auto address = FindPointer(start, end, sig.data(), sig.size());
-            if (!address) continue;
-            NamePoolData = *reinterpret_cast<decltype(NamePoolData)*>(address);
-            return true;
-        }
-        return false;
+        EnableTrace();
+        TraceThread("Main");
     }
-public:
-    static Dumper* GetInstance() 
+
+    if (!extract.empty())
     {
-        static Dumper dumper;
-        return &dumper;
+        auto dir = extract.parent_path() / extract.stem();
+        if (!ExtractArchive(extract, dir)) { puts(GetStatusMessage(ARCHIVE_ERROR)); return FAILED; }
+        printf("Extracted to %s\n", dir.string().c_str());
+        return SUCCESS;
     }
-    int Init(int argc, char* argv[]) 
-    {
 
-        for (auto i = 1; i < argc; i++)
+    if (!diffOld.empty())
+    {
+        ReflectionDatabase old, current;
+        auto load = [](ReflectionDatabase& database, fs::path path)
         {
-            auto arg = argv[i];
-            if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) { printf("'-p' - dump only names and objects\n'-w' - wait for input (it gives me time to inject mods)"); return FAILED; }
-            else if (!strcmp(arg, "-p")) { Full = false; }
-            else if (!strcmp(arg, "-w")) { Wait = true; }
-        }
-
-        if (Wait) { system("pause"); }
-
-        uint32_t pid = 0;
-
+            if (fs::is_directory(path)) { path /= "Reflection.bin"; }
+            if (database.Load(path)) { return true; }
+            printf("Can't read reflection database %s\n", path.string().c_str());
+            return false;
+        };
+        if (!load(old, diffOld) || !load(current, diffNew)) { return FAILED; }
+
+        auto begin = std::chrono::steady_clock::now();
+        LayoutDiff diff;
+        DiffLayouts(old.View(), current.View(), diff);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+        WriteBuffer report;
+        PrintDiff(old.View(), current.View(), diff, report);
+        fwrite(report.data(), 1, report.size(), stdout);
+
+        size_t counts[4]{};
+        for (auto& s : diff.Structs)
         {
-            HWND hWnd = FindWindowA("UnrealWindow", nullptr);
-            if (!hWnd) { return WINDOW_NOT_FOUND; };
-            GetWindowThreadProcessId(hWnd, reinterpret_cast<DWORD*>(&pid));
-            if (!pid) { return PROCESS_NOT_FOUND; };
+            for (auto bit = 0; bit < 4; bit++) { if (s.Changes & (1 << bit)) { counts[bit]++; } }
         }
-        
-        if (!ReaderInit(pid)) { return READER_ERROR; };
+        fmt::print("{} structs compared in {:.1f} ms: {} added, {} removed, {} resized, {} changed super, {} member changes\n",
+            diff.Compared, elapsed.count(), counts[0], counts[1], counts[2], counts[3], diff.Members.size());
+        return SUCCESS;
+    }
 
-        fs::path processName;
+    if (wait) { system("pause"); }
 
-        {
-            wchar_t processPath[MAX_PATH]{};
-            if (!GetProccessPath(pid, processPath, MAX_PATH)) { return CANNOT_GET_PROCNAME; };
-            processName = fs::path(processPath).filename();
-            printf("Found UE4 game: %ls\n", processName.c_str());
-        }
+    // Offsets are cached and files are written next to the executable, in 'Games/<game>'
+    auto root = fs::path(argv[0]); root.remove_filename();
+    root /= "Games";
+    auto log = [](const std::string& text) { fputs(text.c_str(), stdout); };
 
+    if (!batch.empty())
+    {
+        std::vector<BatchTarget> targets;
+        if (!LoadBatch(batch, targets)) { printf("Can't read batch %s\n", batch.string().c_str()); return FAILED; }
+        auto budget = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+        auto results = RunBatch(targets, root, budget, full ? Dumper::All : Dumper::Names | Dumper::Objects, incremental, log);
+        int failed = 0;
+        for (auto& result : results)
         {
-            auto root = fs::path(argv[0]); root.remove_filename();
-            auto game = processName.stem();
-            Directory = root / "Games" / game;
-            fs::create_directories(Directory);
-            if (!EngineInit(game.string())) { return ENGINE_ERROR; };
+            fmt::print("{:<32} {:>8.2f} s  {}\n", result.Name, result.Seconds, GetStatusMessage(result.Status));
+            if (result.Status != SUCCESS) { failed++; }
         }
+        if (stats) { PrintReadStats(GetReadStats()); }
+        if (!trace.empty() && !WriteTrace(trace)) { fmt::print("Can't write: {}\n", trace.string()); }
+        fmt::print("Dumped {} of {} targets\n", results.size() - failed, results.size());
+        return failed ? FAILED : SUCCESS;
+    }
 
-        {
-            auto [base, size] = GetModuleInfo(pid, processName);
-            if (!(base && size)) { return MODULE_NOT_FOUND; }
-
-            std::vector<byte> image(size);
-            if (!Read(base, image.data(), size)) { return CANNOT_READ; }
-            auto sections = GetExSections(image.data());
-            if (!sections.size()) { return INVALID_IMAGE; }
+    auto pid = FindGameWindow("UnrealWindow");
+    if (!pid) { puts(GetStatusMessage(WINDOW_NOT_FOUND)); return FAILED; }
 
-            ModuleBase = (size_t)base;
+    Dumper dumper;
+    dumper.SetLog(log);
+    dumper.SetThreads(threads);
+    dumper.SetIncremental(incremental);
+    auto status = dumper.Open(pid, root);
+    if (status != SUCCESS) { puts(GetStatusMessage(status)); return FAILED; }
+    auto directory = root / dumper.GetGame();
 
-            bool err = false;
-            for (auto& section : sections) { if (FindObjObjects(section.first, section.second)) { err = true; break; }; }
-            if (!err) { return OBJECTS_NOT_FOUND; };
-            for (auto& section : sections) { if (FindNamePoolData(section.first, section.second)) { err = true; break; }; }
-            if (!err) { return NAMES_NOT_FOUND; };
-        }
-        
+    // Daemon keeps the globals and the index warm, so tools get answers without a dump or a rescan
+    if (!daemon.empty())
+    {
+        QueryIndex index(dumper.GetObjectsAddress(), dumper.GetNamesAddress());
+        fmt::print("Indexed {} names and {} objects, serving queries on {}\n", index.GetNameCount(), index.GetObjectCount(), daemon);
+        QueryServer server(index, daemon);
+        if (!server.Run()) { fmt::print("Can't serve on {}\n", daemon); return FAILED; }
         return SUCCESS;
     }
-    int Dump() 
+
+    // All files are written by one thread, directories are created before anything is queued
+    Writer writer;
+    Writer::Prepare(directory);
+    if (full)
     {
-        /*
-        * Names dumping.
-        * We go through each block, except last, that is not fully filled.
-        * In each block we calculate next entry depending on previous entry size.
-        */
-        {
-            File file(Directory / "NamesDump.txt", "w");
-            if (!file) { return FILE_NOT_OPEN; }
-            size_t size = 0;
-            NamePoolData.Dump([&file, &size](std::string_view name, uint32_t id) { fmt::print(file, "[{:0>6}] {}\n", id, name); size++; });
-            fmt::print("Names: {}\n", size);
-        }
-        {
-            // Why we need to iterate all objects twice? We dumping objects and filling packages simultaneously.
-            std::unordered_map<byte*, std::vector<UE_UObject>> packages;
-            {
-                File file(Directory / "ObjectsDump.txt", "w");
-                if (!file) { return FILE_NOT_OPEN; }
-                size_t size = 0;
-                if (Full)
-                {
-                    ObjObjects.Dump(
-                        [&file, &size, &packages](UE_UObject object)
-                        {
-                            fmt::print(file, "[{:0>6}] <{}> {}\n", object.GetIndex(), object.GetAddress(), object.GetFullName()); size++;
-                            if (object.IsA<UE_UStruct>() || object.IsA<UE_UEnum>())
-                            {
-                                auto packageObj = object.GetPackageObject();
-                                packages[packageObj].push_back(object);
-                            }
-                        }
-                    );
-                }
-                else
-                {
-                    ObjObjects.Dump([&file, &size](UE_UObject object) { fmt::print(file, "[{:0>6}] <{}> {}\n", object.GetIndex(), object.GetAddress(), object.GetFullName()); size++; });
-                }
-
-                fmt::print("Objects: {}\n", size);
-            }
-
-            if (!Full) { return SUCCESS; }
-
-            {
-                // Clearing all empty packages
-                size_t size = packages.size();
-                size_t erased = std::erase_if(packages, [](std::pair<byte* const, std::vector<UE_UObject>>& package) { return package.second.size() < 2; });
-
-                fmt::print("Wiped {} out of {}\n", erased, size);
-            }
-
-            // Checking if we have any package after clearing.
-            if (!packages.size()) { return ZERO_PACKAGES; }
-
-            fmt::print("Packages: {}\n", packages.size());
-
-            {
-                auto path = Directory / "DUMP";
-                fs::create_directories(path);
-
-                int i = 1; int saved = 0;
-                std::string unsaved{};
-
-                for (UE_UPackage package : packages)
-                {
-                    fmt::print("\rProcessing: {}/{}", i++, packages.size());
-
-                    package.Process(ModuleBase);
-                    if (package.Save(path)) { saved++; }
-                    else { unsaved += (package.GetObject().GetName() + ", "); };
-                }
-
-                fmt::print("\nSaved packages: {}", saved);
-
-                if (unsaved.size())
-                {
-                    unsaved.erase(unsaved.size() - 2);
-                    fmt::print("\nUnsaved packages (empty classes): [ {} ]", unsaved);
-                }
-
-            }
-        }
-        return SUCCESS;
+        if (archive) { if (!writer.OpenArchive(directory / "DUMP.sdk", directory / "DUMP")) { puts(GetStatusMessage(FILE_NOT_OPEN)); return FAILED; } }
+        else { Writer::Prepare(directory / "DUMP"); }
+        if (amalgamate) { writer.Amalgamate(directory / "SDK.hpp"); }
     }
-};
 
-int main(int argc, char* argv[])
-{
-    auto dumper = Dumper::GetInstance();
+    status = dumper.Dump(writer, directory, full ? Dumper::All : Dumper::Names | Dumper::Objects);
 
-    switch (dumper->Init(argc, argv))
+    std::vector<fs::path> failed;
     {
-    case WINDOW_NOT_FOUND: { puts("Can't find UE4 window"); return FAILED; }
-    case PROCESS_NOT_FOUND: { puts("Can't find process"); return FAILED; }
-    case READER_ERROR: { puts("Can't init reader"); return FAILED; }
-    case CANNOT_GET_PROCNAME: { puts("Can't get process name"); return FAILED; }
-    case ENGINE_ERROR: { puts("Can't find offsets for this game"); return FAILED; }
-    case MODULE_NOT_FOUND: { puts("Can't enumerate modules (protected process?)"); return FAILED; }
-    case CANNOT_READ: { puts("Can't read process memory"); return FAILED; }
-    case INVALID_IMAGE: { puts("Can't get executable sections"); return FAILED; }
-    case OBJECTS_NOT_FOUND: { puts("Can't find objects array"); return FAILED; }
-    case NAMES_NOT_FOUND: { puts("Can't find names array"); return FAILED; }
-    case SUCCESS: { break; };
-    default: { return FAILED; }
+        TraceScope trace("Writer close");
+        failed = writer.Close();
     }
-
-    switch (dumper->Dump())
+    if (stats) { PrintReadStats(GetReadStats()); }
+    if (!trace.empty() && !WriteTrace(trace)) { failed.push_back(trace); }
+    if (failed.size())
     {
-    case FILE_NOT_OPEN: { puts("Can't open file"); return FAILED; }
-    case ZERO_PACKAGES: { puts("Size of packages is zero"); return FAILED; }
-    case SUCCESS: { break; }
-    default: { return FAILED; }
+        for (auto& path : failed) { fmt::print("Can't write: {}\n", path.string()); }
+        status = FILE_NOT_OPEN;
     }
 
+    if (status != SUCCESS) { puts(GetStatusMessage(status)); return FAILED; }
     return SUCCESS;
-}
\ No newline at end of file
+}
@@ -1,14 +1,218 @@
 #include "memory.h"
+#include "platform.h"
+#include <fmt/core.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/uio.h>
+#endif
 
-HANDLE hProcess;
+static thread_local ReaderTarget target;
 
-bool Read(void* address, void* buffer, size_t size)
+/*
+* Every thread counts its own reads, so counting costs no more than an increment.
+* Counters of running threads are summed on request, counters of finished threads are kept in 'retired'.
+*/
+struct ReadCounters
 {
-	return ReadProcessMemory(hProcess, address, buffer, size, nullptr);
+	std::atomic<uint64_t> Count = 0;
+	std::atomic<uint64_t> Bytes = 0;
+	std::atomic<uint64_t> Failures = 0;
+	std::atomic<uint64_t> Latency[ReadStats::Buckets]{};
+	void AddTo(ReadStats::Counters& stats) const
+	{
+		stats.Count += Count.load(std::memory_order_relaxed);
+		stats.Bytes += Bytes.load(std::memory_order_relaxed);
+		stats.Failures += Failures.load(std::memory_order_relaxed);
+		for (size_t i = 0; i < ReadStats::Buckets; i++) { stats.Latency[i] += Latency[i].load(std::memory_order_relaxed); }
+	}
+};
+static constexpr size_t TagCount = static_cast<size_t>(ReadTag::Count);
+static std::mutex countersLock;
+static std::vector<ReadCounters*> live;
+static ReadStats retired;
+static std::atomic<bool> timing = false;
+
+static struct ThreadCounters
+{
+	ReadCounters Tags[TagCount];
+	ThreadCounters() { std::lock_guard lock(countersLock); live.push_back(Tags); }
+	~ThreadCounters()
+	{
+		std::lock_guard lock(countersLock);
+		for (size_t i = 0; i < TagCount; i++) { Tags[i].AddTo(retired.Tags[i]); }
+		std::erase(live, Tags);
+	}
+} thread_local counters;
+
+// Only the owning thread writes its counters, so they're incremented without a locked instruction
+static void Add(std::atomic<uint64_t>& counter, uint64_t value)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+ReadStats::Counters ReadStats::Total() const
+{
+	Counters total;
+	for (auto& tag : Tags)
+	{
+		total.Count += tag.Count;
+		total.Bytes += tag.Bytes;
+		total.Failures += tag.Failures;
+		for (size_t i = 0; i < Buckets; i++) { total.Latency[i] += tag.Latency[i]; }
+	}
+	return total;
+}
+
+ReadStats GetReadStats()
+{
+	std::lock_guard lock(countersLock);
+	auto stats = retired;
+	for (auto tags : live)
+	{
+		for (size_t i = 0; i < TagCount; i++) { tags[i].AddTo(stats.Tags[i]); }
+	}
+	return stats;
+}
+
+uint64_t GetThreadReadCount()
+{
+	uint64_t count = 0;
+	for (auto& tag : counters.Tags) { count += tag.Count.load(std::memory_order_relaxed); }
+	return count;
+}
+
+void EnableReadTiming(bool enable)
+{
+	timing = enable;
+}
+
+static std::string FormatLatency(size_t bucket)
+{
+	auto ns = 1ull << bucket;
+	if (ns < 1000) { return fmt::format("<{} ns", ns); }
+	if (ns < 1000000) { return fmt::format("<{} us", ns / 1000); }
+	return fmt::format("<{} ms", ns / 1000000);
+}
+
+// Upper bound of the bucket that has the percentile
+static std::string Percentile(const ReadStats::Counters& counters, double percentile)
+{
+	uint64_t timed = 0;
+	for (auto count : counters.Latency) { timed += count; }
+	if (!timed) { return "-"; }
+	uint64_t seen = 0;
+	for (size_t i = 0; i < ReadStats::Buckets; i++)
+	{
+		seen += counters.Latency[i];
+		if (seen >= timed * percentile) { return FormatLatency(i); }
+	}
+	return FormatLatency(ReadStats::Buckets - 1);
+}
+
+void PrintReadStats(const ReadStats& stats)
+{
+	static constexpr const char* names[] = { "Other", "Name", "Object", "Property", "Function", "Enum" };
+	static_assert(std::size(names) == TagCount);
+
+	auto print = [](const char* name, const ReadStats::Counters& counters)
+	{
+		fmt::print("{:<10} {:>12} {:>10.1f} {:>10} {:>10} {:>10} {:>10}\n", name, counters.Count, counters.Bytes / 1048576.0, counters.Failures,
+			Percentile(counters, 0.5), Percentile(counters, 0.9), Percentile(counters, 0.99));
+	};
+	fmt::print("\n{:<10} {:>12} {:>10} {:>10} {:>10} {:>10} {:>10}\n", "Reads", "Count", "MB", "Failures", "p50", "p90", "p99");
+	for (size_t i = 0; i < TagCount; i++) { if (stats.Tags[i].Count) { print(names[i], stats.Tags[i]); } }
+	auto total = stats.Total();
+	print("Total", total);
+
+	uint64_t timed = 0;
+	for (auto count : total.Latency) { timed += count; }
+	if (!timed) { return; }
+	fmt::print("\nLatency of {} timed reads:\n", timed);
+	for (size_t i = 0; i < ReadStats::Buckets; i++)
+	{
+		if (total.Latency[i]) { fmt::print("{:>10} {:>12} {:>6.2f}%\n", FormatLatency(i), total.Latency[i], total.Latency[i] * 100.0 / timed); }
+	}
+}
+
+static bool ReadMemory(void* address, void* buffer, size_t size)
+{
+	if (target.Image)
+	{
+		auto offset = reinterpret_cast<uint64_t>(address) - target.Base;
+		if (offset >= target.Size || size > target.Size - offset) { return false; }
+		memcpy(buffer, target.Image + offset, size);
+		return true;
+	}
+#ifdef _WIN32
+	return ReadProcessMemory(reinterpret_cast<HANDLE>(target.Process), address, buffer, size, nullptr);
+#else
+	iovec local{ buffer, size }, remote{ address, size };
+	return process_vm_readv(static_cast<pid_t>(target.Process), &local, 1, &remote, 1, 0) == static_cast<ssize_t>(size);
+#endif
+}
+
+bool Read(void* address, void* buffer, size_t size, ReadTag tag)
+{
+	auto& tagCounters = counters.Tags[static_cast<size_t>(tag)];
+	Add(tagCounters.Count, 1);
+	Add(tagCounters.Bytes, size);
+
+	bool read;
+	if (timing.load(std::memory_order_relaxed))
+	{
+		auto begin = std::chrono::steady_clock::now();
+		read = ReadMemory(address, buffer, size);
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+		auto bucket = std::min<size_t>(std::bit_width(static_cast<uint64_t>(ns)), ReadStats::Buckets - 1);
+		Add(tagCounters.Latency[bucket], 1);
+	}
+	else
+	{
+		read = ReadMemory(address, buffer, size);
+	}
+	if (!read) { Add(tagCounters.Failures, 1); }
+	return read;
+}
+
+ReaderTarget GetReaderTarget()
+{
+	return target;
+}
+
+void SetReaderTarget(const ReaderTarget& target)
+{
+	::target = target;
 }
 
 bool ReaderInit(uint32_t pid)
 {
-	hProcess = OpenProcess(PROCESS_ALL_ACCESS, FALSE, pid);
-	return hProcess != nullptr;
-}
\ No newline at end of file
+	target = {};
+#ifdef _WIN32
+	target.Process = reinterpret_cast<intptr_t>(OpenProcess(PROCESS_ALL_ACCESS, FALSE, pid));
+	return target.Process != 0;
+#else
+	target.Process = static_cast<pid_t>(pid);
+	return kill(static_cast<pid_t>(pid), 0) == 0;
+#endif
+}
+
+void ReaderInit(const uint8_t* data, uint64_t base, size_t size)
+{
+	target = { data, base, size };
+}
+
+void ReaderClose()
+{
+#ifdef _WIN32
+	if (!target.Image && target.Process) { CloseHandle(reinterpret_cast<HANDLE>(target.Process)); }
+#endif
+	target = {};
+}
@@ -1,15 +1,70 @@
 #pragma once
-#include <windows.h>
+#include <cstddef>
 #include <cstdint>
 
-bool Read(void* address, void* buffer, size_t size);
+// What a read is for, every read is counted under its tag
+enum class ReadTag : uint8_t
+{
+	Other,
+	Name,
+	Object,
+	Property,
+	Function,
+	Enum,
+	Count
+};
+
+bool Read(void* address, void* buffer, size_t size, ReadTag tag = ReadTag::Other);
 
 template<typename T>
-T Read(void* address) 
+T Read(void* address, ReadTag tag = ReadTag::Other)
 {
 	T buffer{};
-	Read(address, &buffer, sizeof(T));
+	Read(address, &buffer, sizeof(T), tag);
 	return buffer;
 }
 
-bool ReaderInit(uint32_t pid);
\ No newline at end of file
+// Totals of the reads made by every thread so far
+struct ReadStats
+{
+	// Bucket 'i' of the latency histogram counts reads that took less than 2^i ns, but not less than 2^(i-1) ns
+	static constexpr size_t Buckets = 32;
+	struct Counters
+	{
+		uint64_t Count = 0;
+		uint64_t Bytes = 0;
+		uint64_t Failures = 0;
+		uint64_t Latency[Buckets]{};
+	};
+	Counters Tags[static_cast<size_t>(ReadTag::Count)];
+	Counters Total() const;
+};
+ReadStats GetReadStats();
+// Reads made by the calling thread so far, e.g. to count the reads of one stage of a pipeline
+uint64_t GetThreadReadCount();
+// Latency is measured only while timing is enabled, it costs two clock reads per read
+void EnableReadTiming(bool enable);
+// Prints reads, bytes and failures of every tag, and latency percentiles if timing was enabled
+void PrintReadStats(const ReadStats& stats);
+
+/*
+* Target of the reads, every thread reads from its own target, so threads can dump different games side by side.
+* Threads that help with a dump share the target of the thread that started them, see context.h.
+*/
+struct ReaderTarget
+{
+	// Set when reading from an image, reads outside of it fail like reads of unmapped memory
+	const uint8_t* Image = nullptr;
+	uint64_t Base = 0;
+	size_t Size = 0;
+	// Handle of the process on Windows, its id elsewhere
+	intptr_t Process = 0;
+};
+ReaderTarget GetReaderTarget();
+void SetReaderTarget(const ReaderTarget& target);
+
+bool ReaderInit(uint32_t pid);
+// Reads from an image in the dumper's own memory instead of a process, 'base' is the address the image's pointers are relative to
+void ReaderInit(const uint8_t* image, uint64_t base, size_t size);
+// Releases the process or the image, reads fail until the reader is initialized again
+void ReaderClose();
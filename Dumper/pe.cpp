@@ -0,0 +1,64 @@
+#include "pe.h"
+#include <cstring>
+
+// Offsets of the fields in PE32+ headers
+static constexpr size_t DosNewHeader = 0x3C;
+static constexpr size_t FileNumberOfSections = 0x6;
+static constexpr size_t FileTimeDateStamp = 0x8;
+static constexpr size_t FileSizeOfOptionalHeader = 0x14;
+static constexpr size_t FileHeaderEnd = 0x18;
+static constexpr size_t OptionalSizeOfImage = 0x38;
+static constexpr size_t OptionalSizeOfHeaders = 0x3C;
+static constexpr size_t SectionHeaderSize = 0x28;
+static constexpr size_t SectionVirtualSize = 0x8;
+static constexpr size_t SectionVirtualAddress = 0xC;
+static constexpr size_t SectionSizeOfRawData = 0x10;
+static constexpr size_t SectionCharacteristics = 0x24;
+
+template<typename T>
+static T Get(const uint8_t* data, size_t offset)
+{
+	T value;
+	memcpy(&value, data + offset, sizeof(T));
+	return value;
+}
+
+bool ParseHeaders(const uint8_t* headers, size_t size, ImageHeaders& fields)
+{
+	if (size < DosNewHeader + 4 || headers[0] != 'M' || headers[1] != 'Z') { return false; }
+	auto nt = Get<int32_t>(headers, DosNewHeader);
+	if (nt < 0 || nt + FileHeaderEnd + OptionalSizeOfHeaders + 4 > size || memcmp(headers + nt, "PE\0\0", 4)) { return false; }
+
+	auto optional = nt + FileHeaderEnd;
+	fields.TimeDateStamp = Get<uint32_t>(headers, nt + FileTimeDateStamp);
+	fields.SizeOfImage = Get<uint32_t>(headers, optional + OptionalSizeOfImage);
+	fields.SizeOfHeaders = Get<uint32_t>(headers, optional + OptionalSizeOfHeaders);
+	return true;
+}
+
+std::vector<ImageSection> ParseSections(const uint8_t* headers, size_t size, uint32_t required, uint32_t excluded)
+{
+	std::vector<ImageSection> sections;
+	if (size < DosNewHeader + 4 || headers[0] != 'M' || headers[1] != 'Z') { return sections; }
+	auto nt = Get<int32_t>(headers, DosNewHeader);
+	if (nt < 0 || nt + FileHeaderEnd + OptionalSizeOfImage + 4 > size || memcmp(headers + nt, "PE\0\0", 4)) { return sections; }
+
+	auto count = Get<uint16_t>(headers, nt + FileNumberOfSections);
+	auto optional = nt + FileHeaderEnd;
+	auto table = optional + Get<uint16_t>(headers, nt + FileSizeOfOptionalHeader);
+	if (table + count * SectionHeaderSize > size) { return sections; }
+	auto imageSize = Get<uint32_t>(headers, optional + OptionalSizeOfImage);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		auto section = headers + table + i * SectionHeaderSize;
+		auto characteristics = Get<uint32_t>(section, SectionCharacteristics);
+		if ((characteristics & required) != required || (characteristics & excluded)) { continue; }
+		auto virtualSize = Get<uint32_t>(section, SectionVirtualSize);
+		auto length = virtualSize ? virtualSize : Get<uint32_t>(section, SectionSizeOfRawData);
+		auto start = Get<uint32_t>(section, SectionVirtualAddress);
+		auto end = static_cast<uint64_t>(start) + length < imageSize ? start + length : imageSize;
+		if (start < end) { sections.push_back({ start, end }); }
+	}
+	return sections;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Section characteristics used to select sections, same values as IMAGE_SCN_*
+constexpr uint32_t SectionCode = 0x00000020;
+constexpr uint32_t SectionWrite = 0x80000000;
+
+// Section of a loaded module, bounds are offsets from the module base
+struct ImageSection
+{
+	uint32_t Start;
+	uint32_t End;
+};
+
+// Headers and the section table always fit into the first page of the image
+constexpr size_t ImageHeadersSize = 0x1000;
+
+// Fields of the file and optional headers that identify a build of the module
+struct ImageHeaders
+{
+	uint32_t TimeDateStamp;
+	uint32_t SizeOfImage;
+	uint32_t SizeOfHeaders;
+};
+
+// Gets them from a copy of the headers, false if they aren't PE32+ headers
+bool ParseHeaders(const uint8_t* headers, size_t size, ImageHeaders& fields);
+
+/*
+* Gets sections of a loaded image that have all 'required' characteristics and none of 'excluded' from a copy of its headers.
+* Loaded sections are laid out by their virtual addresses, raw data offsets only make sense in the file.
+* Doesn't depend on Windows headers, so it can be benchmarked anywhere.
+*/
+std::vector<ImageSection> ParseSections(const uint8_t* headers, size_t size, uint32_t required, uint32_t excluded);
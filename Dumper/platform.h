@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdio>
+
+/*
+* Windows headers on Windows, elsewhere the few names of them and of the MSVC runtime that the portable part of the dumper uses.
+* Readers, wrappers and writers build on Linux this way, against a synthetic image or a stand-in process.
+*/
+#ifdef _WIN32
+#include <windows.h>
+#undef GetObject
+#else
+#include <cerrno>
+using byte = unsigned char;
+inline int fopen_s(FILE** file, const char* path, const char* mode) { *file = fopen(path, mode); return *file ? 0 : errno; }
+#define fscanf_s fscanf
+#define _fseeki64 fseeko
+#define MAX_PATH 260
+#endif
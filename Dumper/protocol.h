@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+* Protocol of the dump daemon, every message is a little endian uint32_t size followed by that many bytes.
+* Request is { QueryOp Op; arguments }, response is { QueryStatus Status; results }, one response for every request in order.
+* Integers are little endian, strings are { uint32_t Size; char Data[Size]; } and aren't null-terminated.
+*
+* NameById { uint32_t Id } -> { string Name }
+* IdByName { string Name } -> { uint32_t Id }
+* ObjectByIndex { uint32_t Index } -> Object
+* FindObject { string FullName } -> Object
+*   Object { uint32_t Index; uint64_t Address; uint64_t Class; string FullName }
+* StructLayout { string FullName } -> { int32_t Size; int32_t Inherited; string Super; uint32_t Count; Member[Count] }
+*   Member { string Name; string Type; int32_t Offset; int32_t Size; int32_t ArrayDim; uint8_t FieldMask }, FieldMask is 0 unless it's a bit field
+* Hierarchy { string FullName } -> { uint32_t Count; string FullName[Count] }, the struct itself goes first, then its supers
+* Refresh {} -> { uint32_t Names; uint32_t Objects }, numbers of names and objects found since the last refresh
+* Stats {} -> { uint32_t Names; uint32_t Objects; uint32_t Layouts; uint64_t Refreshes; uint64_t Queries }
+*/
+
+enum class QueryOp : uint8_t
+{
+	Ping,
+	NameById,
+	IdByName,
+	ObjectByIndex,
+	FindObject,
+	StructLayout,
+	Hierarchy,
+	Refresh,
+	Stats
+};
+
+enum class QueryStatus : uint8_t
+{
+	Ok,
+	NotFound,
+	BadRequest
+};
+
+// Messages larger than this are rejected, so a broken client can't make the daemon allocate without bounds
+constexpr uint32_t MaxMessageSize = 16 << 20;
+
+class MessageWriter
+{
+private:
+	std::vector<uint8_t> data;
+public:
+	template<typename T>
+	MessageWriter& Put(T value)
+	{
+		auto size = data.size();
+		data.resize(size + sizeof(T));
+		memcpy(data.data() + size, &value, sizeof(T));
+		return *this;
+	}
+	MessageWriter& PutString(std::string_view str)
+	{
+		Put(static_cast<uint32_t>(str.size()));
+		data.insert(data.end(), str.begin(), str.end());
+		return *this;
+	}
+	const std::vector<uint8_t>& Data() const { return data; }
+	void Clear() { data.clear(); }
+};
+
+// Reading past the end of the message fails the reader, results of a failed reader are zeroed
+class MessageReader
+{
+private:
+	const uint8_t* it;
+	const uint8_t* end;
+	bool ok = true;
+public:
+	MessageReader(const uint8_t* data, size_t size) : it(data), end(data + size) {}
+	MessageReader(const std::vector<uint8_t>& data) : MessageReader(data.data(), data.size()) {}
+	template<typename T>
+	T Get()
+	{
+		T value{};
+		if (!ok || static_cast<size_t>(end - it) < sizeof(T)) { ok = false; return value; }
+		memcpy(&value, it, sizeof(T));
+		it += sizeof(T);
+		return value;
+	}
+	std::string_view GetString()
+	{
+		auto size = Get<uint32_t>();
+		if (!ok || static_cast<size_t>(end - it) < size) { ok = false; return {}; }
+		std::string_view str(reinterpret_cast<const char*>(it), size);
+		it += size;
+		return str;
+	}
+	operator bool() const { return ok; }
+	bool AtEnd() const { return it == end; }
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// Bounded multi-producer multi-consumer queue that connects the stages of the dump pipeline
+template<typename T>
+class BlockingQueue
+{
+private:
+	std::mutex mutex;
+	std::condition_variable notFull;
+	std::condition_variable notEmpty;
+	std::deque<T> items;
+	size_t capacity;
+	bool closed = false;
+public:
+	BlockingQueue(size_t capacity) : capacity(capacity ? capacity : 1) {}
+	// Blocks while the queue is full, returns false if the queue was closed
+	bool Push(T item)
+	{
+		std::unique_lock lock(mutex);
+		notFull.wait(lock, [this] { return items.size() < capacity || closed; });
+		if (closed) { return false; }
+		items.push_back(std::move(item));
+		notEmpty.notify_one();
+		return true;
+	}
+	// Blocks until an item is available, returns false once the queue is closed and drained
+	bool Pop(T& item)
+	{
+		std::unique_lock lock(mutex);
+		notEmpty.wait(lock, [this] { return items.size() || closed; });
+		if (!items.size()) { return false; }
+		item = std::move(items.front());
+		items.pop_front();
+		notFull.notify_one();
+		return true;
+	}
+	// Wakes up all waiting threads, consumers still drain the remaining items
+	void Close()
+	{
+		std::lock_guard lock(mutex);
+		closed = true;
+		notFull.notify_all();
+		notEmpty.notify_all();
+	}
+};
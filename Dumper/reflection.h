@@ -0,0 +1,364 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+* Binary reflection database of a dump, 'Reflection.bin' next to the headers, so tools read layouts without parsing text.
+* This header only needs the standard library and the file mapping of the system, tools can copy it as is.
+* Every field is little endian, tables are arrays of the records below at 8 byte aligned offsets from the start of the file:
+* Header { char Magic[8]; uint32_t Version; uint32_t Reserved; Table Strings, Chars, Names, Structs, Members, Types, Enums, Values, Functions, Params; }
+* Strings are { uint32_t Offset; uint32_t Size; } into Chars and aren't null-terminated, records reference them by index.
+* Structs and enums are sorted by 'Hash' and the members of every struct by 'NameHash', so two databases are compared in one merge pass.
+* Opening checks only the header, every accessor checks its own indices, so a mapped file is ready in constant time.
+*/
+
+constexpr char ReflectionMagic[8] = { 'U', 'D', 'R', 'E', 'F', 'L', 0, 0 };
+constexpr uint32_t ReflectionVersion = 2;
+// Index of a record or a string that isn't there
+constexpr uint32_t ReflectionNone = ~0u;
+
+struct ReflectionTable
+{
+	uint64_t Offset;
+	uint64_t Count;
+};
+
+struct ReflectionHeader
+{
+	char Magic[8];
+	uint32_t Version;
+	uint32_t Reserved;
+	ReflectionTable Strings;
+	ReflectionTable Chars;
+	ReflectionTable Names;
+	ReflectionTable Structs;
+	ReflectionTable Members;
+	ReflectionTable Types;
+	ReflectionTable Enums;
+	ReflectionTable Values;
+	ReflectionTable Functions;
+	ReflectionTable Params;
+};
+
+struct ReflectionString
+{
+	uint32_t Offset;
+	uint32_t Size;
+};
+
+// Entry of the name pool of the game, sorted by 'Id', empty when the names weren't dumped with the packages
+struct ReflectionName
+{
+	uint32_t Id;
+	uint32_t String;
+};
+
+enum ReflectionStructFlags : uint32_t
+{
+	ReflectionClass = 1
+};
+
+struct ReflectionStruct
+{
+	// 'ReflectionHash' of the full name, e.g. "Class Engine.Actor"
+	uint64_t Hash;
+	// 'ReflectionHash' of the full name of the super, 0 if it has none
+	uint64_t SuperHash;
+	uint32_t FullName;
+	uint32_t CppName;
+	uint32_t Package;
+	// Index of the super, 'ReflectionNone' if it has none or it isn't in the dump, 'SuperName' is set either way
+	uint32_t Super;
+	uint32_t SuperName;
+	int32_t Size;
+	int32_t Inherited;
+	uint32_t MembersBegin;
+	uint32_t MembersCount;
+	uint32_t FunctionsBegin;
+	uint32_t FunctionsCount;
+	uint32_t Flags;
+};
+
+// Property of a struct or a parameter of a function, padding isn't stored
+struct ReflectionMember
+{
+	uint64_t NameHash;
+	// EPropertyFlags of the game
+	uint64_t Flags;
+	uint32_t Name;
+	// Index of the type
+	uint32_t Type;
+	int32_t Offset;
+	// Size of all elements
+	int32_t Size;
+	int32_t ArrayDim;
+	// Bit fields have 'BitSize' bits from 'BitOffset' of the byte at 'Offset', 'BitSize' is 0 for other members
+	uint8_t BitOffset;
+	uint8_t BitSize;
+	uint16_t Reserved;
+};
+
+// Class of a property, in the order of the property classes of the engine the dumper knows
+enum ReflectionKind : uint8_t
+{
+	ReflectionUnknown,
+	ReflectionStructProperty,
+	ReflectionObjectProperty,
+	ReflectionSoftObjectProperty,
+	ReflectionFloatProperty,
+	ReflectionByteProperty,
+	ReflectionBoolProperty,
+	ReflectionIntProperty,
+	ReflectionInt8Property,
+	ReflectionInt16Property,
+	ReflectionInt64Property,
+	ReflectionUInt16Property,
+	ReflectionUInt32Property,
+	ReflectionUInt64Property,
+	ReflectionNameProperty,
+	ReflectionDelegateProperty,
+	ReflectionSetProperty,
+	ReflectionArrayProperty,
+	ReflectionWeakObjectProperty,
+	ReflectionStrProperty,
+	ReflectionTextProperty,
+	ReflectionMulticastSparseDelegateProperty,
+	ReflectionEnumProperty,
+	ReflectionDoubleProperty,
+	ReflectionMulticastDelegateProperty,
+	ReflectionClassProperty,
+	ReflectionMulticastInlineDelegateProperty,
+	ReflectionMapProperty,
+	ReflectionInterfaceProperty
+};
+
+// Types are stored once and shared by every member and parameter of the same type
+struct ReflectionType
+{
+	// 'ReflectionHash' of the full name of the referenced struct, class or enum, 0 if the kind references none
+	uint64_t RefHash;
+	// Type as it's written in the headers, e.g. "struct TArray<struct FName>"
+	uint32_t Text;
+	// Index of the referenced enum for enum properties and of the struct for others, 'ReflectionNone' if it isn't in the dump
+	uint32_t Ref;
+	// Type of the elements of arrays and sets and of the keys of maps, 'ReflectionNone' for other kinds
+	uint32_t Inner;
+	// Type of the values of maps
+	uint32_t Value;
+	uint8_t Kind;
+	uint8_t Reserved[7];
+};
+
+struct ReflectionEnum
+{
+	uint64_t Hash;
+	uint32_t FullName;
+	uint32_t Name;
+	uint32_t Package;
+	uint32_t ValuesBegin;
+	uint32_t ValuesCount;
+	uint32_t Reserved;
+};
+
+struct ReflectionValue
+{
+	int64_t Value;
+	uint32_t Name;
+	uint32_t Reserved;
+};
+
+struct ReflectionFunction
+{
+	// Address of the native function relative to the module, 0 if there's none
+	uint64_t Rva;
+	uint32_t FullName;
+	uint32_t Name;
+	// EFunctionFlags of the game
+	uint32_t Flags;
+	// Index of the type, 'ReflectionNone' for void
+	uint32_t ReturnType;
+	uint32_t ParamsBegin;
+	uint32_t ParamsCount;
+};
+
+static_assert(sizeof(ReflectionStruct) == 64 && sizeof(ReflectionMember) == 40 && sizeof(ReflectionType) == 32, "records have a fixed layout");
+static_assert(sizeof(ReflectionEnum) == 32 && sizeof(ReflectionValue) == 16 && sizeof(ReflectionFunction) == 32, "records have a fixed layout");
+
+// FNV-1a, identities of structs and members
+constexpr uint64_t ReflectionHash(std::string_view str)
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (auto c : str) { hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001B3ull; }
+	return hash;
+}
+
+// View of a database in memory, nothing is copied or parsed
+class ReflectionView
+{
+private:
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+	ReflectionHeader header{};
+	template<typename T>
+	std::span<const T> Table(const ReflectionTable& table) const
+	{
+		return { reinterpret_cast<const T*>(data + table.Offset), static_cast<size_t>(table.Count) };
+	}
+	template<typename T>
+	bool Fits(const ReflectionTable& table) const
+	{
+		return table.Offset % alignof(T) == 0 && table.Offset <= size && table.Count <= (size - table.Offset) / sizeof(T);
+	}
+	template<typename T>
+	static std::span<const T> Range(std::span<const T> table, uint32_t begin, uint32_t count)
+	{
+		if (begin > table.size() || count > table.size() - begin) { return {}; }
+		return table.subspan(begin, count);
+	}
+public:
+	ReflectionView() = default;
+	// Checks the header and the bounds of the tables, 'data' has to stay alive and be 8 byte aligned
+	bool Open(const void* data, size_t size)
+	{
+		this->data = static_cast<const uint8_t*>(data);
+		this->size = size;
+		if (reinterpret_cast<uintptr_t>(data) % 8 || size < sizeof(ReflectionHeader)) { return false; }
+		memcpy(&header, data, sizeof(header));
+		if (memcmp(header.Magic, ReflectionMagic, sizeof(ReflectionMagic)) || header.Version != ReflectionVersion) { return false; }
+		if (!Fits<ReflectionString>(header.Strings) || !Fits<char>(header.Chars) || !Fits<ReflectionName>(header.Names)) { return false; }
+		if (!Fits<ReflectionStruct>(header.Structs) || !Fits<ReflectionMember>(header.Members) || !Fits<ReflectionType>(header.Types)) { return false; }
+		if (!Fits<ReflectionEnum>(header.Enums) || !Fits<ReflectionValue>(header.Values)) { return false; }
+		return Fits<ReflectionFunction>(header.Functions) && Fits<ReflectionMember>(header.Params);
+	}
+	std::span<const ReflectionString> Strings() const { return Table<ReflectionString>(header.Strings); }
+	std::span<const ReflectionName> Names() const { return Table<ReflectionName>(header.Names); }
+	std::span<const ReflectionStruct> Structs() const { return Table<ReflectionStruct>(header.Structs); }
+	std::span<const ReflectionMember> Members() const { return Table<ReflectionMember>(header.Members); }
+	std::span<const ReflectionType> Types() const { return Table<ReflectionType>(header.Types); }
+	std::span<const ReflectionEnum> Enums() const { return Table<ReflectionEnum>(header.Enums); }
+	std::span<const ReflectionValue> Values() const { return Table<ReflectionValue>(header.Values); }
+	std::span<const ReflectionFunction> Functions() const { return Table<ReflectionFunction>(header.Functions); }
+	std::span<const ReflectionMember> Params() const { return Table<ReflectionMember>(header.Params); }
+	// Ranges of a record are empty if they're broken
+	std::span<const ReflectionMember> Members(const ReflectionStruct& s) const { return Range(Members(), s.MembersBegin, s.MembersCount); }
+	std::span<const ReflectionFunction> Functions(const ReflectionStruct& s) const { return Range(Functions(), s.FunctionsBegin, s.FunctionsCount); }
+	std::span<const ReflectionMember> Params(const ReflectionFunction& f) const { return Range(Params(), f.ParamsBegin, f.ParamsCount); }
+	std::span<const ReflectionValue> Values(const ReflectionEnum& e) const { return Range(Values(), e.ValuesBegin, e.ValuesCount); }
+	// Empty for 'ReflectionNone' and broken indices
+	std::string_view String(uint32_t index) const
+	{
+		if (index >= header.Strings.Count) { return {}; }
+		auto& str = Strings()[index];
+		if (str.Offset > header.Chars.Count || str.Size > header.Chars.Count - str.Offset) { return {}; }
+		return { reinterpret_cast<const char*>(data + header.Chars.Offset) + str.Offset, str.Size };
+	}
+	// Null for 'ReflectionNone' and broken indices
+	const ReflectionType* Type(uint32_t index) const { return index < header.Types.Count ? &Types()[index] : nullptr; }
+	std::string_view TypeText(uint32_t index) const
+	{
+		auto type = Type(index);
+		return type ? String(type->Text) : std::string_view();
+	}
+	// Binary search by the hash of the full name
+	template<typename T>
+	const T* Find(std::span<const T> records, std::string_view fullName) const
+	{
+		auto hash = ReflectionHash(fullName);
+		size_t begin = 0, end = records.size();
+		while (begin < end)
+		{
+			auto middle = begin + (end - begin) / 2;
+			if (records[middle].Hash < hash) { begin = middle + 1; }
+			else { end = middle; }
+		}
+		for (; begin < records.size() && records[begin].Hash == hash; begin++)
+		{
+			if (String(records[begin].FullName) == fullName) { return &records[begin]; }
+		}
+		return nullptr;
+	}
+	const ReflectionStruct* FindStruct(std::string_view fullName) const { return Find(Structs(), fullName); }
+	const ReflectionEnum* FindEnum(std::string_view fullName) const { return Find(Enums(), fullName); }
+	// Binary search by the id of the name, empty if it isn't there
+	std::string_view FindName(uint32_t id) const
+	{
+		auto names = Names();
+		size_t begin = 0, end = names.size();
+		while (begin < end)
+		{
+			auto middle = begin + (end - begin) / 2;
+			if (names[middle].Id < id) { begin = middle + 1; }
+			else { end = middle; }
+		}
+		return begin < names.size() && names[begin].Id == id ? String(names[begin].String) : std::string_view();
+	}
+};
+
+// Database mapped from a file, pages are read when they're touched
+class ReflectionFile
+{
+private:
+	const void* data = nullptr;
+	size_t size = 0;
+	ReflectionView view;
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#endif
+public:
+	ReflectionFile() = default;
+	ReflectionFile(const ReflectionFile&) = delete;
+	ReflectionFile& operator=(const ReflectionFile&) = delete;
+	~ReflectionFile() { Close(); }
+	bool Open(const char* path)
+	{
+		Close();
+#ifdef _WIN32
+		file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) { return false; }
+		LARGE_INTEGER length{};
+		if (!GetFileSizeEx(file, &length) || !length.QuadPart) { Close(); return false; }
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping) { data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0); }
+		size = static_cast<size_t>(length.QuadPart);
+#else
+		auto fd = open(path, O_RDONLY);
+		if (fd < 0) { return false; }
+		struct stat info{};
+		if (!fstat(fd, &info) && info.st_size > 0)
+		{
+			auto mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapped != MAP_FAILED) { data = mapped; size = static_cast<size_t>(info.st_size); }
+		}
+		close(fd);
+#endif
+		if (!data || !view.Open(data, size)) { Close(); return false; }
+		return true;
+	}
+	void Close()
+	{
+#ifdef _WIN32
+		if (data) { UnmapViewOfFile(data); }
+		if (mapping) { CloseHandle(mapping); }
+		if (file != INVALID_HANDLE_VALUE) { CloseHandle(file); }
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (data) { munmap(const_cast<void*>(data), size); }
+#endif
+		data = nullptr;
+		size = 0;
+		view = {};
+	}
+	const ReflectionView& View() const { return view; }
+};
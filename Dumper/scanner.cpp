@@ -0,0 +1,298 @@
+#include "scanner.h"
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <thread>
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+static const uint8_t* ScanScalar(const uint8_t* start, const uint8_t* end, const Pattern& sig)
+{
+	for (auto it = start; it + sig.Size <= end; it++) { if (sig.Compare(it)) { return it; } }
+	return nullptr;
+}
+
+// Compares the signature 16 bytes at a time, wildcards are masked out of the comparison result
+static bool VerifySSE2(const uint8_t* data, const uint8_t* end, const Pattern& sig)
+{
+	for (size_t i = 0; i < sig.Size; i += 16)
+	{
+		uint32_t care = static_cast<uint32_t>(sig.Care >> i) & 0xFFFF;
+		if (data + i + 16 > end)
+		{
+			for (size_t j = i; j < sig.Size; j++) { if ((data[j] & sig.Mask[j]) != sig.Value[j]) { return false; } }
+			return true;
+		}
+		auto eq = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(sig.Value + i)));
+		if ((static_cast<uint32_t>(_mm_movemask_epi8(eq)) & care) != care) { return false; }
+	}
+	return true;
+}
+
+static const uint8_t* ScanSSE2(const uint8_t* start, const uint8_t* end, const Pattern& sig)
+{
+	if (!sig.Care || end - start < static_cast<ptrdiff_t>(sig.Size)) { return ScanScalar(start, end, sig); }
+	const uint8_t* last = end - sig.Size;
+	auto anchor = _mm_set1_epi8(static_cast<char>(sig.Value[sig.Anchor]));
+	auto it = start;
+	for (; it + 15 <= last; it += 16)
+	{
+		auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it + sig.Anchor));
+		uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, anchor));
+		for (; mask; mask &= mask - 1)
+		{
+			auto candidate = it + std::countr_zero(mask);
+			if (VerifySSE2(candidate, end, sig)) { return candidate; }
+		}
+	}
+	return ScanScalar(it, end, sig);
+}
+
+TARGET_AVX2 static bool VerifyAVX2(const uint8_t* data, const uint8_t* end, const Pattern& sig)
+{
+	for (size_t i = 0; i < sig.Size; i += 32)
+	{
+		uint32_t care = static_cast<uint32_t>(sig.Care >> i);
+		if (data + i + 32 > end)
+		{
+			for (size_t j = i; j < sig.Size; j++) { if ((data[j] & sig.Mask[j]) != sig.Value[j]) { return false; } }
+			return true;
+		}
+		auto eq = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sig.Value + i)));
+		if ((static_cast<uint32_t>(_mm256_movemask_epi8(eq)) & care) != care) { return false; }
+	}
+	return true;
+}
+
+TARGET_AVX2 static const uint8_t* ScanAVX2(const uint8_t* start, const uint8_t* end, const Pattern& sig)
+{
+	if (!sig.Care || end - start < static_cast<ptrdiff_t>(sig.Size)) { return ScanScalar(start, end, sig); }
+	const uint8_t* last = end - sig.Size;
+	auto anchor = _mm256_set1_epi8(static_cast<char>(sig.Value[sig.Anchor]));
+	auto it = start;
+	for (; it + 31 <= last; it += 32)
+	{
+		auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it + sig.Anchor));
+		uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, anchor));
+		for (; mask; mask &= mask - 1)
+		{
+			auto candidate = it + std::countr_zero(mask);
+			if (VerifyAVX2(candidate, end, sig)) { return candidate; }
+		}
+	}
+	return ScanSSE2(it, end, sig);
+}
+
+uint32_t MultiScanner::Add(const Pattern& sig)
+{
+	uint32_t id = static_cast<uint32_t>(signatures.size());
+	signatures.push_back(sig);
+	auto anchor = sig.Value[sig.Anchor];
+	if (!anchored[anchor].size()) { anchors.push_back(anchor); }
+	anchored[anchor].push_back(id);
+	if (sig.Size > maxSize) { maxSize = sig.Size; }
+	return id;
+}
+
+void MultiScanner::Check(const uint8_t* position, const uint8_t* start, const uint8_t* end, std::vector<const uint8_t*>& results, size_t& left) const
+{
+	for (auto id : anchored[*position])
+	{
+		if (results[id]) { continue; }
+		auto& sig = signatures[id];
+		// Positions only grow, so the first verified candidate of a signature is its lowest match
+		if (position - start < static_cast<ptrdiff_t>(sig.Anchor)) { continue; }
+		auto candidate = position - sig.Anchor;
+		if (end - candidate < static_cast<ptrdiff_t>(sig.Size)) { continue; }
+		if (VerifySSE2(candidate, end, sig)) { results[id] = candidate; left--; }
+	}
+}
+
+// Advances 'it' to the next 32 byte block that holds any anchor byte, returns positions of anchors in the block or 0 at the end
+TARGET_AVX2 static uint32_t FindAnchorsAVX2(const uint8_t*& it, const uint8_t* end, const uint8_t* anchors, size_t count)
+{
+	for (; it + 32 <= end; it += 32)
+	{
+		auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+		auto hits = _mm256_setzero_si256();
+		for (size_t i = 0; i < count; i++) { hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(static_cast<char>(anchors[i])))); }
+		if (uint32_t mask = _mm256_movemask_epi8(hits)) { return mask; }
+	}
+	return 0;
+}
+
+// Advances 'it' to the next 16 byte block that holds any anchor byte, returns positions of anchors in the block or 0 at the end
+static uint32_t FindAnchorsSSE2(const uint8_t*& it, const uint8_t* end, const uint8_t* anchors, size_t count)
+{
+	for (; it + 16 <= end; it += 16)
+	{
+		auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+		auto hits = _mm_setzero_si128();
+		for (size_t i = 0; i < count; i++) { hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, _mm_set1_epi8(static_cast<char>(anchors[i])))); }
+		if (uint32_t mask = _mm_movemask_epi8(hits)) { return mask; }
+	}
+	return 0;
+}
+
+void MultiScanner::ScanRange(const uint8_t* start, const uint8_t* end, ScanImpl impl, std::vector<const uint8_t*>& results, size_t left) const
+{
+	auto it = start;
+
+	if (impl != ScanImpl::Scalar && anchors.size())
+	{
+		auto find = impl == ScanImpl::AVX2 ? FindAnchorsAVX2 : FindAnchorsSSE2;
+		size_t width = impl == ScanImpl::AVX2 ? 32 : 16;
+		while (left)
+		{
+			auto mask = find(it, end, anchors.data(), anchors.size());
+			if (!mask) { break; }
+			for (; mask && left; mask &= mask - 1) { Check(it + std::countr_zero(mask), start, end, results, left); }
+			it += width;
+		}
+	}
+
+	// Tail that doesn't fill a whole vector
+	for (; it < end && left; it++) { if (anchored[*it].size()) { Check(it, start, end, results, left); } }
+}
+
+std::vector<const uint8_t*> MultiScanner::Scan(const uint8_t* start, const uint8_t* end, ScanImpl impl) const
+{
+	std::vector<const uint8_t*> results(signatures.size(), nullptr);
+	ScanRange(start, end, impl, results, signatures.size());
+	return results;
+}
+
+std::vector<const uint8_t*> MultiScanner::ScanParallel(const std::vector<Range>& ranges, ScanImpl impl, unsigned threads) const
+{
+	// Stripes are numbered in the order of the ranges, so the lowest stripe with a match holds the first match
+	struct Stripe { const uint8_t* Start; const uint8_t* End; const uint8_t* Limit; };
+	std::vector<Stripe> stripes;
+	for (auto& [start, end] : ranges)
+	{
+		for (auto it = start; it < end; it += StripeSize)
+		{
+			auto limit = end - it > static_cast<ptrdiff_t>(StripeSize) ? it + StripeSize : end;
+			// Matches that start in the stripe may end in the next one
+			auto overlap = end - limit > static_cast<ptrdiff_t>(maxSize - 1) ? limit + maxSize - 1 : end;
+			stripes.push_back({ it, overlap, limit });
+		}
+	}
+
+	std::vector<const uint8_t*> results(signatures.size(), nullptr);
+	// Matches of every stripe, each one is written only by the thread that scanned it
+	std::vector<const uint8_t*> stripeResults(stripes.size() * signatures.size());
+	std::vector<std::atomic<size_t>> found(signatures.size());
+	for (auto& stripe : found) { stripe = SIZE_MAX; }
+	std::atomic<size_t> next = 0;
+
+	auto worker = [&]()
+	{
+		std::vector<const uint8_t*> matches(signatures.size());
+		for (size_t index; (index = next++) < stripes.size();)
+		{
+			// Signatures found in lower stripes are filled in so the scan doesn't look for them
+			size_t left = 0;
+			for (size_t id = 0; id < signatures.size(); id++)
+			{
+				matches[id] = found[id] < index ? stripes[index].Start : nullptr;
+				if (!matches[id]) { left++; }
+			}
+			// Stripes are taken in order, every later one is above the found matches as well
+			if (!left) { break; }
+
+			auto& stripe = stripes[index];
+			ScanRange(stripe.Start, stripe.End, impl, matches, left);
+			for (size_t id = 0; id < signatures.size(); id++)
+			{
+				if (found[id] < index || !matches[id] || matches[id] >= stripe.Limit) { continue; }
+				stripeResults[index * signatures.size() + id] = matches[id];
+				size_t current = found[id];
+				while (index < current && !found[id].compare_exchange_weak(current, index));
+			}
+		}
+	};
+
+	threads = threads ? threads : 1;
+	if (threads > stripes.size()) { threads = static_cast<unsigned>(stripes.size()); }
+	std::vector<std::thread> pool;
+	for (unsigned i = 1; i < threads; i++) { pool.emplace_back(worker); }
+	worker();
+	for (auto& thread : pool) { thread.join(); }
+
+	for (size_t id = 0; id < signatures.size(); id++)
+	{
+		if (found[id] != SIZE_MAX) { results[id] = stripeResults[found[id] * signatures.size() + id]; }
+	}
+
+	return results;
+}
+
+std::vector<const uint8_t*> MultiScanner::ScanParallel(const std::vector<Range>& ranges) const
+{
+	auto threads = std::thread::hardware_concurrency();
+	return ScanParallel(ranges, GetScanImpl(), threads);
+}
+
+static bool HasAVX2()
+{
+#ifdef _MSC_VER
+	int info[4]{};
+	__cpuid(info, 0);
+	if (info[0] < 7) { return false; }
+	__cpuid(info, 1);
+	// AVX registers have to be enabled by the OS as well
+	bool osxsave = info[2] & (1 << 27), avx = info[2] & (1 << 28);
+	if (!(osxsave && avx) || (_xgetbv(0) & 6) != 6) { return false; }
+	__cpuidex(info, 7, 0);
+	return info[1] & (1 << 5);
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+ScanImpl GetScanImpl()
+{
+	static ScanImpl impl = HasAVX2() ? ScanImpl::AVX2 : ScanImpl::SSE2;
+	return impl;
+}
+
+const uint8_t* Scan(const uint8_t* start, const uint8_t* end, const Pattern& sig, ScanImpl impl)
+{
+	switch (impl)
+	{
+	case ScanImpl::AVX2: { return ScanAVX2(start, end, sig); }
+	case ScanImpl::SSE2: { return ScanSSE2(start, end, sig); }
+	default: { return ScanScalar(start, end, sig); }
+	}
+}
+
+const uint8_t* Scan(const uint8_t* start, const uint8_t* end, const Pattern& sig)
+{
+	return Scan(start, end, sig, GetScanImpl());
+}
+
+uint8_t* FindSignature(uint8_t* start, uint8_t* end, const Pattern& pattern)
+{
+	return const_cast<uint8_t*>(Scan(start, end, pattern));
+}
+
+void* FindPointer(uint8_t* start, uint8_t* end, const Pattern& pattern, int32_t addition)
+{
+	auto address = FindSignature(start, end, pattern);
+	if (!address) { return nullptr; }
+	return ResolvePointer(address, pattern, addition);
+}
+
+void* ResolvePointer(uint8_t* address, const Pattern& pattern, int32_t addition)
+{
+	// Pattern without rel32 has nothing to resolve
+	if (pattern.Displacement == Pattern::NoDisplacement) { return nullptr; }
+	int32_t offset = 0;
+	memcpy(&offset, address + pattern.Displacement, sizeof(offset));
+	return address + pattern.Displacement + 4 + offset + addition;
+}
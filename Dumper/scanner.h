@@ -0,0 +1,146 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+enum class ScanImpl
+{
+	Scalar,
+	SSE2,
+	AVX2
+};
+
+/*
+* Approximate frequency of bytes in x64 code (per mille), bytes that aren't listed are rare.
+* The anchor is the byte with the lowest frequency, so the vector search yields as few candidates as possible.
+*/
+inline constexpr struct { uint8_t Byte; uint16_t Frequency; } CommonBytes[] =
+{
+	{ 0x00, 120 }, { 0xFF, 40 }, { 0x48, 38 }, { 0x8B, 30 }, { 0xCC, 25 }, { 0x89, 22 }, { 0x24, 18 }, { 0x0F, 16 },
+	{ 0xE8, 15 }, { 0x4C, 14 }, { 0x8D, 13 }, { 0x44, 12 }, { 0x85, 11 }, { 0x01, 11 }, { 0xC0, 10 }, { 0x08, 10 },
+	{ 0x10, 10 }, { 0x20, 9 }, { 0x40, 9 }, { 0x83, 9 }, { 0x74, 8 }, { 0x45, 8 }, { 0x49, 7 }, { 0x75, 7 },
+	{ 0xEB, 6 }, { 0x41, 6 }, { 0x33, 6 }, { 0xC3, 6 }, { 0x18, 6 }, { 0x28, 6 }, { 0x30, 6 }, { 0x38, 5 },
+	{ 0x05, 5 }, { 0x0D, 5 }, { 0x15, 5 }, { 0x1D, 5 }, { 0x4D, 5 }, { 0x02, 5 }, { 0x03, 5 }, { 0x04, 5 },
+	{ 0x50, 4 }, { 0x58, 4 }, { 0x60, 4 }, { 0x68, 4 }, { 0x70, 4 }, { 0x78, 4 }, { 0x80, 4 }, { 0xC7, 4 },
+};
+
+/*
+* Byte pattern parsed at compile time from an IDA-style string, e.g. Pattern("48 8B 05 ?? ?? ?? ??", 3).
+* '?' or '??' is a wildcard, any other token is a hex byte, so literal zero bytes can be matched as well.
+* Displacement is the offset of the rel32 that the pattern references.
+* Malformed patterns and patterns longer than MaxSize don't compile, they're never truncated.
+*/
+struct Pattern
+{
+	static constexpr size_t MaxSize = 64;
+	static constexpr int32_t NoDisplacement = -1;
+	uint8_t Value[MaxSize]{};
+	// 0xFF for bytes that have to match, 0x00 for wildcards
+	uint8_t Mask[MaxSize]{};
+	// Bit per byte of the pattern, set for bytes that have to match
+	uint64_t Care = 0;
+	static_assert(MaxSize <= sizeof(Care) * 8, "Care has a bit per byte of the pattern");
+	size_t Size = 0;
+	// Position of the rarest byte, candidates are found by searching for it
+	size_t Anchor = 0;
+	int32_t Displacement = NoDisplacement;
+
+	consteval Pattern(const char* str, int32_t displacement = NoDisplacement) : Displacement(displacement)
+	{
+		for (size_t i = 0; str[i];)
+		{
+			if (str[i] == ' ') { i++; continue; }
+			if (Size == MaxSize) { throw "pattern is longer than Pattern::MaxSize"; }
+			if (str[i] == '?')
+			{
+				i += str[i + 1] == '?' ? 2 : 1;
+				Size++;
+				continue;
+			}
+			auto high = ParseHex(str[i]), low = ParseHex(str[i + 1]);
+			if (high < 0 || low < 0) { throw "pattern has a token that isn't a hex byte or a wildcard"; }
+			Value[Size] = static_cast<uint8_t>(high << 4 | low);
+			Mask[Size] = 0xFF;
+			Care |= 1ull << Size;
+			Size++;
+			i += 2;
+		}
+		if (!Care) { throw "pattern has no bytes to match"; }
+		if (Displacement != NoDisplacement && (Displacement < 0 || Displacement + 4 > static_cast<int32_t>(Size))) { throw "displacement is out of the pattern"; }
+
+		uint16_t best = UINT16_MAX;
+		for (size_t i = 0; i < Size; i++)
+		{
+			if (!Mask[i]) { continue; }
+			auto frequency = GetFrequency(Value[i]);
+			if (frequency < best) { best = frequency; Anchor = i; }
+		}
+	}
+	bool Compare(const uint8_t* data) const
+	{
+		for (size_t i = 0; i < Size; i++) { if ((data[i] & Mask[i]) != Value[i]) { return false; } }
+		return true;
+	}
+private:
+	static constexpr int ParseHex(char c)
+	{
+		if (c >= '0' && c <= '9') { return c - '0'; }
+		if (c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+		if (c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+		return -1;
+	}
+	static constexpr uint16_t GetFrequency(uint8_t byte)
+	{
+		for (auto& common : CommonBytes) { if (common.Byte == byte) { return common.Frequency; } }
+		return 1;
+	}
+};
+
+// Gets the fastest implementation supported by this CPU
+ScanImpl GetScanImpl();
+// Finds the first match in [start, end) with the given implementation
+const uint8_t* Scan(const uint8_t* start, const uint8_t* end, const Pattern& sig, ScanImpl impl);
+// Finds the first match in [start, end) with the fastest implementation
+const uint8_t* Scan(const uint8_t* start, const uint8_t* end, const Pattern& sig);
+
+// Finds the first match in [start, end) with the fastest implementation, nullptr if there's none
+uint8_t* FindSignature(uint8_t* start, uint8_t* end, const Pattern& pattern);
+// Finds the first match and gets address that is referenced by its rel32
+void* FindPointer(uint8_t* start, uint8_t* end, const Pattern& pattern, int32_t addition = 0);
+// Gets address that is referenced by rel32 at the displacement of the matched pattern, nullptr if the pattern has no displacement
+void* ResolvePointer(uint8_t* address, const Pattern& pattern, int32_t addition = 0);
+
+// Finds every registered pattern in one pass over the data
+class MultiScanner
+{
+private:
+	std::vector<Pattern> signatures;
+	// Ids of signatures by their anchor byte, a byte is a candidate if any signature is anchored on it
+	std::vector<uint32_t> anchored[256];
+	std::vector<uint8_t> anchors;
+	size_t maxSize = 0;
+	void Check(const uint8_t* position, const uint8_t* start, const uint8_t* end, std::vector<const uint8_t*>& results, size_t& left) const;
+	// Fills empty entries of results with first matches in [start, end), 'left' is the number of empty entries
+	void ScanRange(const uint8_t* start, const uint8_t* end, ScanImpl impl, std::vector<const uint8_t*>& results, size_t left) const;
+public:
+	using Range = std::pair<const uint8_t*, const uint8_t*>;
+	// Ranges are split into stripes of this size for parallel scanning
+	static constexpr size_t StripeSize = 1 << 20;
+	// Registers signature, returns id of its result
+	uint32_t Add(const Pattern& sig);
+	size_t Size() const { return signatures.size(); }
+	// Matches that start in a chunk of data may extend this many bytes minus one into the next chunk
+	size_t MaxPatternSize() const { return maxSize; }
+	const Pattern& Get(uint32_t id) const { return signatures[id]; }
+	// Gets the first match of every signature in [start, end) indexed by id, nullptr if it wasn't found
+	std::vector<const uint8_t*> Scan(const uint8_t* start, const uint8_t* end, ScanImpl impl) const;
+	std::vector<const uint8_t*> Scan(const uint8_t* start, const uint8_t* end) const { return Scan(start, end, GetScanImpl()); }
+	/*
+	* Gets the first match of every signature across the ranges, earlier ranges come first regardless of their addresses.
+	* Stripes are scanned on 'threads' threads and the remaining ones are skipped once every signature has a match in a lower stripe,
+	* so the result is the same as the one of a sequential scan.
+	*/
+	std::vector<const uint8_t*> ScanParallel(const std::vector<Range>& ranges, ScanImpl impl, unsigned threads) const;
+	std::vector<const uint8_t*> ScanParallel(const std::vector<Range>& ranges) const;
+};
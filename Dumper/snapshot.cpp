@@ -0,0 +1,69 @@
+#include "snapshot.h"
+#include "platform.h"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+/*
+* Layout:
+* Header { char Magic[4]; uint32_t Version; uint64_t Base; uint64_t ModuleBase; uint64_t ModuleSize; uint64_t ImageSize; uint32_t GameSize; }
+* char Game[GameSize]
+* uint8_t Image[ImageSize]
+*/
+static constexpr char SnapshotMagic[4] = { 'U', 'S', 'N', 'P' };
+static constexpr uint32_t SnapshotVersion = 1;
+
+#pragma pack(push, 1)
+struct SnapshotHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint64_t Base;
+	uint64_t ModuleBase;
+	uint64_t ModuleSize;
+	uint64_t ImageSize;
+	uint32_t GameSize;
+};
+#pragma pack(pop)
+
+bool LoadSnapshot(const fs::path& path, Snapshot& snapshot)
+{
+	FILE* raw = nullptr;
+	fopen_s(&raw, path.string().c_str(), "rb");
+	if (!raw) { return false; }
+	std::unique_ptr<FILE, decltype(&fclose)> file(raw, &fclose);
+
+	SnapshotHeader header{};
+	if (fread(&header, sizeof(header), 1, file.get()) != 1) { return false; }
+	if (memcmp(header.Magic, SnapshotMagic, sizeof(SnapshotMagic)) || header.Version != SnapshotVersion) { return false; }
+	// Module has to be inside of the image, otherwise its headers can't be read
+	if (header.ModuleBase < header.Base || header.ModuleBase - header.Base > header.ImageSize || header.ModuleSize > header.ImageSize - (header.ModuleBase - header.Base)) { return false; }
+
+	Snapshot loaded{ header.Base, header.ModuleBase, header.ModuleSize };
+	loaded.Game.resize(header.GameSize);
+	if (header.GameSize && fread(loaded.Game.data(), header.GameSize, 1, file.get()) != 1) { return false; }
+	loaded.Image.resize(header.ImageSize);
+	if (header.ImageSize && fread(loaded.Image.data(), header.ImageSize, 1, file.get()) != 1) { return false; }
+	snapshot = std::move(loaded);
+	return true;
+}
+
+bool SaveSnapshot(const fs::path& path, const Snapshot& snapshot)
+{
+	FILE* file = nullptr;
+	fopen_s(&file, path.string().c_str(), "wb");
+	if (!file) { return false; }
+
+	SnapshotHeader header{};
+	memcpy(header.Magic, SnapshotMagic, sizeof(SnapshotMagic));
+	header.Version = SnapshotVersion;
+	header.Base = snapshot.Base;
+	header.ModuleBase = snapshot.ModuleBase;
+	header.ModuleSize = snapshot.ModuleSize;
+	header.ImageSize = snapshot.Image.size();
+	header.GameSize = static_cast<uint32_t>(snapshot.Game.size());
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+	if (written && header.GameSize) { written = fwrite(snapshot.Game.data(), header.GameSize, 1, file) == 1; }
+	if (written && header.ImageSize) { written = fwrite(snapshot.Image.data(), header.ImageSize, 1, file) == 1; }
+	return (fclose(file) == 0) && written;
+}
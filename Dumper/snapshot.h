@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/*
+* Image of process memory that is dumped later or on another machine, one contiguous range that starts at 'Base'.
+* It has to cover the game module and every object the dumper reaches from it, memory that wasn't readable is zeroed.
+*/
+struct Snapshot
+{
+	uint64_t Base = 0;
+	uint64_t ModuleBase = 0;
+	uint64_t ModuleSize = 0;
+	// Selects the engine profile like the process name does
+	std::string Game;
+	std::vector<uint8_t> Image;
+};
+
+// Fails if the file isn't a snapshot or was written by another version
+bool LoadSnapshot(const fs::path& path, Snapshot& snapshot);
+bool SaveSnapshot(const fs::path& path, const Snapshot& snapshot);
@@ -0,0 +1,125 @@
+#include "trace.h"
+#include "platform.h"
+#include <fmt/format.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct TraceEvent
+{
+	const char* Name;
+	std::string Detail;
+	int64_t Begin;
+	int64_t Duration;
+};
+
+// Events of one thread, owned by the trace so they outlive the thread
+struct TraceLane
+{
+	uint32_t Id;
+	std::string Name;
+	std::vector<TraceEvent> Events;
+};
+
+static std::atomic<bool> enabled = false;
+static std::chrono::steady_clock::time_point start;
+static std::mutex lanesLock;
+static std::vector<std::unique_ptr<TraceLane>> lanes;
+
+// Lane is created on the first event of the thread, the lock is only taken then
+static TraceLane& GetLane()
+{
+	thread_local TraceLane* lane = nullptr;
+	if (!lane)
+	{
+		std::lock_guard lock(lanesLock);
+		auto id = static_cast<uint32_t>(lanes.size() + 1);
+		lane = lanes.emplace_back(std::make_unique<TraceLane>(TraceLane{ id, fmt::format("Thread {}", id), {} })).get();
+	}
+	return *lane;
+}
+
+static int64_t Now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void EnableTrace()
+{
+	if (enabled) { return; }
+	start = std::chrono::steady_clock::now();
+	enabled = true;
+}
+
+bool TraceEnabled()
+{
+	return enabled.load(std::memory_order_relaxed);
+}
+
+void TraceThread(std::string name)
+{
+	if (!TraceEnabled()) { return; }
+	auto& lane = GetLane();
+	std::lock_guard lock(lanesLock);
+	lane.Name = std::move(name);
+}
+
+TraceScope::TraceScope(const char* name) : name(name)
+{
+	if (TraceEnabled()) { begin = Now(); }
+}
+
+TraceScope::~TraceScope()
+{
+	if (begin < 0) { return; }
+	auto end = Now();
+	GetLane().Events.push_back({ name, std::move(detail), begin, end - begin });
+}
+
+static void Escape(fmt::memory_buffer& buf, std::string_view text)
+{
+	for (auto c : text)
+	{
+		if (c == '"' || c == '\\') { buf.push_back('\\'); buf.push_back(c); }
+		else if (static_cast<unsigned char>(c) < 0x20) { fmt::format_to(buf, "\\u{:04x}", static_cast<int>(c)); }
+		else { buf.push_back(c); }
+	}
+}
+
+bool WriteTrace(const fs::path& path)
+{
+	fmt::memory_buffer buf;
+	{
+		// Events of running threads are only safe to read once they've stopped recording, so this is called at the end of a dump
+		std::lock_guard lock(lanesLock);
+		fmt::format_to(buf, "{{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		fmt::format_to(buf, "{{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{{\"name\":\"Dumper\"}}}}");
+		for (auto& lane : lanes)
+		{
+			fmt::format_to(buf, ",\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"", lane->Id);
+			Escape(buf, lane->Name);
+			fmt::format_to(buf, "\"}}}},\n{{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"sort_index\":{}}}}}", lane->Id, lane->Id);
+			for (auto& event : lane->Events)
+			{
+				fmt::format_to(buf, ",\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{},\"dur\":{}", event.Name, lane->Id, event.Begin, event.Duration);
+				if (event.Detail.size())
+				{
+					fmt::format_to(buf, ",\"args\":{{\"detail\":\"");
+					Escape(buf, event.Detail);
+					fmt::format_to(buf, "\"}}");
+				}
+				buf.push_back('}');
+			}
+		}
+		fmt::format_to(buf, "\n]}}\n");
+	}
+
+	FILE* file = nullptr;
+	fopen_s(&file, path.string().c_str(), "w");
+	if (!file) { return false; }
+	bool written = fwrite(buf.data(), 1, buf.size(), file) == buf.size();
+	return fclose(file) == 0 && written;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+/*
+* Timeline of a dump in Chrome trace format, it opens in Perfetto or chrome://tracing with a lane for every thread.
+* Events are recorded per thread without locks, nothing is recorded until tracing is enabled.
+*/
+
+// Starts recording, timestamps are relative to the first call
+void EnableTrace();
+bool TraceEnabled();
+// Names the lane of the calling thread
+void TraceThread(std::string name);
+// Writes every event recorded so far, threads that recorded them may have finished
+bool WriteTrace(const fs::path& path);
+
+// Records the time between construction and destruction as one event of the calling thread
+class TraceScope
+{
+private:
+	const char* name;
+	std::string detail;
+	int64_t begin = -1;
+public:
+	// 'name' must outlive the trace, it's expected to be a literal
+	TraceScope(const char* name);
+	~TraceScope();
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+	// False when tracing is off, so details that cost reads are only made for recorded events
+	explicit operator bool() const { return begin >= 0; }
+	// Shown in the arguments of the event, e.g. the package or the file
+	void Detail(std::string text) { detail = std::move(text); }
+};
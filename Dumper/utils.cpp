@@ -1,7 +1,13 @@
 #include "utils.h"
-#include <Psapi.h>
+#include "scanner.h"
+#include "memory.h"
 #include <string>
+#ifdef _WIN32
+#include <TlHelp32.h>
+#include <Psapi.h>
+#endif
 
+#ifdef _WIN32
 uint32_t GetProcessId(std::wstring name)
 {
     uint32_t pid = 0;
@@ -29,50 +35,43 @@ std::pair<byte*, uint32_t> GetModuleInfo(uint32_t pid, std::wstring name)
     }
     return info;
 }
+#else
+uint32_t GetProcessId(std::wstring name)
+{
+    return 0;
+}
 
-bool Compare(byte* data, byte* sig, size_t size) 
-{ 
-    for (size_t i = 0; i < size; i++) { if (data[i] != sig[i] && sig[i] != 0x00) { return false; } }
-    return true; 
+std::pair<byte*, uint32_t> GetModuleInfo(uint32_t pid, std::wstring name)
+{
+    return {};
 }
+#endif
 
-byte* FindSignature(byte* start, byte* end, byte* sig, size_t size) 
-{ 
-    for (byte* it = start; it < end - size; it++) { if (Compare(it, sig, size)) { return it; }; } 
-    return 0;
+std::vector<ImageSection> GetSections(byte* base, uint32_t required, uint32_t excluded)
+{
+    byte headers[ImageHeadersSize]{};
+    if (!Read(base, headers, sizeof(headers))) { return {}; }
+    return ParseSections(headers, sizeof(headers), required, excluded);
 }
 
-void* FindPointer(byte* start, byte* end, byte* sig, size_t size, int32_t addition)
+std::vector<ImageSection> GetExSections(byte* base)
 {
-    byte* address = FindSignature(start, end, sig, size);
-    if (!address) return nullptr;
-    int32_t k = 0;
-    for (; sig[k]; k++);
-    int32_t offset = *reinterpret_cast<int32_t*>(address + k);
-    return address + k + 4 + offset + addition;
+    return GetSections(base, SectionCode, 0);
 }
 
-std::vector<std::pair<byte*, byte*>> GetExSections(byte* data)
+std::vector<ImageSection> GetDataSections(byte* base)
 {
-    std::vector<std::pair<byte*, byte*>> sections;
-    PIMAGE_DOS_HEADER dos = reinterpret_cast<PIMAGE_DOS_HEADER>(data);
-    PIMAGE_NT_HEADERS nt = reinterpret_cast<PIMAGE_NT_HEADERS>(data + dos->e_lfanew);
-    auto s = IMAGE_FIRST_SECTION(nt);
-    for (auto i = 0u; i < nt->FileHeader.NumberOfSections; i++, s++) {
-        if (s->Characteristics & IMAGE_SCN_CNT_CODE)
-        {
-            auto start = data + s->PointerToRawData;
-            auto end = start + s->SizeOfRawData;
-            sections.push_back({ start, end });
-        }
-    }
-    return sections;
+    return GetSections(base, SectionWrite, SectionCode);
 }
 
 uint32_t GetProccessPath(uint32_t pid, wchar_t* processName, uint32_t size)
 {
+#ifdef _WIN32
     HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, 0, pid);
     if (!QueryFullProcessImageNameW(hProcess, 0, processName, reinterpret_cast<DWORD*>(&size))) { size = 0; };
     CloseHandle(hProcess);
     return size;
+#else
+    return 0;
+#endif
 }
\ No newline at end of file
@@ -1,15 +1,23 @@
 #pragma once
-#include <Windows.h>
-#include <TlHelp32.h>
 #include <cstdint>
 #include <vector>
 #include <string>
-#undef GetObject
+#include "scanner.h"
+#include "pe.h"
+#include "platform.h"
 
+// Processes are found and attached only on Windows, elsewhere these find nothing and the dumper reads images and snapshots
 uint32_t GetProcessId(std::wstring name);
 std::pair<byte*, uint32_t> GetModuleInfo(uint32_t pid, std::wstring name);
-bool Compare(byte* data, byte* sig, size_t size);
-byte* FindSignature(byte* start, byte* end, byte* sig, size_t size);
-void* FindPointer(byte* start, byte* end, byte* sig, size_t size, int32_t addition = 0);
-std::vector<std::pair<byte*, byte*>> GetExSections(byte* data);
+// Reads PE headers of the module loaded at 'base' in the target process and gets sections that have all 'required' characteristics and none of 'excluded'
+std::vector<ImageSection> GetSections(byte* base, uint32_t required, uint32_t excluded);
+std::vector<ImageSection> GetExSections(byte* base);
+// Writable sections that don't contain code, that's where engine globals live
+std::vector<ImageSection> GetDataSections(byte* base);
+// Checks that value looks like an aligned pointer into user space of a 64-bit process
+inline bool IsPointer(const void* ptr)
+{
+    auto value = reinterpret_cast<uint64_t>(ptr);
+    return value >= 0x10000 && value < 0x7FFFFFFFFFFF && !(value & 7);
+}
 uint32_t GetProccessPath(uint32_t pid, wchar_t* processName, uint32_t size);
\ No newline at end of file
@@ -1,16 +1,44 @@
 #include "wrappers.h"
 #include <algorithm>
-#include <fmt/core.h>
+#include <fmt/format.h>
 #include "memory.h"
+#include "trace.h"
+#include "database.h"
 
 std::pair<bool, uint16_t> UE_FNameEntry::Info() const
 {
-	auto info = Read<uint16_t>(object + defs.FNameEntry.InfoOffset);
+	auto info = Read<uint16_t>(object + defs.FNameEntry.InfoOffset, ReadTag::Name);
 	auto len = info >> defs.FNameEntry.LenBitOffset;
 	bool wide = (info >> defs.FNameEntry.WideBitOffset) & 1;
 	return { wide, len };
 }
 
+// Converts UTF-16 entries of the name pool the same way on every platform, 'wchar_t' isn't 2 bytes everywhere
+static bool ToUtf8(const char16_t* str, size_t len, char* buf, size_t size)
+{
+	size_t out = 0;
+	for (size_t i = 0; i < len; i++)
+	{
+		uint32_t c = str[i];
+		if (c >= 0xD800 && c < 0xDC00 && i + 1 < len && str[i + 1] >= 0xDC00 && str[i + 1] < 0xE000)
+		{
+			c = 0x10000 + ((c - 0xD800) << 10) + (str[++i] - 0xDC00);
+		}
+		char units[4];
+		size_t count = 0;
+		if (c < 0x80) { units[count++] = static_cast<char>(c); }
+		else if (c < 0x800) { units[count++] = static_cast<char>(0xC0 | c >> 6); }
+		else if (c < 0x10000) { units[count++] = static_cast<char>(0xE0 | c >> 12); }
+		else { units[count++] = static_cast<char>(0xF0 | c >> 18); }
+		if (c >= 0x10000) { units[count++] = static_cast<char>(0x80 | (c >> 12 & 0x3F)); }
+		if (c >= 0x800) { units[count++] = static_cast<char>(0x80 | (c >> 6 & 0x3F)); }
+		if (c >= 0x80) { units[count++] = static_cast<char>(0x80 | (c & 0x3F)); }
+		if (out + count > size) { return false; }
+		for (size_t j = 0; j < count; j++) { buf[out++] = units[j]; }
+	}
+	return true;
+}
+
 std::string UE_FNameEntry::String(bool wide, uint16_t len) const
 {
 	std::string name("\x0", len);
@@ -22,30 +50,29 @@ void UE_FNameEntry::String(char* buf, bool wide, uint16_t len) const
 {
 	if (wide)
 	{
-		wchar_t wbuf[1024]{};
-		Read(object + defs.FNameEntry.HeaderSize, wbuf, len * 2ull);
-		auto copied = WideCharToMultiByte(CP_UTF8, 0, wbuf, len, buf, len, 0, 0);
-		if (copied == 0) { buf[0] = '\x0'; }
+		char16_t wbuf[1024]{};
+		Read(object + defs.FNameEntry.HeaderSize, wbuf, len * 2ull, ReadTag::Name);
+		if (!ToUtf8(wbuf, len, buf, len)) { buf[0] = '\x0'; }
 	}
 	else
 	{
-		Read(object + defs.FNameEntry.HeaderSize, buf, len);
+		Read(object + defs.FNameEntry.HeaderSize, buf, len, ReadTag::Name);
 	}
 }
 
 uint16_t UE_FNameEntry::Size(bool wide, uint16_t len)
 {
-	uint16_t bytes = defs.FNameEntry.HeaderSize + len * (wide ? sizeof(wchar_t) : sizeof(char));
+	uint16_t bytes = defs.FNameEntry.HeaderSize + len * (wide ? sizeof(char16_t) : sizeof(char));
 	return (bytes + defs.Stride - 1u) & ~(defs.Stride - 1u);
 }
 
 std::string UE_FName::GetName() const
 {
-	uint32_t index = Read<uint32_t>(object + defs.FName.ComparisonIndex);
+	uint32_t index = Read<uint32_t>(object + defs.FName.ComparisonIndex, ReadTag::Name);
 	auto entry = UE_FNameEntry(NamePoolData.GetEntry(index));
 	auto [wide, len] = entry.Info();
 	auto name = entry.String(wide, len);
-	uint32_t number = Read<uint32_t>(object + defs.FName.Number);
+	uint32_t number = Read<uint32_t>(object + defs.FName.Number, ReadTag::Name);
 	if (number > 0)
 	{
 		name += '_' + std::to_string(number);
@@ -60,17 +87,17 @@ std::string UE_FName::GetName() const
 
 uint32_t UE_UObject::GetIndex() const
 {
-	return Read<uint32_t>(object + defs.UObject.Index);
+	return Read<uint32_t>(object + defs.UObject.Index, ReadTag::Object);
 };
 
 UE_UClass UE_UObject::GetClass() const
 {
-	return Read<UE_UClass>(object + defs.UObject.Class);
+	return Read<UE_UClass>(object + defs.UObject.Class, ReadTag::Object);
 }
 
 UE_UObject UE_UObject::GetOuter() const
 {
-	return Read<UE_UObject>(object + defs.UObject.Outer);
+	return Read<UE_UObject>(object + defs.UObject.Outer, ReadTag::Object);
 }
 
 UE_UObject UE_UObject::GetPackageObject() const
@@ -103,7 +130,7 @@ std::string UE_UObject::GetFullName() const
 
 std::string UE_UObject::GetCppName() const
 {
-	static auto ActorClass = ObjObjects.FindObject("Class Engine.Actor");
+	auto ActorClass = GetActorClass();
 	std::string name;
 	if (this->IsA<UE_UClass>())
 	{
@@ -130,131 +157,175 @@ std::string UE_UObject::GetCppName() const
 	return name;
 }
 
+thread_local CoreClasses Classes;
+
+const CoreClasses& GetClasses()
+{
+	if (Classes.Resolved) { return Classes; }
+	Classes.Resolved = true;
+	std::pair<const char*, UE_UClass*> wanted[] =
+	{
+		{ "Class CoreUObject.Object", &Classes.Object },
+		{ "Class CoreUObject.Field", &Classes.Field },
+		{ "Class CoreUObject.Struct", &Classes.Struct },
+		{ "Class CoreUObject.Function", &Classes.Function },
+		{ "Class CoreUObject.ScriptStruct", &Classes.ScriptStruct },
+		{ "Class CoreUObject.Class", &Classes.Class },
+		{ "Class CoreUObject.Enum", &Classes.Enum },
+	};
+	// They're among the first objects, so the pass stops early
+	auto left = std::size(wanted);
+	for (auto i = 0u; i < ObjObjects.NumElements && left; i++)
+	{
+		UE_UObject object = ObjObjects.GetObjectPtr(i);
+		if (!object) { continue; }
+		auto name = object.GetFullName();
+		for (auto& [fullName, found] : wanted)
+		{
+			if (!*found && name == fullName) { *found = object.Cast<UE_UClass>(); left--; }
+		}
+	}
+	return Classes;
+}
+
+UE_UClass GetActorClass()
+{
+	if (!Classes.Actor) { Classes.Actor = ObjObjects.FindObject("Class Engine.Actor"); }
+	return *Classes.Actor;
+}
+
 UE_UClass UE_UObject::StaticClass()
 {
-	static auto obj = ObjObjects.FindObject("Class CoreUObject.Object");
-	return obj;
+	return GetClasses().Object;
 };
 
 UE_UField UE_UField::GetNext() const
 {
-	return Read<UE_UField>(object + defs.UField.Next);
+	return Read<UE_UField>(object + defs.UField.Next, ReadTag::Object);
 }
 
 UE_UClass UE_UField::StaticClass()
 {
-	static auto obj = ObjObjects.FindObject("Class CoreUObject.Field");
-	return obj;
+	return GetClasses().Field;
 };
 
 UE_UClass UE_UProperty::StaticClass()
 {
-	static auto obj = ObjObjects.FindObject("Class CoreUObject.Property");
-	return obj;
+	if (!Classes.Property) { Classes.Property = ObjObjects.FindObject("Class CoreUObject.Property"); }
+	return *Classes.Property;
 }
 
 UE_UStruct UE_UStruct::GetSuper() const
 {
-	return Read<UE_UStruct>(object + defs.UStruct.SuperStruct);
+	return Read<UE_UStruct>(object + defs.UStruct.SuperStruct, ReadTag::Object);
 }
 
 UE_FField UE_UStruct::GetChildProperties() const
 {
-	return Read<UE_FField>(object + defs.UStruct.ChildProperties);
+	return Read<UE_FField>(object + defs.UStruct.ChildProperties, ReadTag::Object);
 }
 
 UE_UField UE_UStruct::GetChildren() const
 {
-	return Read<UE_UField>(object + defs.UStruct.Children);
+	return Read<UE_UField>(object + defs.UStruct.Children, ReadTag::Object);
 }
 
 int32_t UE_UStruct::GetSize() const
 {
-	return Read<int32_t>(object + defs.UStruct.PropertiesSize);
+	return Read<int32_t>(object + defs.UStruct.PropertiesSize, ReadTag::Object);
 };
 
 UE_UClass UE_UStruct::StaticClass()
 {
-	static auto obj = ObjObjects.FindObject("Class CoreUObject.Struct");
-	return obj;
+	return GetClasses().Struct;
 };
 
 UE_UClass UE_UFunction::StaticClass()
 {
-	static auto obj = ObjObjects.FindObject("Class CoreUObject.Function");
-	return obj;
+	return GetClasses().Function;
 }
 size_t UE_UFunction::GetFunctionPtr() const
 {
-	return Read<size_t>(object + defs.UFunction.FuncPtr);
+	return Read<size_t>(object + defs.UFunction.FuncPtr, ReadTag::Function);
 };
 UEFunctionFlags UE_UFunction::GetFunctionFlags() const
 {
-	return Read<UEFunctionFlags>(object + defs.UFunction.Flags);
+	return Read<UEFunctionFlags>(object + defs.UFunction.Flags, ReadTag::Function);
 };
+static const std::pair<UEFunctionFlags, std::string_view> FunctionFlagNames[] =
+{
+	{ UEFunctionFlags::Final, "Final" },
+	{ UEFunctionFlags::RequiredAPI, "RequiredAPI" },
+	{ UEFunctionFlags::BlueprintAuthorityOnly, "BlueprintAuthorityOnly" },
+	{ UEFunctionFlags::BlueprintCosmetic, "BlueprintCosmetic" },
+	{ UEFunctionFlags::Net, "Net" },
+	{ UEFunctionFlags::NetReliable, "NetReliable" },
+	{ UEFunctionFlags::NetRequest, "NetRequest" },
+	{ UEFunctionFlags::Exec, "Exec" },
+	{ UEFunctionFlags::Native, "Native" },
+	{ UEFunctionFlags::Event, "Event" },
+	{ UEFunctionFlags::NetResponse, "NetResponse" },
+	{ UEFunctionFlags::Static, "Static" },
+	{ UEFunctionFlags::NetMulticast, "NetMulticast" },
+	{ UEFunctionFlags::MulticastDelegate, "MulticastDelegate" },
+	{ UEFunctionFlags::Public, "Public" },
+	{ UEFunctionFlags::Private, "Private" },
+	{ UEFunctionFlags::Protected, "Protected" },
+	{ UEFunctionFlags::Delegate, "Delegate" },
+	{ UEFunctionFlags::NetServer, "NetServer" },
+	{ UEFunctionFlags::HasOutParms, "HasOutParms" },
+	{ UEFunctionFlags::HasDefaults, "HasDefaults" },
+	{ UEFunctionFlags::NetClient, "NetClient" },
+	{ UEFunctionFlags::DLLImport, "DLLImport" },
+	{ UEFunctionFlags::BlueprintCallable, "BlueprintCallable" },
+	{ UEFunctionFlags::BlueprintEvent, "BlueprintEvent" },
+	{ UEFunctionFlags::BlueprintPure, "BlueprintPure" },
+	{ UEFunctionFlags::Const, "Const" },
+	{ UEFunctionFlags::NetValidate, "NetValidate" },
+};
+
 std::string UE_UFunction::GetFlagsStringified(UEFunctionFlags flags) const 
 {
 	std::string result;
-	auto append = [&result](std::string addend) mutable {
-		if (result.length() > 1)
-			result = result + "|" + addend;
-		else
-			result = result + addend;
-	};
-
-	if (flags & UEFunctionFlags::Final) { append("Final"); }
-	if (flags & UEFunctionFlags::RequiredAPI) { append("RequiredAPI"); }
-	if (flags & UEFunctionFlags::BlueprintAuthorityOnly) { append("BlueprintAuthorityOnly"); }
-	if (flags & UEFunctionFlags::BlueprintCosmetic) { append("BlueprintCosmetic"); }
-	if (flags & UEFunctionFlags::Net) { append("Net"); }
-	if (flags & UEFunctionFlags::NetReliable) { append("NetReliable"); }
-	if (flags & UEFunctionFlags::NetRequest) { append("NetRequest"); }
-	if (flags & UEFunctionFlags::Exec) { append("Exec"); }
-	if (flags & UEFunctionFlags::Native) { append("Native"); }
-	if (flags & UEFunctionFlags::Event) { append("Event"); }
-	if (flags & UEFunctionFlags::NetResponse) { append("NetResponse"); }
-	if (flags & UEFunctionFlags::Static) { append("Static"); }
-	if (flags & UEFunctionFlags::NetMulticast) { append("NetMulticast"); }
-	if (flags & UEFunctionFlags::MulticastDelegate) { append("MulticastDelegate"); }
-	if (flags & UEFunctionFlags::Public) { append("Public"); }
-	if (flags & UEFunctionFlags::Private) { append("Private"); }
-	if (flags & UEFunctionFlags::Protected) { append("Protected"); }
-	if (flags & UEFunctionFlags::Delegate) { append("Delegate"); }
-	if (flags & UEFunctionFlags::NetServer) { append("NetServer"); }
-	if (flags & UEFunctionFlags::HasOutParms) { append("HasOutParms"); }
-	if (flags & UEFunctionFlags::HasDefaults) { append("HasDefaults"); }
-	if (flags & UEFunctionFlags::NetClient) { append("NetClient"); }
-	if (flags & UEFunctionFlags::DLLImport) { append("DLLImport"); }
-	if (flags & UEFunctionFlags::BlueprintCallable) { append("BlueprintCallable"); }
-	if (flags & UEFunctionFlags::BlueprintEvent) { append("BlueprintEvent"); }
-	if (flags & UEFunctionFlags::BlueprintPure) { append("BlueprintPure"); }
-	if (flags & UEFunctionFlags::Const) { append("Const"); }
-	if (flags & UEFunctionFlags::NetValidate) { append("NetValidate"); }
-
+	for (auto& [flag, name] : FunctionFlagNames)
+	{
+		if (!(flags & flag)) { continue; }
+		if (result.size()) { result += '|'; }
+		result += name;
+	}
 	return result;
 };
 
+void UE_UFunction::AppendFlags(WriteBuffer& buf, UEFunctionFlags flags)
+{
+	bool first = true;
+	for (auto& [flag, name] : FunctionFlagNames)
+	{
+		if (!(flags & flag)) { continue; }
+		if (!first) { buf.push_back('|'); }
+		buf.append(name.data(), name.data() + name.size());
+		first = false;
+	}
+}
+
 UE_UClass UE_UScriptStruct::StaticClass()
 {
-	static auto obj = ObjObjects.FindObject("Class CoreUObject.ScriptStruct");
-	return obj;
+	return GetClasses().ScriptStruct;
 };
 
 UE_UClass UE_UClass::StaticClass()
 {
-	static auto obj = ObjObjects.FindObject("Class CoreUObject.Class");
-	return obj;
+	return GetClasses().Class;
 };
 
 TArray UE_UEnum::GetNames() const
 {
-	return Read<TArray>(object + defs.UEnum.Names);
+	return Read<TArray>(object + defs.UEnum.Names, ReadTag::Enum);
 }
 
 UE_UClass UE_UEnum::StaticClass()
 {
-	static auto obj = ObjObjects.FindObject("Class CoreUObject.Enum");
-	return obj;
+	return GetClasses().Enum;
 }
 
 std::string UE_FFieldClass::GetName() const
@@ -265,9 +336,14 @@ std::string UE_FFieldClass::GetName() const
 
 UE_FField UE_FField::GetNext() const
 {
-	return Read<UE_FField>(object + defs.FField.Next);
+	return Read<UE_FField>(object + defs.FField.Next, ReadTag::Property);
 };
 
+UE_FFieldClass UE_FField::GetClass() const
+{
+	return Read<UE_FFieldClass>(object + defs.FField.Class, ReadTag::Property);
+}
+
 std::string UE_FField::GetName() const
 {
 	auto name = UE_FName(object + defs.FField.Name);
@@ -276,29 +352,29 @@ std::string UE_FField::GetName() const
 
 int32_t UE_FProperty::GetArrayDim() const
 {
-	return Read<int32_t>(object + defs.FProperty.ArrayDim);
+	return Read<int32_t>(object + defs.FProperty.ArrayDim, ReadTag::Property);
 }
 
 int32_t UE_FProperty::GetSize() const
 {
-	return Read<int32_t>(object + defs.FProperty.ElementSize);
+	return Read<int32_t>(object + defs.FProperty.ElementSize, ReadTag::Property);
 }
 
 int32_t UE_FProperty::GetOffset() const
 {
-	return Read<int32_t>(object + defs.FProperty.Offset);
+	return Read<int32_t>(object + defs.FProperty.Offset, ReadTag::Property);
 }
 
 uint64_t UE_FProperty::GetPropertyFlags() const
 {
-	return Read<uint64_t>(object + defs.FProperty.PropertyFlags);
+	return Read<uint64_t>(object + defs.FProperty.PropertyFlags, ReadTag::Property);
 }
 
 std::pair<PropertyType, std::string> UE_FProperty::GetType() const
 {
 	using namespace std;
 
-	auto objectClass = Read<UE_FFieldClass>(object + defs.FField.Class);
+	auto objectClass = Read<UE_FFieldClass>(object + defs.FField.Class, ReadTag::Property);
 	pair<PropertyType, string> type = { PropertyType::Unknown,  objectClass.GetName() };
 
 	static unordered_map<string, function<void(decltype(this), pair<PropertyType, string>&)>> types =
@@ -466,7 +542,7 @@ std::pair<PropertyType, std::string> UE_FProperty::GetType() const
 		{
 			"MulticastInlineDelegateProperty",
 			[](decltype(this) prop, pair<PropertyType, string>& type) {
-				type = { PropertyType::MulticastDelegateProperty, "struct FMulticastInlineDelegate" };
+				type = { PropertyType::MulticastInlineDelegateProperty, "struct FMulticastInlineDelegate" };
 			}
 		},
 		{
@@ -481,21 +557,22 @@ std::pair<PropertyType, std::string> UE_FProperty::GetType() const
 			"InterfaceProperty",
 			[](decltype(this) prop, pair<PropertyType, string>& type) {
 				auto obj = prop->Cast<UE_FInterfaceProperty>();
-				type = { PropertyType::MapProperty, obj.GetType() };
+				type = { PropertyType::InterfaceProperty, obj.GetType() };
 			}
 		}
 	};
 
-	auto& fn = types[type.second];
+	// 'find' instead of 'operator[]' so the shared table is never modified by generator threads
+	auto fn = types.find(type.second);
 
-	if (fn) { fn(this, type); }
+	if (fn != types.end()) { fn->second(this, type); }
 
 	return type;
 }
 
 UE_UStruct UE_FStructProperty::GetStruct() const
 {
-	return Read<UE_UStruct>(object + defs.FStructProperty.Struct);
+	return Read<UE_UStruct>(object + defs.FStructProperty.Struct, ReadTag::Property);
 }
 
 std::string UE_FStructProperty::GetType() const
@@ -505,7 +582,7 @@ std::string UE_FStructProperty::GetType() const
 
 UE_UClass UE_FObjectPropertyBase::GetPropertyClass() const
 {
-	return Read<UE_UClass>(object + defs.FObjectPropertyBase.PropertyClass);
+	return Read<UE_UClass>(object + defs.FObjectPropertyBase.PropertyClass, ReadTag::Property);
 }
 
 std::string UE_FObjectPropertyBase::GetType() const
@@ -515,7 +592,7 @@ std::string UE_FObjectPropertyBase::GetType() const
 
 UE_FProperty UE_FArrayProperty::GetInner() const
 {
-	return Read<UE_FProperty>(object + defs.FArrayProperty.Inner);
+	return Read<UE_FProperty>(object + defs.FArrayProperty.Inner, ReadTag::Property);
 }
 
 std::string UE_FArrayProperty::GetType() const
@@ -525,17 +602,17 @@ std::string UE_FArrayProperty::GetType() const
 
 uint8_t UE_FBoolProperty::GetFieldSize() const
 {
-	return Read<uint8_t>(object + defs.FBoolProperty.FieldSize);
+	return Read<uint8_t>(object + defs.FBoolProperty.FieldSize, ReadTag::Property);
 }
 
 uint8_t UE_FBoolProperty::GetByteOffset() const
 {
-	return Read<uint8_t>(object + defs.FBoolProperty.ByteOffset);
+	return Read<uint8_t>(object + defs.FBoolProperty.ByteOffset, ReadTag::Property);
 }
 
 uint8_t UE_FBoolProperty::GetFieldMask() const
 {
-	return Read<uint8_t>(object + defs.FBoolProperty.FieldMask);
+	return Read<uint8_t>(object + defs.FBoolProperty.FieldMask, ReadTag::Property);
 }
 
 std::string UE_FBoolProperty::GetType() const
@@ -546,7 +623,7 @@ std::string UE_FBoolProperty::GetType() const
 
 UE_UClass UE_FEnumProperty::GetEnum() const
 {
-	return Read<UE_UClass>(object + defs.FEnumProperty.Enum);
+	return Read<UE_UClass>(object + defs.FEnumProperty.Enum, ReadTag::Property);
 }
 
 std::string UE_FEnumProperty::GetType() const
@@ -556,7 +633,7 @@ std::string UE_FEnumProperty::GetType() const
 
 UE_UClass UE_FClassProperty::GetMetaClass() const
 {
-	return Read<UE_UClass>(object + defs.FClassProperty.MetaClass);
+	return Read<UE_UClass>(object + defs.FClassProperty.MetaClass, ReadTag::Property);
 }
 
 std::string UE_FClassProperty::GetType() const
@@ -566,7 +643,7 @@ std::string UE_FClassProperty::GetType() const
 
 UE_FProperty UE_FSetProperty::GetElementProp() const
 {
-	return Read<UE_FProperty>(object + defs.FSetProperty.ElementProp);
+	return Read<UE_FProperty>(object + defs.FSetProperty.ElementProp, ReadTag::Property);
 }
 
 std::string UE_FSetProperty::GetType() const
@@ -576,12 +653,12 @@ std::string UE_FSetProperty::GetType() const
 
 UE_FProperty UE_FMapProperty::GetKeyProp() const
 {
-	return Read<UE_FProperty>(object + defs.FMapProperty.KeyProp);
+	return Read<UE_FProperty>(object + defs.FMapProperty.KeyProp, ReadTag::Property);
 }
 
 UE_FProperty UE_FMapProperty::GetValueProp() const
 {
-	return Read<UE_FProperty>(object + defs.FMapProperty.ValueProp);
+	return Read<UE_FProperty>(object + defs.FMapProperty.ValueProp, ReadTag::Property);
 }
 
 std::string UE_FMapProperty::GetType() const
@@ -591,7 +668,7 @@ std::string UE_FMapProperty::GetType() const
 
 UE_FProperty UE_FInterfaceProperty::GetInterfaceClass() const
 {
-	return Read<UE_FProperty>(object + defs.FInterfaceProperty.InterfaceClass);
+	return Read<UE_FProperty>(object + defs.FInterfaceProperty.InterfaceClass, ReadTag::Property);
 }
 
 std::string UE_FInterfaceProperty::GetType() const
@@ -599,47 +676,112 @@ std::string UE_FInterfaceProperty::GetType() const
 	return "struct TScriptInterface<" + GetInterfaceClass().GetType().second + ">";
 }
 
-void UE_UPackage::GenerateBitPadding(std::vector<Member>& members, int32_t offset, int16_t bitOffset, int16_t size)
+std::pmr::memory_resource* UE_UPackage::GetArenaUpstream()
+{
+	static thread_local std::pmr::unsynchronized_pool_resource pool({ 0, 16 * 1024 * 1024 });
+	return &pool;
+}
+
+std::string_view UE_UPackage::AddString(std::string_view str)
+{
+	auto data = static_cast<char*>(Arena.allocate(str.size(), alignof(char)));
+	std::copy(str.begin(), str.end(), data);
+	return std::string_view(data, str.size());
+}
+
+std::string_view UE_UPackage::AddType(std::string_view type)
+{
+	auto it = Types.find(type);
+	if (it != Types.end()) { return it->second; }
+	auto ref = AddString(type);
+	Types.emplace(ref, ref);
+	return ref;
+}
+
+static_assert(static_cast<uint8_t>(PropertyType::InterfaceProperty) == ReflectionInterfaceProperty, "property kinds of the database follow 'PropertyType'");
+
+uint32_t UE_UPackage::AddPropertyType(UE_FProperty prop, const std::pair<PropertyType, std::string>& type, int depth)
+{
+	auto text = AddType(type.second);
+	// Bytes and bit fields are both 'char', so the kind has to match as well
+	auto it = PropertyTypeIds.find(text);
+	if (it != PropertyTypeIds.end() && PropertyTypes[it->second].Kind == type.first) { return it->second; }
+
+	PropertyTypeRef ref;
+	ref.Kind = type.first;
+	ref.Text = text;
+	auto referenced = [&ref](UE_UObject object) { if (object) { ref.RefHash = ReflectionHash(object.GetFullName()); } };
+	// Broken inner properties can't recurse forever
+	auto inner = [this, depth](UE_FProperty inner) { return inner && depth < 8 ? AddPropertyType(inner, inner.GetType(), depth + 1) : ReflectionNone; };
+	switch (type.first)
+	{
+	case PropertyType::StructProperty: { referenced(prop.Cast<UE_FStructProperty>().GetStruct()); break; }
+	case PropertyType::ObjectProperty:
+	case PropertyType::SoftObjectProperty: { referenced(prop.Cast<UE_FObjectPropertyBase>().GetPropertyClass()); break; }
+	case PropertyType::ClassProperty: { referenced(prop.Cast<UE_FClassProperty>().GetMetaClass()); break; }
+	case PropertyType::EnumProperty: { referenced(prop.Cast<UE_FEnumProperty>().GetEnum()); break; }
+	case PropertyType::ArrayProperty: { ref.Inner = inner(prop.Cast<UE_FArrayProperty>().GetInner()); break; }
+	case PropertyType::SetProperty: { ref.Inner = inner(prop.Cast<UE_FSetProperty>().GetElementProp()); break; }
+	case PropertyType::MapProperty:
+	{
+		auto map = prop.Cast<UE_FMapProperty>();
+		ref.Inner = inner(map.GetKeyProp());
+		ref.Value = inner(map.GetValueProp());
+		break;
+	}
+	default: { break; }
+	}
+
+	auto index = static_cast<uint32_t>(PropertyTypes.size());
+	PropertyTypes.push_back(ref);
+	PropertyTypeIds.try_emplace(text, index);
+	return index;
+}
+
+void UE_UPackage::GenerateBitPadding(int32_t offset, int32_t bitOffset, int32_t size)
 {
 	Member padding;
-	padding.Name = fmt::format("char UnknownData_{:0X}_{} : {}", offset, bitOffset, size);
+	padding.Kind = MemberKind::BitPadding;
 	padding.Offset = offset;
 	padding.Size = 1;
-	members.push_back(padding);
+	padding.BitOffset = static_cast<uint8_t>(bitOffset);
+	padding.BitSize = static_cast<uint8_t>(size);
+	Members.push_back(padding);
 }
 
-void UE_UPackage::GeneratePadding(std::vector<Member>& members, int32_t& minOffset, int32_t& bitOffset, int32_t maxOffset)
+void UE_UPackage::GeneratePadding(int32_t& minOffset, int32_t& bitOffset, int32_t maxOffset)
 {
 	if (bitOffset)
 	{
-		if (bitOffset < 7) { UE_UPackage::GenerateBitPadding(members, minOffset, bitOffset, 8 - bitOffset); }
+		if (bitOffset < 7) { GenerateBitPadding(minOffset, bitOffset, 8 - bitOffset); }
 		bitOffset = 0; minOffset++;
 	}
 	if (maxOffset > minOffset)
 	{
 		Member padding;
-		auto size = maxOffset - minOffset;
-		padding.Name = fmt::format("char UnknownData_{:0X}[{:#0x}]", minOffset, size);
+		padding.Kind = MemberKind::Padding;
 		padding.Offset = minOffset;
-		padding.Size = size;
-		members.push_back(padding);
+		padding.Size = maxOffset - minOffset;
+		Members.push_back(padding);
 		minOffset = maxOffset;
 	}
 }
 
-void UE_UPackage::GenerateStruct(UE_UStruct object, std::vector<Struct>& arr)
+void UE_UPackage::GenerateStruct(UE_UStruct object, std::pmr::vector<Struct>& arr)
 {
 	Struct s;
 	s.Size = object.GetSize();
 	if (s.Size == 0) { return; }
 	s.Inherited = 0;
-	s.FullName = object.GetFullName();
-	s.CppName = "struct " + object.GetCppName();
+	s.FullName = AddString(object.GetFullName());
+	s.CppName = AddString(object.GetCppName());
+	s.MembersBegin = static_cast<uint32_t>(Members.size());
 
 	auto super = object.GetSuper();
 	if (super)
 	{
-		s.CppName += " : " + super.GetCppName();
+		s.SuperName = AddString(super.GetCppName());
+		s.SuperHash = ReflectionHash(super.GetFullName());
 		s.Inherited = super.GetSize();
 	}
 
@@ -650,15 +792,20 @@ void UE_UPackage::GenerateStruct(UE_UStruct object, std::vector<Struct>& arr)
 		auto arrDim = prop.GetArrayDim();
 		Member m;
 		m.Size = prop.GetSize() * arrDim;
-		if (m.Size == 0) { return; }
+		// Struct is skipped entirely, so drop members that were already generated for it
+		if (m.Size == 0) { Members.resize(s.MembersBegin); return; }
 
 		auto type = prop.GetType();
-		m.Name = type.second + " " + prop.GetName();
+		m.Type = AddType(type.second);
+		m.TypeIndex = AddPropertyType(prop, type);
+		m.Flags = prop.GetPropertyFlags();
+		m.Name = AddString(prop.GetName());
 		m.Offset = prop.GetOffset();
+		m.ArrayDim = arrDim;
 
 		if (m.Offset > offset)
 		{
-			UE_UPackage::GeneratePadding(s.Members, offset, bitOffset, m.Offset);
+			GeneratePadding(offset, bitOffset, m.Offset);
 		}
 
 		if (type.first == PropertyType::BoolProperty && type.second != "bool")
@@ -670,90 +817,85 @@ void UE_UPackage::GenerateStruct(UE_UStruct object, std::vector<Struct>& arr)
 			while (mask & 1) { mask >>= 1; ones++; }
 			if (zeros > bitOffset)
 			{
-				UE_UPackage::GenerateBitPadding(s.Members, offset, bitOffset, zeros - bitOffset);
+				GenerateBitPadding(offset, bitOffset, zeros - bitOffset);
 				bitOffset = zeros;
 			}
-			m.Name += fmt::format(" : {}", ones);
+			m.Kind = MemberKind::BitField;
+			m.BitOffset = zeros;
+			m.BitSize = ones;
 			bitOffset += ones;
 		}
 		else {
-
-			if (arrDim > 1)
-			{
-				m.Name += fmt::format("[{:#0x}]", arrDim);
-			}
-
 			offset += m.Size;
 		}
-		s.Members.push_back(m);
+		Members.push_back(m);
 	}
 
 	if (s.Size > offset)
 	{
-		UE_UPackage::GeneratePadding(s.Members, offset, bitOffset, s.Size);
+		GeneratePadding(offset, bitOffset, s.Size);
 	}
 
+	s.MembersEnd = static_cast<uint32_t>(Members.size());
+	s.FunctionsBegin = static_cast<uint32_t>(Functions.size());
+
 	for (auto fn = object.GetChildren().Cast<UE_UFunction>(); fn; fn = fn.GetNext().Cast<UE_UFunction>())
 	{
 		if (fn.IsA<UE_UFunction>())
 		{
 			Function f;
-			f.FullName = fn.GetFullName();
-
-			auto flags = fn.GetFunctionFlags();
-			f.Flags = (uint32_t)flags;
-			f.FlagsString = fn.GetFlagsStringified(flags);
+			f.FullName = AddString(fn.GetFullName());
+			f.Name = AddString(fn.GetName());
+			f.Flags = (uint32_t)fn.GetFunctionFlags();
 			f.FuncPtr = fn.GetFunctionPtr();
+			f.ParamsBegin = static_cast<uint32_t>(Params.size());
 
 			for (auto prop = fn.GetChildProperties().Cast<UE_FProperty>(); prop; prop = prop.GetNext().Cast<UE_FProperty>())
 			{
 				auto flags = prop.GetPropertyFlags();
 				if (flags & 0x400) // if property has 'ReturnParm' flag
 				{
-					f.CppName = prop.GetType().second + " " + fn.GetName();
+					auto type = prop.GetType();
+					f.ReturnType = AddType(type.second);
+					f.ReturnTypeIndex = AddPropertyType(prop, type);
 				}
 				else if (flags & 0x80) // if property has 'Parm' flag
 				{
-					if (prop.GetArrayDim() > 1)
-					{
-						f.Params += fmt::format("{}* {}, ", prop.GetType().second, prop.GetName());
-					}
-					else
-					{
-						f.Params += fmt::format("{} {}, ", prop.GetType().second, prop.GetName());
-					}
+					Param p;
+					auto type = prop.GetType();
+					p.Type = AddType(type.second);
+					p.TypeIndex = AddPropertyType(prop, type);
+					p.Name = AddString(prop.GetName());
+					p.ArrayDim = prop.GetArrayDim();
+					p.Pointer = p.ArrayDim > 1;
+					p.Offset = prop.GetOffset();
+					p.Size = prop.GetSize() * p.ArrayDim;
+					p.Flags = flags;
+					Params.push_back(p);
 				}
 			}
 
-			if (f.Params.size())
-			{
-				f.Params.erase(f.Params.size() - 2);
-			}
-
-			if (f.CppName.size() == 0)
-			{
-				f.CppName = "void " + fn.GetName();
-			}
-
-			s.Functions.push_back(f);
-
+			f.ParamsEnd = static_cast<uint32_t>(Params.size());
+			Functions.push_back(f);
 		}
 	}
 
+	s.FunctionsEnd = static_cast<uint32_t>(Functions.size());
 	arr.push_back(s);
-
 }
 
-void UE_UPackage::GenerateEnum(UE_UEnum object, std::vector<Enum>& arr)
+void UE_UPackage::GenerateEnum(UE_UEnum object, std::pmr::vector<Enum>& arr)
 {
 	Enum e;
-	e.FullName = object.GetFullName();
-	e.CppName = "enum class " + object.GetName() + " : uint8_t";
+	e.MembersBegin = static_cast<uint32_t>(EnumMembers.size());
 	auto names = object.GetNames();
+	// Names are pairs of FName and int64 value
+	auto valueOffset = (defs.FName.Number + 4u + 7u) & ~(7u);
 	for (auto i = 0ull; i < names.Count; i++)
 	{
 		auto size = (defs.FName.Number + 4u + 8 + 7u) & ~(7u);
 		auto name = UE_FName(names.Data + i * size);
+		EnumValues.push_back(Read<int64_t>(names.Data + i * size + valueOffset, ReadTag::Enum));
 		auto str = name.GetName();
 		auto pos = str.find_last_of(':');
 		if (pos != std::string::npos)
@@ -761,40 +903,81 @@ void UE_UPackage::GenerateEnum(UE_UEnum object, std::vector<Enum>& arr)
 			str = str.substr(pos + 1);
 		}
 
-		e.Members.push_back(str);
+		EnumMembers.push_back(AddString(str));
 	}
+	e.MembersEnd = static_cast<uint32_t>(EnumMembers.size());
 
-	if (e.Members.size())
+	if (e.MembersEnd != e.MembersBegin)
 	{
+		e.FullName = AddString(object.GetFullName());
+		e.Name = AddString(object.GetName());
 		arr.push_back(e);
 	}
 }
 
-void UE_UPackage::SaveStruct(std::vector<Struct>& arr, File file)
+void UE_UPackage::RenderStruct(const std::pmr::vector<Struct>& arr, WriteBuffer& buf) const
 {
 	for (auto& s : arr)
 	{
-		fmt::print(file, "// {}\n// Size: {:#04x} (Inherited: {:#04x})\n{} {{", s.FullName, s.Size, s.Inherited, s.CppName);
-		for (auto& m : s.Members)
+		FormatTo(buf, "// {}\n// Size: {:#04x} (Inherited: {:#04x})\nstruct {}", s.FullName, s.Size, s.Inherited, s.CppName);
+		if (s.SuperName.size()) { FormatTo(buf, " : {}", s.SuperName); }
+		FormatTo(buf, " {{");
+		for (auto i = s.MembersBegin; i < s.MembersEnd; i++)
 		{
-			fmt::print(file, "\n\t{}; // {:#04x}({:#04x})", m.Name, m.Offset, m.Size);
+			auto& m = Members[i];
+			switch (m.Kind)
+			{
+			case MemberKind::Field:
+			{
+				FormatTo(buf, "\n\t{} {}", m.Type, m.Name);
+				if (m.ArrayDim > 1) { FormatTo(buf, "[{:#0x}]", m.ArrayDim); }
+				break;
+			}
+			case MemberKind::BitField: { FormatTo(buf, "\n\t{} {} : {}", m.Type, m.Name, m.BitSize); break; }
+			case MemberKind::Padding: { FormatTo(buf, "\n\tchar UnknownData_{:0X}[{:#0x}]", m.Offset, m.Size); break; }
+			case MemberKind::BitPadding: { FormatTo(buf, "\n\tchar UnknownData_{:0X}_{} : {}", m.Offset, m.BitOffset, m.BitSize); break; }
+			}
+			FormatTo(buf, "; // {:#04x}({:#04x})", m.Offset, m.Size);
 		}
-		if (s.Functions.size())
+		if (s.FunctionsEnd != s.FunctionsBegin)
 		{
-			fwrite("\n", 1, 1, file);
-			for (auto& f : s.Functions)
+			buf.push_back('\n');
+			for (auto i = s.FunctionsBegin; i < s.FunctionsEnd; i++)
 			{
-				auto relative_ptr = f.FuncPtr - this->ModuleBase;
-				fmt::print(file, "\n\t{}({}); // {} // {} // @ game+{:#08x}", f.CppName, f.Params, f.FullName, f.FlagsString, relative_ptr);
+				auto& f = Functions[i];
+				FormatTo(buf, "\n\t{} {}(", f.ReturnType.size() ? f.ReturnType : "void", f.Name);
+				for (auto j = f.ParamsBegin; j < f.ParamsEnd; j++)
+				{
+					auto& p = Params[j];
+					FormatTo(buf, "{}{}{} {}", j == f.ParamsBegin ? "" : ", ", p.Type, p.Pointer ? "*" : "", p.Name);
+				}
+				FormatTo(buf, "); // {} // ", f.FullName);
+				UE_UFunction::AppendFlags(buf, static_cast<UEFunctionFlags>(f.Flags));
+				FormatTo(buf, " // @ game+{:#08x}", f.FuncPtr - this->ModuleBase);
 			}
 		}
 
-		fmt::print(file, "\n}};\n\n");
+		FormatTo(buf, "\n}};\n\n");
+	}
+}
+
+void UE_UPackage::RenderEnum(const std::pmr::vector<Enum>& arr, WriteBuffer& buf) const
+{
+	for (auto& e : arr)
+	{
+		FormatTo(buf, "// {}\nenum class {} : uint8_t {{", e.FullName, e.Name);
+		for (auto i = e.MembersBegin; i < e.MembersEnd; i++)
+		{
+			FormatTo(buf, "\n\t{},", EnumMembers[i]);
+		}
+		FormatTo(buf, "\n}};\n\n");
 	}
 }
 
 void UE_UPackage::Process(size_t ModuleBase)
 {
+	TraceScope trace("Process");
+	if (trace) { trace.Detail(GetObject().GetName()); }
 	this->ModuleBase = ModuleBase;
 	auto& objects = Package->second;
 	for (auto& object : objects)
@@ -814,7 +997,7 @@ void UE_UPackage::Process(size_t ModuleBase)
 	}
 }
 
-bool UE_UPackage::Save(const fs::path& dir)
+bool UE_UPackage::Render(const fs::path& dir, std::vector<FileBuffer>& files) const
 {
 	if (!(Classes.size() || Structures.size() || Enums.size()))
 	{
@@ -822,42 +1005,70 @@ bool UE_UPackage::Save(const fs::path& dir)
 	}
 
 	std::string packageName = this->GetObject().GetName();
+	TraceScope trace("Render");
+	if (trace) { trace.Detail(packageName); }
 
+	// Every file is rendered in memory and written with a single call
 	if (Classes.size())
 	{
-		File file(dir / (packageName + "_classes.h"), "w");
-		if (!file) { return false; }
-		SaveStruct(Classes, file);
+		auto& file = files.emplace_back();
+		file.Path = dir / (packageName + "_classes.h");
+		RenderStruct(Classes, file.Data);
 	}
 
+	if (Structures.size() || Enums.size())
 	{
-		if (Structures.size() || Enums.size())
-		{
-			File file(dir / (packageName + "_struct.h"), "w");
-			if (!file) { return false; }
+		auto& file = files.emplace_back();
+		file.Path = dir / (packageName + "_struct.h");
+		RenderEnum(Enums, file.Data);
+		RenderStruct(Structures, file.Data);
+	}
+
+	return true;
+}
+
+void UE_UPackage::Export(ReflectionBuilder& builder) const
+{
+	auto package = GetObject().GetName();
+	std::vector<uint32_t> types(PropertyTypes.size());
+	auto type = [&types](uint32_t index) { return index < types.size() ? types[index] : ReflectionNone; };
+	for (size_t i = 0; i < PropertyTypes.size(); i++)
+	{
+		auto& t = PropertyTypes[i];
+		types[i] = builder.AddType(static_cast<uint8_t>(t.Kind), t.Text, t.RefHash, type(t.Inner), type(t.Value));
+	}
 
-			if (Enums.size())
+	auto add = [this, &builder, &package, &type](const std::pmr::vector<Struct>& arr, bool isClass)
+	{
+		for (auto& s : arr)
+		{
+			builder.AddStruct(s.FullName, s.CppName, package, s.SuperName, s.SuperHash, s.Size, s.Inherited, isClass);
+			for (auto i = s.MembersBegin; i < s.MembersEnd; i++)
 			{
-				for (auto& e : Enums)
-				{
-					fmt::print(file, "// {}\n{} {{", e.FullName, e.CppName);
-					for (auto& m : e.Members)
-					{
-						fmt::print(file, "\n\t{},", m);
-					}
-					fmt::print(file, "\n}};\n\n");
-				}
+				auto& m = Members[i];
+				if (m.Kind != MemberKind::Field && m.Kind != MemberKind::BitField) { continue; }
+				builder.AddMember(m.Name, type(m.TypeIndex), m.Offset, m.Size, m.ArrayDim, m.BitOffset, m.BitSize, m.Flags);
 			}
-
-			if (Structures.size())
+			for (auto i = s.FunctionsBegin; i < s.FunctionsEnd; i++)
 			{
-				SaveStruct(Structures, file);
+				auto& f = Functions[i];
+				builder.AddFunction(f.FullName, f.Name, f.Flags, type(f.ReturnTypeIndex), f.FuncPtr ? f.FuncPtr - ModuleBase : 0);
+				for (auto j = f.ParamsBegin; j < f.ParamsEnd; j++)
+				{
+					auto& p = Params[j];
+					builder.AddParam(p.Name, type(p.TypeIndex), p.Offset, p.Size, p.ArrayDim, p.Flags);
+				}
 			}
 		}
-		
-	}
+	};
+	add(Classes, true);
+	add(Structures, false);
 
-	return true;
+	for (auto& e : Enums)
+	{
+		builder.AddEnum(e.FullName, e.Name, package);
+		for (auto i = e.MembersBegin; i < e.MembersEnd; i++) { builder.AddValue(EnumMembers[i], EnumValues[i]); }
+	}
 }
 
 UE_UObject UE_UPackage::GetObject() const
@@ -1,8 +1,12 @@
 #pragma once
-#include "Generic.h"
+#include "generic.h"
 #include <unordered_map>
 #include <vector>
 #include <filesystem>
+#include <memory_resource>
+#include <optional>
+#include "writer.h"
+#include "reflection.h"
 
 namespace fs = std::filesystem;
 
@@ -18,6 +22,13 @@ public:
 	operator FILE* () { return file; }
 };
 
+// Contents of a generated file, rendered in memory and handed to the writer
+struct FileBuffer
+{
+	fs::path Path;
+	WriteBuffer Data;
+};
+
 // Wrapper for array unit in global names array
 class UE_FNameEntry 
 {
@@ -48,6 +59,7 @@ public:
 
 class UE_UClass;
 class UE_FField;
+class ReflectionBuilder;
 
 class UE_UObject 
 {
@@ -149,6 +161,8 @@ public:
 	UEFunctionFlags GetFunctionFlags() const;
 	size_t GetFunctionPtr() const;
 	std::string GetFlagsStringified(UEFunctionFlags flags) const;
+	// Appends '|' separated flag names to the buffer
+	static void AppendFlags(WriteBuffer& buf, UEFunctionFlags flags);
 };
 
 class UE_UScriptStruct : public UE_UStruct
@@ -180,6 +194,7 @@ protected:
 public:
 	UE_FFieldClass(byte* object) : object(object) {};
 	UE_FFieldClass() : object(nullptr) {};
+	void* GetAddress() const { return object; }
 	std::string GetName() const;
 };
 
@@ -191,7 +206,9 @@ public:
 	UE_FField(byte* object) : object(object) {}
 	UE_FField() : object(nullptr) {}
 	operator bool() const { return object != nullptr; }
+	void* GetAddress() const { return object; }
 	UE_FField GetNext() const;
+	UE_FFieldClass GetClass() const;
 	std::string GetName() const;
 
 	template<typename Base>
@@ -324,6 +341,21 @@ public:
 	std::string GetType() const;
 };
 
+/*
+* Classes that objects are tested against, CoreUObject classes are found in one pass over the objects when one of them is needed first.
+* 'Property' is gone since UE 4.25 and 'Engine.Actor' may be far into the objects, so both are found separately on first use.
+* Every thread has its own, helpers of a dump get them resolved from the thread that started them, see context.h.
+*/
+struct CoreClasses
+{
+	bool Resolved = false;
+	UE_UClass Object, Field, Struct, Function, ScriptStruct, Class, Enum;
+	std::optional<UE_UClass> Property, Actor;
+};
+extern thread_local CoreClasses Classes;
+const CoreClasses& GetClasses();
+UE_UClass GetActorClass();
+
 template<typename T>
 bool UE_UObject::IsA() const
 {
@@ -344,51 +376,117 @@ bool UE_UObject::IsA() const
 class UE_UPackage
 {
 private:
+	enum class MemberKind : uint8_t
+	{
+		Field,
+		BitField,
+		Padding,
+		BitPadding
+	};
 	struct Member
 	{
-		std::string Name;
 		int32_t Offset = 0;
 		int32_t Size = 0;
+		std::string_view Type;
+		std::string_view Name;
+		int32_t ArrayDim = 1;
+		uint8_t BitOffset = 0;
+		uint8_t BitSize = 0;
+		MemberKind Kind = MemberKind::Field;
+		// Index of 'PropertyTypes' and EPropertyFlags, only for the reflection database
+		uint32_t TypeIndex = ReflectionNone;
+		uint64_t Flags = 0;
+	};
+	struct Param
+	{
+		std::string_view Type;
+		std::string_view Name;
+		bool Pointer = false;
+		uint32_t TypeIndex = ReflectionNone;
+		int32_t Offset = 0;
+		int32_t Size = 0;
+		int32_t ArrayDim = 1;
+		uint64_t Flags = 0;
 	};
 	struct Function
 	{
-		std::string FullName;
-		std::string CppName;
-		std::string Params;
-		std::string FlagsString;
-		uint32_t Flags;
-		size_t FuncPtr;
+		std::string_view FullName;
+		std::string_view ReturnType;
+		std::string_view Name;
+		uint32_t ReturnTypeIndex = ReflectionNone;
+		uint32_t ParamsBegin = 0;
+		uint32_t ParamsEnd = 0;
+		uint32_t Flags = 0;
+		size_t FuncPtr = 0;
+	};
+	// Type of a property with what it references, inner types come before the types that contain them
+	struct PropertyTypeRef
+	{
+		PropertyType Kind = PropertyType::Unknown;
+		std::string_view Text;
+		// 'ReflectionHash' of the full name of the referenced struct, class or enum
+		uint64_t RefHash = 0;
+		uint32_t Inner = ReflectionNone;
+		uint32_t Value = ReflectionNone;
 	};
 	struct Struct
 	{
-		std::string FullName;
-		std::string CppName;
+		std::string_view FullName;
+		std::string_view CppName;
+		std::string_view SuperName;
+		// 'ReflectionHash' of the super's full name, 0 without a super
+		uint64_t SuperHash = 0;
 		int32_t Inherited = 0;
 		int32_t Size = 0;
-		std::vector<Member> Members;
-		std::vector<Function> Functions;
+		uint32_t MembersBegin = 0;
+		uint32_t MembersEnd = 0;
+		uint32_t FunctionsBegin = 0;
+		uint32_t FunctionsEnd = 0;
 	};
 	struct Enum
 	{
-		std::string FullName;
-		std::string CppName;
-		std::vector<std::string> Members;
+		std::string_view FullName;
+		std::string_view Name;
+		uint32_t MembersBegin = 0;
+		uint32_t MembersEnd = 0;
 	};
 private:
+	// Bump arena that backs every record and string of the package, it's released at once when the package is destroyed
+	std::pmr::monotonic_buffer_resource Arena;
 	std::pair<byte* const, std::vector<UE_UObject>>* Package;
-	std::vector<Struct> Classes;
-	std::vector<Struct> Structures;
-	std::vector<Enum> Enums;
+	std::pmr::vector<Struct> Classes{ &Arena };
+	std::pmr::vector<Struct> Structures{ &Arena };
+	std::pmr::vector<Enum> Enums{ &Arena };
+	// Records of all structs and enums are stored flat, structs reference them by index range
+	std::pmr::vector<Member> Members{ &Arena };
+	std::pmr::vector<Function> Functions{ &Arena };
+	std::pmr::vector<Param> Params{ &Arena };
+	std::pmr::vector<std::string_view> EnumMembers{ &Arena };
+	std::pmr::vector<int64_t> EnumValues{ &Arena };
+	// Types are interned since most of them repeat
+	std::pmr::unordered_map<std::string_view, std::string_view> Types{ &Arena };
+	std::pmr::vector<PropertyTypeRef> PropertyTypes{ &Arena };
+	// Interned by the text of the type, which names what it references
+	std::pmr::unordered_map<std::string_view, uint32_t> PropertyTypeIds{ &Arena };
 	size_t ModuleBase;
 private:
-	static void GenerateBitPadding(std::vector<Member>& members, int32_t offset, int16_t bitOffset, int16_t size);
-	static void GeneratePadding(std::vector<Member>& members, int32_t& minOffset, int32_t& bitOffset, int32_t maxOffset);
-	static void GenerateStruct(UE_UStruct object, std::vector<Struct>& arr);
-	static void GenerateEnum(UE_UEnum object, std::vector<Enum>& arr);
-	void SaveStruct(std::vector<Struct>& arr, File file);
+	// Gets per-thread pool that recycles arena blocks between packages
+	static std::pmr::memory_resource* GetArenaUpstream();
+	std::string_view AddString(std::string_view str);
+	std::string_view AddType(std::string_view type);
+	uint32_t AddPropertyType(UE_FProperty prop, const std::pair<PropertyType, std::string>& type, int depth = 0);
+	void GenerateBitPadding(int32_t offset, int32_t bitOffset, int32_t size);
+	void GeneratePadding(int32_t& minOffset, int32_t& bitOffset, int32_t maxOffset);
+	void GenerateStruct(UE_UStruct object, std::pmr::vector<Struct>& arr);
+	void GenerateEnum(UE_UEnum object, std::pmr::vector<Enum>& arr);
+	void RenderStruct(const std::pmr::vector<Struct>& arr, WriteBuffer& buf) const;
+	void RenderEnum(const std::pmr::vector<Enum>& arr, WriteBuffer& buf) const;
 public:
-	UE_UPackage(std::pair<byte* const, std::vector<UE_UObject>>& package) : Package(&package) {};
+	UE_UPackage(std::pair<byte* const, std::vector<UE_UObject>>& package) : Arena(GetArenaUpstream()), Package(&package) {};
 	void Process(size_t ModuleBase);
-	bool Save(const fs::path& dir);
+	// Renders package headers into 'files', returns false if the package has nothing to save
+	bool Render(const fs::path& dir, std::vector<FileBuffer>& files) const;
+	// Adds the generated structs, enums and functions to the reflection database, see database.h
+	void Export(ReflectionBuilder& builder) const;
 	UE_UObject GetObject() const;
 };
\ No newline at end of file
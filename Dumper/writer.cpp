@@ -0,0 +1,126 @@
+#include "writer.h"
+#include "trace.h"
+#include <cstdio>
+#include <utility>
+
+Writer::Writer(size_t capacity, WriteSink sink) : jobs(capacity), sink(std::move(sink))
+{
+	thread = std::thread(&Writer::Run, this);
+}
+
+void Writer::Run()
+{
+	TraceThread("Writer");
+	Job job;
+	while (jobs.Pop(job))
+	{
+		TraceScope trace(job.Append ? "Append" : "Write");
+		if (trace) { trace.Detail(job.Path.filename().string()); }
+		if (!Flush(job)) { failed.push_back(job.Path); }
+	}
+	for (auto& [path, file] : streams) { if (file) { fclose(file); } }
+	streams.clear();
+	if (archive && !archive->Close()) { failed.push_back(archivePath); }
+}
+
+static FILE* Open(const fs::path& path, const char* mode = "w")
+{
+	FILE* file = nullptr;
+	fopen_s(&file, path.string().c_str(), mode);
+	// Data is already buffered, so the CRT buffer would only add a copy
+	if (file) { setvbuf(file, nullptr, _IONBF, 0); }
+	return file;
+}
+
+FILE* Writer::Stream(const fs::path& path)
+{
+	auto [it, inserted] = streams.try_emplace(path.string(), nullptr);
+	if (inserted) { it->second = Open(path); }
+	return it->second;
+}
+
+bool Writer::Flush(Job& job)
+{
+	if (sink) { return sink(job.Path, job.Data.data(), job.Data.size(), job.Append); }
+
+	auto write = [&job](FILE* file) { return fwrite(job.Data.data(), 1, job.Data.size(), file) == job.Data.size(); };
+
+	// Text mode would turn every 0x0A byte into CRLF on Windows
+	if (job.Binary)
+	{
+		auto file = Open(job.Path, "wb");
+		if (!file) { return false; }
+		bool written = write(file);
+		fclose(file);
+		return written;
+	}
+
+	// Stream that failed to open is reported only once
+	if (job.Append)
+	{
+		bool opened = streams.contains(job.Path.string());
+		auto file = Stream(job.Path);
+		return file ? write(file) : opened;
+	}
+
+	if (amalgamation.has_filename())
+	{
+		bool opened = streams.contains(amalgamation.string());
+		auto file = Stream(amalgamation);
+		auto banner = fmt::format("// {}\n\n", job.Path.filename().string());
+		bool written = file && fwrite(banner.data(), 1, banner.size(), file) == banner.size() && write(file);
+		if (!written && (file || !opened)) { failed.push_back(amalgamation); }
+	}
+
+	if (archive)
+	{
+		return archive->Add(job.Path.lexically_relative(root).generic_string(), job.Data.data(), job.Data.size());
+	}
+
+	auto file = Open(job.Path);
+	if (!file) { return false; }
+	bool written = write(file);
+	fclose(file);
+	return written;
+}
+
+bool Writer::OpenArchive(const fs::path& path, const fs::path& root)
+{
+	archive = std::make_unique<ArchiveWriter>(path);
+	archivePath = path;
+	this->root = root;
+	return *archive;
+}
+
+void Writer::Write(fs::path path, WriteBuffer data)
+{
+	jobs.Push({ std::move(path), std::move(data), false });
+}
+
+void Writer::WriteBinary(fs::path path, WriteBuffer data)
+{
+	jobs.Push({ std::move(path), std::move(data), false, true });
+}
+
+void Writer::Append(fs::path path, WriteBuffer data)
+{
+	jobs.Push({ std::move(path), std::move(data), true });
+}
+
+std::vector<fs::path> Writer::Close()
+{
+	if (!closed)
+	{
+		closed = true;
+		jobs.Close();
+		thread.join();
+	}
+	return failed;
+}
+
+void WriteStream::Flush()
+{
+	// Full buffer is swapped for an empty one, so the moved-from buffer is never used again
+	writer.Append(path, std::exchange(buf, WriteBuffer{}));
+	buf.reserve(WriteChunkSize);
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "queue.h"
+#include "archive.h"
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <fmt/format.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Allocates storage on page boundary, so buffers are handed to the OS as whole pages
+template<typename T>
+struct PageAllocator
+{
+	using value_type = T;
+	static constexpr size_t Alignment = 4096;
+	PageAllocator() = default;
+	template<typename U>
+	PageAllocator(const PageAllocator<U>&) {}
+	T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment))); }
+	void deallocate(T* ptr, size_t) { ::operator delete(ptr, std::align_val_t(Alignment)); }
+	bool operator==(const PageAllocator&) const { return true; }
+	bool operator!=(const PageAllocator&) const { return false; }
+};
+
+using WriteBuffer = fmt::basic_memory_buffer<char, 1, PageAllocator<char>>;
+
+// 'fmt::format_to' only accepts memory buffers with the default allocator
+template<typename S, typename... Args>
+void FormatTo(WriteBuffer& buf, const S& format, const Args&... args)
+{
+	fmt::vformat_to(buf, fmt::to_string_view(format), fmt::make_format_args(args...));
+}
+
+// Size at which streamed text is handed over to the writer thread
+constexpr size_t WriteChunkSize = 4 * 1024 * 1024;
+
+/*
+* Receives files instead of the file system, it's only called on the writer thread.
+* 'append' is set for chunks of streamed files, returns false if the data couldn't be stored.
+*/
+using WriteSink = std::function<bool(const fs::path& path, const char* data, size_t size, bool append)>;
+
+// Writes files on its own thread, so threads that produce them never wait for the file system
+class Writer
+{
+private:
+	struct Job
+	{
+		fs::path Path;
+		WriteBuffer Data;
+		bool Append = false;
+		// Written as is to its own path, never to the archive or the amalgamated header
+		bool Binary = false;
+	};
+	BlockingQueue<Job> jobs;
+	std::thread thread;
+	// Files that are appended to stay open until the writer is closed, only used by the writer thread
+	std::unordered_map<std::string, FILE*> streams;
+	std::vector<fs::path> failed;
+	bool closed = false;
+	// Whole files go into the archive instead of separate files when it's set
+	std::unique_ptr<ArchiveWriter> archive;
+	fs::path archivePath;
+	fs::path root;
+	// Whole files are also appended to the amalgamated header when it's set
+	fs::path amalgamation;
+	// Takes every job when it's set, archive and amalgamation aren't used then
+	WriteSink sink;
+	void Run();
+	bool Flush(Job& job);
+	FILE* Stream(const fs::path& path);
+public:
+	Writer(size_t capacity = 256, WriteSink sink = {});
+	~Writer() { Close(); }
+	// Creates directories up front, so the writer thread doesn't check them for every file
+	static void Prepare(const fs::path& dir) { fs::create_directories(dir); }
+	// Stores every whole file in one archive, names are relative to 'root', call before anything is queued
+	bool OpenArchive(const fs::path& path, const fs::path& root);
+	// Appends every whole file to one header as well, call before anything is queued
+	void Amalgamate(const fs::path& path) { amalgamation = path; }
+	// Whether whole files only go to their paths, so a file left by an earlier dump can stand in for one that isn't written again
+	bool WritesPlainFiles() const { return !sink && !archive && !amalgamation.has_filename(); }
+	// Queues the whole file, blocks only while the queue is full
+	void Write(fs::path path, WriteBuffer data);
+	// Queues a binary file, e.g. a database of the dump, which stays a plain file next to the archive
+	void WriteBinary(fs::path path, WriteBuffer data);
+	// Queues a chunk that is appended to the file, first chunk of the path truncates it
+	void Append(fs::path path, WriteBuffer data);
+	// Waits until everything is written, returns files that couldn't be written
+	std::vector<fs::path> Close();
+};
+
+// Accumulates formatted text and hands it to the writer in large chunks
+class WriteStream
+{
+private:
+	Writer& writer;
+	fs::path path;
+	WriteBuffer buf;
+	// Hands the full buffer to the writer and starts an empty one
+	void Flush();
+public:
+	WriteStream(Writer& writer, fs::path path) : writer(writer), path(std::move(path)) { buf.reserve(WriteChunkSize); }
+	~WriteStream() { writer.Append(path, std::move(buf)); }
+	template<typename S, typename... Args>
+	void Print(const S& format, const Args&... args)
+	{
+		FormatTo(buf, format, args...);
+		if (buf.size() >= WriteChunkSize) { Flush(); }
+	}
+};
@@ -0,0 +1,143 @@
+#include "api.h"
+#include "../Dumper/dumper.h"
+#include <new>
+
+static_assert(DUMPER_SUCCESS == SUCCESS && DUMPER_FILE_NOT_OPEN == FILE_NOT_OPEN && DUMPER_SNAPSHOT_ERROR == SNAPSHOT_ERROR, "status codes differ from the dumper's");
+static_assert(DUMPER_NAMES == Dumper::Names && DUMPER_OBJECTS == Dumper::Objects && DUMPER_PACKAGES == Dumper::Packages, "parts differ from the dumper's");
+
+struct dumper
+{
+	Dumper Instance;
+};
+
+// Nothing is thrown across the C boundary, allocation failures become DUMPER_FAILED
+template<typename Fn>
+static dumper_status Guard(Fn fn)
+{
+	try { return static_cast<dumper_status>(fn()); }
+	catch (...) { return DUMPER_FAILED; }
+}
+
+// Paths of the API are UTF-8 on every platform
+static fs::path Path(const char* utf8)
+{
+	return utf8 ? fs::path(reinterpret_cast<const char8_t*>(utf8)) : fs::path();
+}
+
+// Handle is created before opening, so the log is set up for messages of the open
+template<typename Fn>
+static dumper_status Open(dumper_log log, void* user, dumper** out, Fn open)
+{
+	if (!out) { return DUMPER_FAILED; }
+	*out = nullptr;
+	auto handle = new (std::nothrow) dumper;
+	if (!handle) { return DUMPER_FAILED; }
+	if (log) { handle->Instance.SetLog([log, user](const std::string& message) { log(user, message.c_str()); }); }
+	auto status = Guard([&]() { return open(handle->Instance); });
+	if (status != DUMPER_SUCCESS) { delete handle; return status; }
+	*out = handle;
+	return status;
+}
+
+const char* dumper_status_message(dumper_status status)
+{
+	return GetStatusMessage(status);
+}
+
+uint32_t dumper_find_window(const char* window_class)
+{
+	return FindGameWindow(window_class ? window_class : "UnrealWindow");
+}
+
+dumper_status dumper_open_process(uint32_t pid, const char* cache_dir, dumper_log log, void* user, dumper** out)
+{
+	return Open(log, user, out, [&](Dumper& instance) { return instance.Open(pid, Path(cache_dir)); });
+}
+
+dumper_status dumper_open_image(const void* image, size_t size, uint64_t base, uint64_t module_base, uint32_t module_size, const char* game, const char* cache_dir, dumper_log log, void* user, dumper** out)
+{
+	if (!image || !game) { return DUMPER_FAILED; }
+	return Open(log, user, out, [&](Dumper& instance)
+	{
+		return instance.Open(static_cast<const uint8_t*>(image), size, base, module_base, module_size, game, Path(cache_dir));
+	});
+}
+
+dumper_status dumper_open_snapshot(const char* path, const char* cache_dir, dumper_log log, void* user, dumper** out)
+{
+	if (!path) { return DUMPER_FAILED; }
+	return Open(log, user, out, [&](Dumper& instance) { return instance.OpenSnapshot(Path(path), Path(cache_dir)); });
+}
+
+void dumper_close(dumper* handle)
+{
+	delete handle;
+}
+
+const char* dumper_game(const dumper* handle)
+{
+	return handle ? handle->Instance.GetGame().c_str() : "";
+}
+
+uint64_t dumper_module_base(const dumper* handle)
+{
+	return handle ? handle->Instance.GetModuleBase() : 0;
+}
+
+dumper_status dumper_enum_names(dumper* handle, dumper_name_callback callback, void* user, size_t* count)
+{
+	if (!handle || !callback) { return DUMPER_FAILED; }
+	return Guard([&]()
+	{
+		auto size = handle->Instance.DumpNames([callback, user](std::string_view name, uint32_t id) { callback(user, id, name.data(), name.size()); });
+		if (count) { *count = size; }
+		return SUCCESS;
+	});
+}
+
+dumper_status dumper_enum_objects(dumper* handle, dumper_object_callback callback, void* user, size_t* count)
+{
+	if (!handle || !callback) { return DUMPER_FAILED; }
+	return Guard([&]()
+	{
+		auto size = handle->Instance.DumpObjects([callback, user](UE_UObject object)
+		{
+			auto name = object.GetFullName();
+			dumper_object info{ object.GetIndex(), reinterpret_cast<uint64_t>(object.GetAddress()), name.c_str() };
+			callback(user, &info);
+		});
+		if (count) { *count = size; }
+		return SUCCESS;
+	});
+}
+
+dumper_status dumper_generate(dumper* handle, uint32_t parts, dumper_sink sink, void* user)
+{
+	if (!handle || !sink) { return DUMPER_FAILED; }
+	return Guard([&]()
+	{
+		Writer writer(256, [sink, user](const fs::path& path, const char* data, size_t size, bool append)
+		{
+			auto name = path.generic_u8string();
+			return sink(user, reinterpret_cast<const char*>(name.c_str()), data, size, append) != 0;
+		});
+		auto status = handle->Instance.Dump(writer, fs::path(), parts);
+		if (writer.Close().size() && status == SUCCESS) { status = FILE_NOT_OPEN; }
+		return status;
+	});
+}
+
+dumper_status dumper_write(dumper* handle, uint32_t parts, const char* dir)
+{
+	if (!handle || !dir) { return DUMPER_FAILED; }
+	return Guard([&]()
+	{
+		auto path = Path(dir);
+		Writer writer;
+		Writer::Prepare(path);
+		if (parts & Dumper::Packages) { Writer::Prepare(path / "DUMP"); }
+		auto status = handle->Instance.Dump(writer, path, parts);
+		if (writer.Close().size() && status == SUCCESS) { status = FILE_NOT_OPEN; }
+		return status;
+	});
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+* C API of the dumper, built as UnrealDumper.dll by Library.vcxproj.
+* A handle stays attached to its target until it's closed, so tools can keep it open and ask for names, objects or the SDK many times.
+* One handle can be open per thread and it's used from the thread that opened it, opening another one on that thread fails with DUMPER_ALREADY_OPEN.
+* Strings are UTF-8, strings passed to callbacks are only valid during the call.
+*/
+
+#ifdef _WIN32
+#ifdef DUMPER_EXPORTS
+#define DUMPER_API __declspec(dllexport)
+#else
+#define DUMPER_API __declspec(dllimport)
+#endif
+#else
+#define DUMPER_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Same values as the dumper's status codes
+typedef enum dumper_status
+{
+	DUMPER_SUCCESS,
+	DUMPER_FAILED,
+	DUMPER_WINDOW_NOT_FOUND,
+	DUMPER_PROCESS_NOT_FOUND,
+	DUMPER_READER_ERROR,
+	DUMPER_CANNOT_GET_PROCNAME,
+	DUMPER_ENGINE_ERROR,
+	DUMPER_MODULE_NOT_FOUND,
+	DUMPER_CANNOT_READ,
+	DUMPER_INVALID_IMAGE,
+	DUMPER_NAMES_NOT_FOUND,
+	DUMPER_OBJECTS_NOT_FOUND,
+	DUMPER_FILE_NOT_OPEN,
+	DUMPER_ZERO_PACKAGES,
+	DUMPER_EXTRACTED,
+	DUMPER_ARCHIVE_ERROR,
+	DUMPER_ALREADY_OPEN,
+	DUMPER_NOT_OPEN,
+	DUMPER_SNAPSHOT_ERROR
+} dumper_status;
+
+// Parts of a dump, combined as flags
+enum
+{
+	DUMPER_NAMES = 1,
+	DUMPER_OBJECTS = 2,
+	DUMPER_PACKAGES = 4,
+	DUMPER_ALL = DUMPER_NAMES | DUMPER_OBJECTS | DUMPER_PACKAGES
+};
+
+typedef struct dumper dumper;
+
+typedef struct dumper_object
+{
+	uint32_t index;
+	uint64_t address;
+	// Class, outers and name, e.g. "Class /Script/Engine.Actor"
+	const char* full_name;
+} dumper_object;
+
+// 'name' isn't null-terminated
+typedef void (*dumper_name_callback)(void* user, uint32_t id, const char* name, size_t size);
+typedef void (*dumper_object_callback)(void* user, const dumper_object* object);
+/*
+* Receives every file of a dump on one thread, 'path' is relative with '/' separators, e.g. "DUMP/Engine_classes.h".
+* 'append' is set for chunks of streamed files like "ObjectsDump.txt", returns 0 if the data couldn't be stored.
+*/
+typedef int (*dumper_sink)(void* user, const char* path, const void* data, size_t size, int append);
+// Receives progress messages, see 'Dumper::Log'
+typedef void (*dumper_log)(void* user, const char* message);
+
+DUMPER_API const char* dumper_status_message(dumper_status status);
+// Finds the process that owns a window of the class, e.g. "UnrealWindow", 0 if there's no such window
+DUMPER_API uint32_t dumper_find_window(const char* window_class);
+
+/*
+* Opening finds the globals and engine offsets of the target, 'out' is set only on success.
+* Offsets found for a build are cached in '<cache_dir>/<game>', nothing is cached if 'cache_dir' is NULL.
+* 'log' may be NULL.
+*/
+DUMPER_API dumper_status dumper_open_process(uint32_t pid, const char* cache_dir, dumper_log log, void* user, dumper** out);
+// 'image' is read in place and has to stay alive until the handle is closed, 'game' selects the engine profile
+DUMPER_API dumper_status dumper_open_image(const void* image, size_t size, uint64_t base, uint64_t module_base, uint32_t module_size, const char* game, const char* cache_dir, dumper_log log, void* user, dumper** out);
+DUMPER_API dumper_status dumper_open_snapshot(const char* path, const char* cache_dir, dumper_log log, void* user, dumper** out);
+DUMPER_API void dumper_close(dumper* handle);
+
+DUMPER_API const char* dumper_game(const dumper* handle);
+DUMPER_API uint64_t dumper_module_base(const dumper* handle);
+
+// 'count' gets the number of items if it's not NULL
+DUMPER_API dumper_status dumper_enum_names(dumper* handle, dumper_name_callback callback, void* user, size_t* count);
+DUMPER_API dumper_status dumper_enum_objects(dumper* handle, dumper_object_callback callback, void* user, size_t* count);
+
+// Generates 'parts' of the dump into the sink, nothing touches the file system
+DUMPER_API dumper_status dumper_generate(dumper* handle, uint32_t parts, dumper_sink sink, void* user);
+// Writes 'parts' of the dump to 'dir' like the executable does
+DUMPER_API dumper_status dumper_write(dumper* handle, uint32_t parts, const char* dir);
+
+#ifdef __cplusplus
+}
+#endif